@@ -0,0 +1,143 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+// microbenchmark of the base64 codec used by pg_sketch_in and pg_sketch_out
+// compares the scalar implementation with the vectorized block codecs
+// build and run from the repository root:
+//   cc -O2 -o base64_bench bench/base64_bench.c && ./base64_bench [size_in_bytes] [iterations]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// static functions of the codec are needed here
+#include "../src/base64.c"
+
+static double now_sec(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// inserts a newline after every 76 chars like text produced by many tools
+static unsigned wrap_lines(const char* src, unsigned srclen, char* dst) {
+  unsigned i, n = 0;
+  for (i = 0; i < srclen; ++i) {
+    dst[n++] = src[i];
+    if (i % 76 == 75) dst[n++] = '\n';
+  }
+  return n;
+}
+
+static void bench(const char* name, b64_block_fn encode_block, b64_block_fn decode_block,
+    const char* bin, unsigned len, const char* wrapped, unsigned wrapped_len, unsigned iterations) {
+  const unsigned enc_len = b64_enc_len(len);
+  char* enc = malloc(enc_len);
+  char* dec = malloc(b64_dec_len(wrapped_len));
+  double start, enc_time, dec_time, dec_wrapped_time;
+  unsigned i;
+
+  start = now_sec();
+  for (i = 0; i < iterations; ++i) b64_encode_with(bin, len, enc, encode_block);
+  enc_time = now_sec() - start;
+
+  start = now_sec();
+  for (i = 0; i < iterations; ++i) {
+    if (b64_decode_with(enc, enc_len, dec, decode_block) != len) { printf("%s: wrong length\n", name); exit(1); }
+  }
+  dec_time = now_sec() - start;
+  if (memcmp(bin, dec, len) != 0) { printf("%s: decoded bytes differ\n", name); exit(1); }
+
+  start = now_sec();
+  for (i = 0; i < iterations; ++i) {
+    if (b64_decode_with(wrapped, wrapped_len, dec, decode_block) != len) { printf("%s: wrong length\n", name); exit(1); }
+  }
+  dec_wrapped_time = now_sec() - start;
+  if (memcmp(bin, dec, len) != 0) { printf("%s: decoded bytes differ\n", name); exit(1); }
+
+  printf("%-8s encode %8.1f MB/s   decode %8.1f MB/s   decode wrapped %8.1f MB/s\n", name,
+    len * (double) iterations / enc_time / 1e6,
+    len * (double) iterations / dec_time / 1e6,
+    len * (double) iterations / dec_wrapped_time / 1e6);
+  free(enc);
+  free(dec);
+}
+
+// every length and alignment of the tail against the scalar codec, with and without whitespace
+static void check(b64_block_fn encode_block, b64_block_fn decode_block) {
+  char bin[300], enc[400], ref[400], text[500], dec[400], dec_ref[400];
+  unsigned len, i, dec_len;
+  for (i = 0; i < sizeof(bin); ++i) bin[i] = rand();
+  for (len = 0; len < sizeof(bin); ++len) {
+    const unsigned enc_len = b64_enc_len(len);
+    b64_encode_with(bin, len, enc, encode_block);
+    b64_encode_with(bin, len, ref, NULL);
+    if (memcmp(enc, ref, enc_len) != 0) { printf("encode mismatch at length %u\n", len); exit(1); }
+    dec_len = b64_decode_with(enc, enc_len, dec, decode_block);
+    if (dec_len != len || memcmp(dec, bin, len) != 0) { printf("decode mismatch at length %u\n", len); exit(1); }
+    // no padding
+    dec_len = b64_decode_with(enc, enc_len - (enc_len - (len * 4 + 2) / 3), dec, decode_block);
+    if (dec_len != len || memcmp(dec, bin, len) != 0) { printf("unpadded decode mismatch at length %u\n", len); exit(1); }
+    // random whitespace and invalid chars
+    {
+      unsigned n = 0;
+      for (i = 0; i < enc_len; ++i) {
+        const int r = rand() % 64;
+        if (r == 0) text[n++] = ' ';
+        else if (r == 1) text[n++] = '\n';
+        else if (r == 2) text[n++] = '\r';
+        text[n++] = (r == 3) ? '*' : enc[i];
+      }
+      dec_len = b64_decode_with(text, n, dec, decode_block);
+      if (dec_len != b64_decode_with(text, n, dec_ref, NULL) || memcmp(dec, dec_ref, dec_len) != 0 || dec_len > b64_dec_len(n)) {
+        printf("decode with noise mismatch at length %u\n", len);
+        exit(1);
+      }
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  const unsigned len = argc > 1 ? atoi(argv[1]) : 4 << 20;
+  const unsigned iterations = argc > 2 ? atoi(argv[2]) : 50;
+  char* bin = malloc(len);
+  char* enc = malloc(b64_enc_len(len));
+  char* wrapped = malloc(b64_enc_len(len) * 2);
+  unsigned i, wrapped_len;
+
+  for (i = 0; i < len; ++i) bin[i] = rand();
+  b64_encode_with(bin, len, enc, NULL);
+  wrapped_len = wrap_lines(enc, b64_enc_len(len), wrapped);
+
+  bench("scalar", NULL, NULL, bin, len, wrapped, wrapped_len, iterations);
+#ifdef B64_X86_DISPATCH
+  if (__builtin_cpu_supports("sse4.1")) {
+    check(b64_encode_block_sse, b64_decode_block_sse);
+    bench("sse4.1", b64_encode_block_sse, b64_decode_block_sse, bin, len, wrapped, wrapped_len, iterations);
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    check(b64_encode_block_avx2, b64_decode_block_avx2);
+    bench("avx2", b64_encode_block_avx2, b64_decode_block_avx2, bin, len, wrapped, wrapped_len, iterations);
+  }
+#endif
+  free(bin);
+  free(enc);
+  free(wrapped);
+  return 0;
+}
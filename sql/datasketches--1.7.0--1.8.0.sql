@@ -0,0 +1,1429 @@
+-- Licensed to the Apache Software Foundation (ASF) under one
+-- or more contributor license agreements.  See the NOTICE file
+-- distributed with this work for additional information
+-- regarding copyright ownership.  The ASF licenses this file
+-- to you under the Apache License, Version 2.0 (the
+-- "License"); you may not use this file except in compliance
+-- with the License.  You may obtain a copy of the License at
+--
+--   http://www.apache.org/licenses/LICENSE-2.0
+--
+-- Unless required by applicable law or agreed to in writing,
+-- software distributed under the License is distributed on an
+-- "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+-- KIND, either express or implied.  See the License for the
+-- specific language governing permissions and limitations
+-- under the License.
+
+-- binary send and receive functions (ALTER TYPE ... SET requires PostgreSQL 13 or later)
+
+CREATE OR REPLACE FUNCTION aod_sketch_recv(internal) RETURNS aod_sketch
+     AS '$libdir/datasketches', 'pg_sketch_recv'
+     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION aod_sketch_send(aod_sketch) RETURNS bytea
+     AS '$libdir/datasketches', 'pg_sketch_send'
+     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+ALTER TYPE aod_sketch SET (
+    RECEIVE = aod_sketch_recv,
+    SEND = aod_sketch_send
+);
+
+CREATE OR REPLACE FUNCTION cpc_sketch_recv(internal) RETURNS cpc_sketch
+     AS '$libdir/datasketches', 'pg_sketch_recv'
+     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION cpc_sketch_send(cpc_sketch) RETURNS bytea
+     AS '$libdir/datasketches', 'pg_sketch_send'
+     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+ALTER TYPE cpc_sketch SET (
+    RECEIVE = cpc_sketch_recv,
+    SEND = cpc_sketch_send
+);
+
+CREATE OR REPLACE FUNCTION frequent_strings_sketch_recv(internal) RETURNS frequent_strings_sketch
+     AS '$libdir/datasketches', 'pg_sketch_recv'
+     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION frequent_strings_sketch_send(frequent_strings_sketch) RETURNS bytea
+     AS '$libdir/datasketches', 'pg_sketch_send'
+     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+ALTER TYPE frequent_strings_sketch SET (
+    RECEIVE = frequent_strings_sketch_recv,
+    SEND = frequent_strings_sketch_send
+);
+
+CREATE OR REPLACE FUNCTION hll_sketch_recv(internal) RETURNS hll_sketch
+     AS '$libdir/datasketches', 'pg_sketch_recv'
+     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION hll_sketch_send(hll_sketch) RETURNS bytea
+     AS '$libdir/datasketches', 'pg_sketch_send'
+     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+ALTER TYPE hll_sketch SET (
+    RECEIVE = hll_sketch_recv,
+    SEND = hll_sketch_send
+);
+
+CREATE OR REPLACE FUNCTION kll_double_sketch_recv(internal) RETURNS kll_double_sketch
+     AS '$libdir/datasketches', 'pg_sketch_recv'
+     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_double_sketch_send(kll_double_sketch) RETURNS bytea
+     AS '$libdir/datasketches', 'pg_sketch_send'
+     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+ALTER TYPE kll_double_sketch SET (
+    RECEIVE = kll_double_sketch_recv,
+    SEND = kll_double_sketch_send
+);
+
+CREATE OR REPLACE FUNCTION kll_float_sketch_recv(internal) RETURNS kll_float_sketch
+     AS '$libdir/datasketches', 'pg_sketch_recv'
+     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_float_sketch_send(kll_float_sketch) RETURNS bytea
+     AS '$libdir/datasketches', 'pg_sketch_send'
+     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+ALTER TYPE kll_float_sketch SET (
+    RECEIVE = kll_float_sketch_recv,
+    SEND = kll_float_sketch_send
+);
+
+CREATE OR REPLACE FUNCTION quantiles_double_sketch_recv(internal) RETURNS quantiles_double_sketch
+     AS '$libdir/datasketches', 'pg_sketch_recv'
+     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION quantiles_double_sketch_send(quantiles_double_sketch) RETURNS bytea
+     AS '$libdir/datasketches', 'pg_sketch_send'
+     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+ALTER TYPE quantiles_double_sketch SET (
+    RECEIVE = quantiles_double_sketch_recv,
+    SEND = quantiles_double_sketch_send
+);
+
+CREATE OR REPLACE FUNCTION req_float_sketch_recv(internal) RETURNS req_float_sketch
+     AS '$libdir/datasketches', 'pg_sketch_recv'
+     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION req_float_sketch_send(req_float_sketch) RETURNS bytea
+     AS '$libdir/datasketches', 'pg_sketch_send'
+     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+ALTER TYPE req_float_sketch SET (
+    RECEIVE = req_float_sketch_recv,
+    SEND = req_float_sketch_send
+);
+
+CREATE OR REPLACE FUNCTION theta_sketch_recv(internal) RETURNS theta_sketch
+    AS '$libdir/datasketches', 'pg_sketch_recv'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_send(theta_sketch) RETURNS bytea
+    AS '$libdir/datasketches', 'pg_sketch_send'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+ALTER TYPE theta_sketch SET (
+    RECEIVE = theta_sketch_recv,
+    SEND = theta_sketch_send
+);
+
+-- aggregates that return quantiles directly instead of a sketch
+
+CREATE OR REPLACE FUNCTION kll_float_sketch_approx_agg(internal, real, double precision) RETURNS internal
+    AS '$libdir/datasketches', 'pg_kll_float_sketch_approx_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_float_sketch_approx_agg(internal, real, double precision, int) RETURNS internal
+    AS '$libdir/datasketches', 'pg_kll_float_sketch_approx_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_float_sketch_approx_agg(internal, real, double precision[]) RETURNS internal
+    AS '$libdir/datasketches', 'pg_kll_float_sketch_approx_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_float_sketch_approx_agg(internal, real, double precision[], int) RETURNS internal
+    AS '$libdir/datasketches', 'pg_kll_float_sketch_approx_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_float_sketch_approx_serialize(internal) RETURNS bytea
+    AS '$libdir/datasketches', 'pg_kll_float_sketch_approx_serialize'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_float_sketch_approx_deserialize(bytea, internal) RETURNS internal
+    AS '$libdir/datasketches', 'pg_kll_float_sketch_approx_deserialize'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_float_sketch_approx_combine(internal, internal) RETURNS internal
+    AS '$libdir/datasketches', 'pg_kll_float_sketch_approx_combine'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_float_sketch_approx_quantile(internal) RETURNS real
+    AS '$libdir/datasketches', 'pg_kll_float_sketch_approx_quantile'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_float_sketch_approx_quantiles(internal) RETURNS real[]
+    AS '$libdir/datasketches', 'pg_kll_float_sketch_approx_quantiles'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE AGGREGATE kll_float_approx_quantile(real, double precision) (
+    STYPE = internal,
+    SFUNC = kll_float_sketch_approx_agg,
+    COMBINEFUNC = kll_float_sketch_approx_combine,
+    SERIALFUNC = kll_float_sketch_approx_serialize,
+    DESERIALFUNC = kll_float_sketch_approx_deserialize,
+    FINALFUNC = kll_float_sketch_approx_quantile,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE kll_float_approx_quantile(real, double precision, int) (
+    STYPE = internal,
+    SFUNC = kll_float_sketch_approx_agg,
+    COMBINEFUNC = kll_float_sketch_approx_combine,
+    SERIALFUNC = kll_float_sketch_approx_serialize,
+    DESERIALFUNC = kll_float_sketch_approx_deserialize,
+    FINALFUNC = kll_float_sketch_approx_quantile,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE kll_float_approx_quantiles(real, double precision[]) (
+    STYPE = internal,
+    SFUNC = kll_float_sketch_approx_agg,
+    COMBINEFUNC = kll_float_sketch_approx_combine,
+    SERIALFUNC = kll_float_sketch_approx_serialize,
+    DESERIALFUNC = kll_float_sketch_approx_deserialize,
+    FINALFUNC = kll_float_sketch_approx_quantiles,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE kll_float_approx_quantiles(real, double precision[], int) (
+    STYPE = internal,
+    SFUNC = kll_float_sketch_approx_agg,
+    COMBINEFUNC = kll_float_sketch_approx_combine,
+    SERIALFUNC = kll_float_sketch_approx_serialize,
+    DESERIALFUNC = kll_float_sketch_approx_deserialize,
+    FINALFUNC = kll_float_sketch_approx_quantiles,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE FUNCTION kll_double_sketch_approx_agg(internal, double precision, double precision) RETURNS internal
+    AS '$libdir/datasketches', 'pg_kll_double_sketch_approx_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_double_sketch_approx_agg(internal, double precision, double precision, int) RETURNS internal
+    AS '$libdir/datasketches', 'pg_kll_double_sketch_approx_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_double_sketch_approx_agg(internal, double precision, double precision[]) RETURNS internal
+    AS '$libdir/datasketches', 'pg_kll_double_sketch_approx_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_double_sketch_approx_agg(internal, double precision, double precision[], int) RETURNS internal
+    AS '$libdir/datasketches', 'pg_kll_double_sketch_approx_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_double_sketch_approx_serialize(internal) RETURNS bytea
+    AS '$libdir/datasketches', 'pg_kll_double_sketch_approx_serialize'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_double_sketch_approx_deserialize(bytea, internal) RETURNS internal
+    AS '$libdir/datasketches', 'pg_kll_double_sketch_approx_deserialize'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_double_sketch_approx_combine(internal, internal) RETURNS internal
+    AS '$libdir/datasketches', 'pg_kll_double_sketch_approx_combine'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_double_sketch_approx_quantile(internal) RETURNS double precision
+    AS '$libdir/datasketches', 'pg_kll_double_sketch_approx_quantile'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_double_sketch_approx_quantiles(internal) RETURNS double precision[]
+    AS '$libdir/datasketches', 'pg_kll_double_sketch_approx_quantiles'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE AGGREGATE kll_double_approx_quantile(double precision, double precision) (
+    STYPE = internal,
+    SFUNC = kll_double_sketch_approx_agg,
+    COMBINEFUNC = kll_double_sketch_approx_combine,
+    SERIALFUNC = kll_double_sketch_approx_serialize,
+    DESERIALFUNC = kll_double_sketch_approx_deserialize,
+    FINALFUNC = kll_double_sketch_approx_quantile,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE kll_double_approx_quantile(double precision, double precision, int) (
+    STYPE = internal,
+    SFUNC = kll_double_sketch_approx_agg,
+    COMBINEFUNC = kll_double_sketch_approx_combine,
+    SERIALFUNC = kll_double_sketch_approx_serialize,
+    DESERIALFUNC = kll_double_sketch_approx_deserialize,
+    FINALFUNC = kll_double_sketch_approx_quantile,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE kll_double_approx_quantiles(double precision, double precision[]) (
+    STYPE = internal,
+    SFUNC = kll_double_sketch_approx_agg,
+    COMBINEFUNC = kll_double_sketch_approx_combine,
+    SERIALFUNC = kll_double_sketch_approx_serialize,
+    DESERIALFUNC = kll_double_sketch_approx_deserialize,
+    FINALFUNC = kll_double_sketch_approx_quantiles,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE kll_double_approx_quantiles(double precision, double precision[], int) (
+    STYPE = internal,
+    SFUNC = kll_double_sketch_approx_agg,
+    COMBINEFUNC = kll_double_sketch_approx_combine,
+    SERIALFUNC = kll_double_sketch_approx_serialize,
+    DESERIALFUNC = kll_double_sketch_approx_deserialize,
+    FINALFUNC = kll_double_sketch_approx_quantiles,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE FUNCTION req_float_sketch_approx_agg(internal, real, double precision) RETURNS internal
+    AS '$libdir/datasketches', 'pg_req_float_sketch_approx_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION req_float_sketch_approx_agg(internal, real, double precision, int) RETURNS internal
+    AS '$libdir/datasketches', 'pg_req_float_sketch_approx_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION req_float_sketch_approx_agg(internal, real, double precision[]) RETURNS internal
+    AS '$libdir/datasketches', 'pg_req_float_sketch_approx_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION req_float_sketch_approx_agg(internal, real, double precision[], int) RETURNS internal
+    AS '$libdir/datasketches', 'pg_req_float_sketch_approx_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION req_float_sketch_approx_serialize(internal) RETURNS bytea
+    AS '$libdir/datasketches', 'pg_req_float_sketch_approx_serialize'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION req_float_sketch_approx_deserialize(bytea, internal) RETURNS internal
+    AS '$libdir/datasketches', 'pg_req_float_sketch_approx_deserialize'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION req_float_sketch_approx_combine(internal, internal) RETURNS internal
+    AS '$libdir/datasketches', 'pg_req_float_sketch_approx_combine'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION req_float_sketch_approx_quantile(internal) RETURNS real
+    AS '$libdir/datasketches', 'pg_req_float_sketch_approx_quantile'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION req_float_sketch_approx_quantiles(internal) RETURNS real[]
+    AS '$libdir/datasketches', 'pg_req_float_sketch_approx_quantiles'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE AGGREGATE req_float_approx_quantile(real, double precision) (
+    STYPE = internal,
+    SFUNC = req_float_sketch_approx_agg,
+    COMBINEFUNC = req_float_sketch_approx_combine,
+    SERIALFUNC = req_float_sketch_approx_serialize,
+    DESERIALFUNC = req_float_sketch_approx_deserialize,
+    FINALFUNC = req_float_sketch_approx_quantile,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE req_float_approx_quantile(real, double precision, int) (
+    STYPE = internal,
+    SFUNC = req_float_sketch_approx_agg,
+    COMBINEFUNC = req_float_sketch_approx_combine,
+    SERIALFUNC = req_float_sketch_approx_serialize,
+    DESERIALFUNC = req_float_sketch_approx_deserialize,
+    FINALFUNC = req_float_sketch_approx_quantile,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE req_float_approx_quantiles(real, double precision[]) (
+    STYPE = internal,
+    SFUNC = req_float_sketch_approx_agg,
+    COMBINEFUNC = req_float_sketch_approx_combine,
+    SERIALFUNC = req_float_sketch_approx_serialize,
+    DESERIALFUNC = req_float_sketch_approx_deserialize,
+    FINALFUNC = req_float_sketch_approx_quantiles,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE req_float_approx_quantiles(real, double precision[], int) (
+    STYPE = internal,
+    SFUNC = req_float_sketch_approx_agg,
+    COMBINEFUNC = req_float_sketch_approx_combine,
+    SERIALFUNC = req_float_sketch_approx_serialize,
+    DESERIALFUNC = req_float_sketch_approx_deserialize,
+    FINALFUNC = req_float_sketch_approx_quantiles,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE FUNCTION quantiles_double_sketch_approx_agg(internal, double precision, double precision) RETURNS internal
+    AS '$libdir/datasketches', 'pg_quantiles_double_sketch_approx_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION quantiles_double_sketch_approx_agg(internal, double precision, double precision, int) RETURNS internal
+    AS '$libdir/datasketches', 'pg_quantiles_double_sketch_approx_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION quantiles_double_sketch_approx_agg(internal, double precision, double precision[]) RETURNS internal
+    AS '$libdir/datasketches', 'pg_quantiles_double_sketch_approx_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION quantiles_double_sketch_approx_agg(internal, double precision, double precision[], int) RETURNS internal
+    AS '$libdir/datasketches', 'pg_quantiles_double_sketch_approx_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION quantiles_double_sketch_approx_serialize(internal) RETURNS bytea
+    AS '$libdir/datasketches', 'pg_quantiles_double_sketch_approx_serialize'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION quantiles_double_sketch_approx_deserialize(bytea, internal) RETURNS internal
+    AS '$libdir/datasketches', 'pg_quantiles_double_sketch_approx_deserialize'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION quantiles_double_sketch_approx_combine(internal, internal) RETURNS internal
+    AS '$libdir/datasketches', 'pg_quantiles_double_sketch_approx_combine'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION quantiles_double_sketch_approx_quantile(internal) RETURNS double precision
+    AS '$libdir/datasketches', 'pg_quantiles_double_sketch_approx_quantile'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION quantiles_double_sketch_approx_quantiles(internal) RETURNS double precision[]
+    AS '$libdir/datasketches', 'pg_quantiles_double_sketch_approx_quantiles'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE AGGREGATE quantiles_double_approx_quantile(double precision, double precision) (
+    STYPE = internal,
+    SFUNC = quantiles_double_sketch_approx_agg,
+    COMBINEFUNC = quantiles_double_sketch_approx_combine,
+    SERIALFUNC = quantiles_double_sketch_approx_serialize,
+    DESERIALFUNC = quantiles_double_sketch_approx_deserialize,
+    FINALFUNC = quantiles_double_sketch_approx_quantile,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE quantiles_double_approx_quantile(double precision, double precision, int) (
+    STYPE = internal,
+    SFUNC = quantiles_double_sketch_approx_agg,
+    COMBINEFUNC = quantiles_double_sketch_approx_combine,
+    SERIALFUNC = quantiles_double_sketch_approx_serialize,
+    DESERIALFUNC = quantiles_double_sketch_approx_deserialize,
+    FINALFUNC = quantiles_double_sketch_approx_quantile,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE quantiles_double_approx_quantiles(double precision, double precision[]) (
+    STYPE = internal,
+    SFUNC = quantiles_double_sketch_approx_agg,
+    COMBINEFUNC = quantiles_double_sketch_approx_combine,
+    SERIALFUNC = quantiles_double_sketch_approx_serialize,
+    DESERIALFUNC = quantiles_double_sketch_approx_deserialize,
+    FINALFUNC = quantiles_double_sketch_approx_quantiles,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE quantiles_double_approx_quantiles(double precision, double precision[], int) (
+    STYPE = internal,
+    SFUNC = quantiles_double_sketch_approx_agg,
+    COMBINEFUNC = quantiles_double_sketch_approx_combine,
+    SERIALFUNC = quantiles_double_sketch_approx_serialize,
+    DESERIALFUNC = quantiles_double_sketch_approx_deserialize,
+    FINALFUNC = quantiles_double_sketch_approx_quantiles,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+-- union aggregates that return the estimate instead of a sketch
+
+CREATE OR REPLACE AGGREGATE theta_sketch_union_distinct(theta_sketch) (
+    STYPE = internal,
+    SFUNC = theta_sketch_union_agg,
+    COMBINEFUNC = theta_sketch_union_combine,
+    SERIALFUNC = theta_sketch_serialize_state,
+    DESERIALFUNC = theta_sketch_deserialize_state,
+    FINALFUNC = theta_sketch_get_estimate_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE theta_sketch_union_distinct(theta_sketch, int) (
+    STYPE = internal,
+    SFUNC = theta_sketch_union_agg,
+    COMBINEFUNC = theta_sketch_union_combine,
+    SERIALFUNC = theta_sketch_serialize_state,
+    DESERIALFUNC = theta_sketch_deserialize_state,
+    FINALFUNC = theta_sketch_get_estimate_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE cpc_sketch_union_distinct(cpc_sketch) (
+    STYPE = internal,
+    SFUNC = cpc_sketch_union_agg,
+    COMBINEFUNC = cpc_sketch_combine,
+    SERIALFUNC = cpc_sketch_serialize_state,
+    DESERIALFUNC = cpc_sketch_deserialize_state,
+    FINALFUNC = cpc_sketch_get_estimate_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE cpc_sketch_union_distinct(cpc_sketch, int) (
+    STYPE = internal,
+    SFUNC = cpc_sketch_union_agg,
+    COMBINEFUNC = cpc_sketch_combine,
+    SERIALFUNC = cpc_sketch_serialize_state,
+    DESERIALFUNC = cpc_sketch_deserialize_state,
+    FINALFUNC = cpc_sketch_get_estimate_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE hll_sketch_union_distinct(hll_sketch) (
+    STYPE = internal,
+    SFUNC = hll_sketch_union_agg,
+    COMBINEFUNC = hll_sketch_combine,
+    SERIALFUNC = hll_sketch_serialize_state,
+    DESERIALFUNC = hll_sketch_deserialize_state,
+    FINALFUNC = hll_sketch_get_estimate_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE hll_sketch_union_distinct(hll_sketch, int) (
+    STYPE = internal,
+    SFUNC = hll_sketch_union_agg,
+    COMBINEFUNC = hll_sketch_combine,
+    SERIALFUNC = hll_sketch_serialize_state,
+    DESERIALFUNC = hll_sketch_deserialize_state,
+    FINALFUNC = hll_sketch_get_estimate_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+-- final functions that keep the aggregate state, for running aggregates over window frames
+
+CREATE OR REPLACE FUNCTION kll_float_sketch_finalize(internal) RETURNS kll_float_sketch
+    AS '$libdir/datasketches', 'pg_kll_float_sketch_finalize'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_double_sketch_finalize(internal) RETURNS kll_double_sketch
+    AS '$libdir/datasketches', 'pg_kll_double_sketch_finalize'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION req_float_sketch_finalize(internal) RETURNS req_float_sketch
+    AS '$libdir/datasketches', 'pg_req_float_sketch_finalize'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION quantiles_double_sketch_finalize(internal) RETURNS quantiles_double_sketch
+    AS '$libdir/datasketches', 'pg_quantiles_double_sketch_finalize'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE AGGREGATE cpc_sketch_distinct(anyelement) (
+    STYPE = internal,
+    SFUNC = cpc_sketch_build_agg,
+    COMBINEFUNC = cpc_sketch_combine,
+    SERIALFUNC = cpc_sketch_serialize_state,
+    DESERIALFUNC = cpc_sketch_deserialize_state, 
+    FINALFUNC = cpc_sketch_get_estimate_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE cpc_sketch_distinct(anyelement, int) (
+    STYPE = internal,
+    SFUNC = cpc_sketch_build_agg,
+    COMBINEFUNC = cpc_sketch_combine,
+    SERIALFUNC = cpc_sketch_serialize_state,
+    DESERIALFUNC = cpc_sketch_deserialize_state, 
+    FINALFUNC = cpc_sketch_get_estimate_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE cpc_sketch_build(anyelement) (
+    STYPE = internal,
+    SFUNC = cpc_sketch_build_agg,
+    COMBINEFUNC = cpc_sketch_combine,
+    SERIALFUNC = cpc_sketch_serialize_state,
+    DESERIALFUNC = cpc_sketch_deserialize_state, 
+    FINALFUNC = cpc_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE cpc_sketch_build(anyelement, int) (
+    STYPE = internal,
+    SFUNC = cpc_sketch_build_agg,
+    COMBINEFUNC = cpc_sketch_combine,
+    SERIALFUNC = cpc_sketch_serialize_state,
+    DESERIALFUNC = cpc_sketch_deserialize_state, 
+    FINALFUNC = cpc_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE cpc_sketch_union(cpc_sketch) (
+    STYPE = internal,
+    SFUNC = cpc_sketch_union_agg,
+    COMBINEFUNC = cpc_sketch_combine,
+    SERIALFUNC = cpc_sketch_serialize_state,
+    DESERIALFUNC = cpc_sketch_deserialize_state, 
+    FINALFUNC = cpc_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE cpc_sketch_union(cpc_sketch, int) (
+    STYPE = internal,
+    SFUNC = cpc_sketch_union_agg,
+    COMBINEFUNC = cpc_sketch_combine,
+    SERIALFUNC = cpc_sketch_serialize_state,
+    DESERIALFUNC = cpc_sketch_deserialize_state, 
+    FINALFUNC = cpc_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE kll_float_sketch_build(real) (
+    STYPE = internal,
+    SFUNC = kll_float_sketch_build_agg,
+    COMBINEFUNC = kll_float_sketch_combine,
+    SERIALFUNC = kll_float_sketch_serialize,
+    DESERIALFUNC = kll_float_sketch_deserialize,
+    FINALFUNC = kll_float_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE kll_float_sketch_build(real, int) (
+    STYPE = internal,
+    SFUNC = kll_float_sketch_build_agg,
+    COMBINEFUNC = kll_float_sketch_combine,
+    SERIALFUNC = kll_float_sketch_serialize,
+    DESERIALFUNC = kll_float_sketch_deserialize,
+    FINALFUNC = kll_float_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE kll_float_sketch_merge(kll_float_sketch) (
+    STYPE = internal,
+    SFUNC = kll_float_sketch_merge_agg,
+    COMBINEFUNC = kll_float_sketch_combine,
+    SERIALFUNC = kll_float_sketch_serialize,
+    DESERIALFUNC = kll_float_sketch_deserialize,
+    FINALFUNC = kll_float_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE kll_float_sketch_merge(kll_float_sketch, int) (
+    STYPE = internal,
+    SFUNC = kll_float_sketch_merge_agg,
+    COMBINEFUNC = kll_float_sketch_combine,
+    SERIALFUNC = kll_float_sketch_serialize,
+    DESERIALFUNC = kll_float_sketch_deserialize,
+    FINALFUNC = kll_float_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE kll_double_sketch_build(double precision) (
+    STYPE = internal,
+    SFUNC = kll_double_sketch_build_agg,
+    COMBINEFUNC = kll_double_sketch_combine,
+    SERIALFUNC = kll_double_sketch_serialize,
+    DESERIALFUNC = kll_double_sketch_deserialize, 
+    FINALFUNC = kll_double_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE kll_double_sketch_build(double precision, int) (
+    STYPE = internal,
+    SFUNC = kll_double_sketch_build_agg,
+    COMBINEFUNC = kll_double_sketch_combine,
+    SERIALFUNC = kll_double_sketch_serialize,
+    DESERIALFUNC = kll_double_sketch_deserialize, 
+    FINALFUNC = kll_double_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE kll_double_sketch_merge(kll_double_sketch) (
+    STYPE = internal,
+    SFUNC = kll_double_sketch_merge_agg,
+    COMBINEFUNC = kll_double_sketch_combine,
+    SERIALFUNC = kll_double_sketch_serialize,
+    DESERIALFUNC = kll_double_sketch_deserialize, 
+    FINALFUNC = kll_double_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE kll_double_sketch_merge(kll_double_sketch, int) (
+    STYPE = internal,
+    SFUNC = kll_double_sketch_merge_agg,
+    COMBINEFUNC = kll_double_sketch_combine,
+    SERIALFUNC = kll_double_sketch_serialize,
+    DESERIALFUNC = kll_double_sketch_deserialize, 
+    FINALFUNC = kll_double_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE theta_sketch_distinct(anyelement) (
+    STYPE = internal,
+    SFUNC = theta_sketch_build_agg,
+    COMBINEFUNC = theta_sketch_union_combine,
+    SERIALFUNC = theta_sketch_serialize_state,
+    DESERIALFUNC = theta_sketch_deserialize_state, 
+    FINALFUNC = theta_sketch_get_estimate_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE theta_sketch_distinct(anyelement, int) (
+    STYPE = internal,
+    SFUNC = theta_sketch_build_agg,
+    COMBINEFUNC = theta_sketch_union_combine,
+    SERIALFUNC = theta_sketch_serialize_state,
+    DESERIALFUNC = theta_sketch_deserialize_state, 
+    FINALFUNC = theta_sketch_get_estimate_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE theta_sketch_build(anyelement) (
+    STYPE = internal,
+    SFUNC = theta_sketch_build_agg,
+    COMBINEFUNC = theta_sketch_union_combine,
+    SERIALFUNC = theta_sketch_serialize_state,
+    DESERIALFUNC = theta_sketch_deserialize_state, 
+    FINALFUNC = theta_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE theta_sketch_build(anyelement, int) (
+    STYPE = internal,
+    SFUNC = theta_sketch_build_agg,
+    COMBINEFUNC = theta_sketch_union_combine,
+    SERIALFUNC = theta_sketch_serialize_state,
+    DESERIALFUNC = theta_sketch_deserialize_state, 
+    FINALFUNC = theta_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE theta_sketch_build(anyelement, int, real) (
+    STYPE = internal,
+    SFUNC = theta_sketch_build_agg,
+    COMBINEFUNC = theta_sketch_union_combine,
+    SERIALFUNC = theta_sketch_serialize_state,
+    DESERIALFUNC = theta_sketch_deserialize_state, 
+    FINALFUNC = theta_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE theta_sketch_union(theta_sketch) (
+    STYPE = internal,
+    SFUNC = theta_sketch_union_agg,
+    COMBINEFUNC = theta_sketch_union_combine,
+    SERIALFUNC = theta_sketch_serialize_state,
+    DESERIALFUNC = theta_sketch_deserialize_state, 
+    FINALFUNC = theta_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE theta_sketch_union(theta_sketch, int) (
+    STYPE = internal,
+    SFUNC = theta_sketch_union_agg,
+    COMBINEFUNC = theta_sketch_union_combine,
+    SERIALFUNC = theta_sketch_serialize_state,
+    DESERIALFUNC = theta_sketch_deserialize_state, 
+    FINALFUNC = theta_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE theta_sketch_intersection(theta_sketch) (
+    STYPE = internal,
+    SFUNC = theta_sketch_intersection_agg,
+    COMBINEFUNC = theta_sketch_intersection_combine,
+    SERIALFUNC = theta_sketch_serialize_state,
+    DESERIALFUNC = theta_sketch_deserialize_state, 
+    FINALFUNC = theta_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE hll_sketch_distinct(anyelement) (
+    STYPE = internal,
+    SFUNC = hll_sketch_build_agg,
+    COMBINEFUNC = hll_sketch_combine,
+    SERIALFUNC = hll_sketch_serialize_state,
+    DESERIALFUNC = hll_sketch_deserialize_state, 
+    FINALFUNC = hll_sketch_get_estimate_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE hll_sketch_distinct(anyelement, int) (
+    STYPE = internal,
+    SFUNC = hll_sketch_build_agg,
+    COMBINEFUNC = hll_sketch_combine,
+    SERIALFUNC = hll_sketch_serialize_state,
+    DESERIALFUNC = hll_sketch_deserialize_state, 
+    FINALFUNC = hll_sketch_get_estimate_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE hll_sketch_build(anyelement) (
+    STYPE = internal,
+    SFUNC = hll_sketch_build_agg,
+    COMBINEFUNC = hll_sketch_combine,
+    SERIALFUNC = hll_sketch_serialize_state,
+    DESERIALFUNC = hll_sketch_deserialize_state, 
+    FINALFUNC = hll_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE hll_sketch_build(anyelement, int) (
+    STYPE = internal,
+    SFUNC = hll_sketch_build_agg,
+    COMBINEFUNC = hll_sketch_combine,
+    SERIALFUNC = hll_sketch_serialize_state,
+    DESERIALFUNC = hll_sketch_deserialize_state, 
+    FINALFUNC = hll_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE hll_sketch_build(anyelement, int, int) (
+    STYPE = internal,
+    SFUNC = hll_sketch_build_agg,
+    COMBINEFUNC = hll_sketch_combine,
+    SERIALFUNC = hll_sketch_serialize_state,
+    DESERIALFUNC = hll_sketch_deserialize_state, 
+    FINALFUNC = hll_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE hll_sketch_union(hll_sketch) (
+    STYPE = internal,
+    SFUNC = hll_sketch_union_agg,
+    COMBINEFUNC = hll_sketch_combine,
+    SERIALFUNC = hll_sketch_serialize_state,
+    DESERIALFUNC = hll_sketch_deserialize_state, 
+    FINALFUNC = hll_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE hll_sketch_union(hll_sketch, int) (
+    STYPE = internal,
+    SFUNC = hll_sketch_union_agg,
+    COMBINEFUNC = hll_sketch_combine,
+    SERIALFUNC = hll_sketch_serialize_state,
+    DESERIALFUNC = hll_sketch_deserialize_state, 
+    FINALFUNC = hll_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE hll_sketch_union(hll_sketch, int, int) (
+    STYPE = internal,
+    SFUNC = hll_sketch_union_agg,
+    COMBINEFUNC = hll_sketch_combine,
+    SERIALFUNC = hll_sketch_serialize_state,
+    DESERIALFUNC = hll_sketch_deserialize_state, 
+    FINALFUNC = hll_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE req_float_sketch_build(real) (
+    STYPE = internal,
+    SFUNC = req_float_sketch_build_agg,
+    COMBINEFUNC = req_float_sketch_combine,
+    SERIALFUNC = req_float_sketch_serialize,
+    DESERIALFUNC = req_float_sketch_deserialize, 
+    FINALFUNC = req_float_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE req_float_sketch_build(real, int) (
+    STYPE = internal,
+    SFUNC = req_float_sketch_build_agg,
+    COMBINEFUNC = req_float_sketch_combine,
+    SERIALFUNC = req_float_sketch_serialize,
+    DESERIALFUNC = req_float_sketch_deserialize, 
+    FINALFUNC = req_float_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE req_float_sketch_build(real, int, boolean) (
+    STYPE = internal,
+    SFUNC = req_float_sketch_build_agg,
+    COMBINEFUNC = req_float_sketch_combine,
+    SERIALFUNC = req_float_sketch_serialize,
+    DESERIALFUNC = req_float_sketch_deserialize, 
+    FINALFUNC = req_float_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE req_float_sketch_merge(req_float_sketch) (
+    STYPE = internal,
+    SFUNC = req_float_sketch_merge_agg,
+    COMBINEFUNC = req_float_sketch_combine,
+    SERIALFUNC = req_float_sketch_serialize,
+    DESERIALFUNC = req_float_sketch_deserialize, 
+    FINALFUNC = req_float_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE req_float_sketch_merge(req_float_sketch, int) (
+    STYPE = internal,
+    SFUNC = req_float_sketch_merge_agg,
+    COMBINEFUNC = req_float_sketch_combine,
+    SERIALFUNC = req_float_sketch_serialize,
+    DESERIALFUNC = req_float_sketch_deserialize, 
+    FINALFUNC = req_float_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE req_float_sketch_merge(req_float_sketch, int, boolean) (
+    STYPE = internal,
+    SFUNC = req_float_sketch_merge_agg,
+    COMBINEFUNC = req_float_sketch_combine,
+    SERIALFUNC = req_float_sketch_serialize,
+    DESERIALFUNC = req_float_sketch_deserialize, 
+    FINALFUNC = req_float_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE quantiles_double_sketch_build(double precision) (
+    STYPE = internal,
+    SFUNC = quantiles_double_sketch_build_agg,
+    COMBINEFUNC = quantiles_double_sketch_combine,
+    SERIALFUNC = quantiles_double_sketch_serialize,
+    DESERIALFUNC = quantiles_double_sketch_deserialize, 
+    FINALFUNC = quantiles_double_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE quantiles_double_sketch_build(double precision, int) (
+    STYPE = internal,
+    SFUNC = quantiles_double_sketch_build_agg,
+    COMBINEFUNC = quantiles_double_sketch_combine,
+    SERIALFUNC = quantiles_double_sketch_serialize,
+    DESERIALFUNC = quantiles_double_sketch_deserialize, 
+    FINALFUNC = quantiles_double_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE quantiles_double_sketch_merge(quantiles_double_sketch) (
+    STYPE = internal,
+    SFUNC = quantiles_double_sketch_merge_agg,
+    COMBINEFUNC = quantiles_double_sketch_combine,
+    SERIALFUNC = quantiles_double_sketch_serialize,
+    DESERIALFUNC = quantiles_double_sketch_deserialize, 
+    FINALFUNC = quantiles_double_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE quantiles_double_sketch_merge(quantiles_double_sketch, int) (
+    STYPE = internal,
+    SFUNC = quantiles_double_sketch_merge_agg,
+    COMBINEFUNC = quantiles_double_sketch_combine,
+    SERIALFUNC = quantiles_double_sketch_serialize,
+    DESERIALFUNC = quantiles_double_sketch_deserialize, 
+    FINALFUNC = quantiles_double_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+-- moving-aggregate mode of union and merge aggregates over sliding window frames
+
+CREATE OR REPLACE FUNCTION hll_sketch_union_moving_agg(internal, hll_sketch) RETURNS internal
+    AS '$libdir/datasketches', 'pg_hll_sketch_union_moving_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION hll_sketch_union_moving_agg(internal, hll_sketch, int) RETURNS internal
+    AS '$libdir/datasketches', 'pg_hll_sketch_union_moving_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION hll_sketch_union_moving_agg(internal, hll_sketch, int, int) RETURNS internal
+    AS '$libdir/datasketches', 'pg_hll_sketch_union_moving_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION hll_sketch_union_moving_inv(internal, hll_sketch) RETURNS internal
+    AS '$libdir/datasketches', 'pg_hll_sketch_union_moving_inv'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION hll_sketch_union_moving_inv(internal, hll_sketch, int) RETURNS internal
+    AS '$libdir/datasketches', 'pg_hll_sketch_union_moving_inv'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION hll_sketch_union_moving_inv(internal, hll_sketch, int, int) RETURNS internal
+    AS '$libdir/datasketches', 'pg_hll_sketch_union_moving_inv'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION hll_sketch_union_moving_final(internal) RETURNS hll_sketch
+    AS '$libdir/datasketches', 'pg_hll_sketch_union_moving_final'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_union_moving_agg(internal, theta_sketch) RETURNS internal
+    AS '$libdir/datasketches', 'pg_theta_sketch_union_moving_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_union_moving_agg(internal, theta_sketch, int) RETURNS internal
+    AS '$libdir/datasketches', 'pg_theta_sketch_union_moving_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_union_moving_inv(internal, theta_sketch) RETURNS internal
+    AS '$libdir/datasketches', 'pg_theta_sketch_union_moving_inv'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_union_moving_inv(internal, theta_sketch, int) RETURNS internal
+    AS '$libdir/datasketches', 'pg_theta_sketch_union_moving_inv'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_union_moving_final(internal) RETURNS theta_sketch
+    AS '$libdir/datasketches', 'pg_theta_sketch_union_moving_final'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_float_sketch_merge_moving_agg(internal, kll_float_sketch) RETURNS internal
+    AS '$libdir/datasketches', 'pg_kll_float_sketch_merge_moving_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_float_sketch_merge_moving_agg(internal, kll_float_sketch, int) RETURNS internal
+    AS '$libdir/datasketches', 'pg_kll_float_sketch_merge_moving_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_float_sketch_merge_moving_inv(internal, kll_float_sketch) RETURNS internal
+    AS '$libdir/datasketches', 'pg_kll_float_sketch_merge_moving_inv'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_float_sketch_merge_moving_inv(internal, kll_float_sketch, int) RETURNS internal
+    AS '$libdir/datasketches', 'pg_kll_float_sketch_merge_moving_inv'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_float_sketch_merge_moving_final(internal) RETURNS kll_float_sketch
+    AS '$libdir/datasketches', 'pg_kll_float_sketch_merge_moving_final'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE AGGREGATE hll_sketch_union(hll_sketch) (
+    STYPE = internal,
+    SFUNC = hll_sketch_union_agg,
+    COMBINEFUNC = hll_sketch_combine,
+    SERIALFUNC = hll_sketch_serialize_state,
+    DESERIALFUNC = hll_sketch_deserialize_state, 
+    FINALFUNC = hll_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    MSTYPE = internal,
+    MSFUNC = hll_sketch_union_moving_agg,
+    MINVFUNC = hll_sketch_union_moving_inv,
+    MFINALFUNC = hll_sketch_union_moving_final,
+    MFINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE hll_sketch_union(hll_sketch, int) (
+    STYPE = internal,
+    SFUNC = hll_sketch_union_agg,
+    COMBINEFUNC = hll_sketch_combine,
+    SERIALFUNC = hll_sketch_serialize_state,
+    DESERIALFUNC = hll_sketch_deserialize_state, 
+    FINALFUNC = hll_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    MSTYPE = internal,
+    MSFUNC = hll_sketch_union_moving_agg,
+    MINVFUNC = hll_sketch_union_moving_inv,
+    MFINALFUNC = hll_sketch_union_moving_final,
+    MFINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE hll_sketch_union(hll_sketch, int, int) (
+    STYPE = internal,
+    SFUNC = hll_sketch_union_agg,
+    COMBINEFUNC = hll_sketch_combine,
+    SERIALFUNC = hll_sketch_serialize_state,
+    DESERIALFUNC = hll_sketch_deserialize_state, 
+    FINALFUNC = hll_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    MSTYPE = internal,
+    MSFUNC = hll_sketch_union_moving_agg,
+    MINVFUNC = hll_sketch_union_moving_inv,
+    MFINALFUNC = hll_sketch_union_moving_final,
+    MFINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE theta_sketch_union(theta_sketch) (
+    STYPE = internal,
+    SFUNC = theta_sketch_union_agg,
+    COMBINEFUNC = theta_sketch_union_combine,
+    SERIALFUNC = theta_sketch_serialize_state,
+    DESERIALFUNC = theta_sketch_deserialize_state, 
+    FINALFUNC = theta_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    MSTYPE = internal,
+    MSFUNC = theta_sketch_union_moving_agg,
+    MINVFUNC = theta_sketch_union_moving_inv,
+    MFINALFUNC = theta_sketch_union_moving_final,
+    MFINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE theta_sketch_union(theta_sketch, int) (
+    STYPE = internal,
+    SFUNC = theta_sketch_union_agg,
+    COMBINEFUNC = theta_sketch_union_combine,
+    SERIALFUNC = theta_sketch_serialize_state,
+    DESERIALFUNC = theta_sketch_deserialize_state, 
+    FINALFUNC = theta_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    MSTYPE = internal,
+    MSFUNC = theta_sketch_union_moving_agg,
+    MINVFUNC = theta_sketch_union_moving_inv,
+    MFINALFUNC = theta_sketch_union_moving_final,
+    MFINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE kll_float_sketch_merge(kll_float_sketch) (
+    STYPE = internal,
+    SFUNC = kll_float_sketch_merge_agg,
+    COMBINEFUNC = kll_float_sketch_combine,
+    SERIALFUNC = kll_float_sketch_serialize,
+    DESERIALFUNC = kll_float_sketch_deserialize,
+    FINALFUNC = kll_float_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
+    MSTYPE = internal,
+    MSFUNC = kll_float_sketch_merge_moving_agg,
+    MINVFUNC = kll_float_sketch_merge_moving_inv,
+    MFINALFUNC = kll_float_sketch_merge_moving_final,
+    MFINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE kll_float_sketch_merge(kll_float_sketch, int) (
+    STYPE = internal,
+    SFUNC = kll_float_sketch_merge_agg,
+    COMBINEFUNC = kll_float_sketch_combine,
+    SERIALFUNC = kll_float_sketch_serialize,
+    DESERIALFUNC = kll_float_sketch_deserialize,
+    FINALFUNC = kll_float_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
+    MSTYPE = internal,
+    MSFUNC = kll_float_sketch_merge_moving_agg,
+    MINVFUNC = kll_float_sketch_merge_moving_inv,
+    MFINALFUNC = kll_float_sketch_merge_moving_final,
+    MFINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+-- union functions return expanded sketches, which nested calls and PL/pgSQL assignments update in place
+
+CREATE OR REPLACE FUNCTION theta_sketch_union_support(internal) RETURNS internal
+    AS '$libdir/datasketches', 'pg_sketch_union_support'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_union(theta_sketch, theta_sketch) RETURNS theta_sketch
+    AS '$libdir/datasketches', 'pg_theta_sketch_union'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE
+    SUPPORT theta_sketch_union_support;
+
+CREATE OR REPLACE FUNCTION theta_sketch_union(theta_sketch, theta_sketch, int) RETURNS theta_sketch
+    AS '$libdir/datasketches', 'pg_theta_sketch_union'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE
+    SUPPORT theta_sketch_union_support;
+
+CREATE OR REPLACE FUNCTION hll_sketch_union_support(internal) RETURNS internal
+    AS '$libdir/datasketches', 'pg_sketch_union_support'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION hll_sketch_union(hll_sketch, hll_sketch) RETURNS hll_sketch
+    AS '$libdir/datasketches', 'pg_hll_sketch_union'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE
+    SUPPORT hll_sketch_union_support;
+
+CREATE OR REPLACE FUNCTION hll_sketch_union(hll_sketch, hll_sketch, int) RETURNS hll_sketch
+    AS '$libdir/datasketches', 'pg_hll_sketch_union'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE
+    SUPPORT hll_sketch_union_support;
+
+CREATE OR REPLACE FUNCTION hll_sketch_union(hll_sketch, hll_sketch, int, int) RETURNS hll_sketch
+    AS '$libdir/datasketches', 'pg_hll_sketch_union'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE
+    SUPPORT hll_sketch_union_support;
+
+-- set operations on arrays of sketches
+
+CREATE OR REPLACE FUNCTION theta_sketch_union(theta_sketch[]) RETURNS theta_sketch
+    AS '$libdir/datasketches', 'pg_theta_sketch_union_array'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_union(theta_sketch[], int) RETURNS theta_sketch
+    AS '$libdir/datasketches', 'pg_theta_sketch_union_array'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_intersection(theta_sketch[]) RETURNS theta_sketch
+    AS '$libdir/datasketches', 'pg_theta_sketch_intersection_array'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION hll_sketch_union(hll_sketch[]) RETURNS hll_sketch
+    AS '$libdir/datasketches', 'pg_hll_sketch_union_array'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION hll_sketch_union(hll_sketch[], int) RETURNS hll_sketch
+    AS '$libdir/datasketches', 'pg_hll_sketch_union_array'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION hll_sketch_union(hll_sketch[], int, int) RETURNS hll_sketch
+    AS '$libdir/datasketches', 'pg_hll_sketch_union_array'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION cpc_sketch_union(cpc_sketch[]) RETURNS cpc_sketch
+    AS '$libdir/datasketches', 'pg_cpc_sketch_union_array'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION cpc_sketch_union(cpc_sketch[], int) RETURNS cpc_sketch
+    AS '$libdir/datasketches', 'pg_cpc_sketch_union_array'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION aod_sketch_union(aod_sketch[]) RETURNS aod_sketch
+    AS '$libdir/datasketches', 'pg_aod_sketch_union_array'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION aod_sketch_union(aod_sketch[], int) RETURNS aod_sketch
+    AS '$libdir/datasketches', 'pg_aod_sketch_union_array'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION aod_sketch_union(aod_sketch[], int, int) RETURNS aod_sketch
+    AS '$libdir/datasketches', 'pg_aod_sketch_union_array'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION aod_sketch_intersection(aod_sketch[]) RETURNS aod_sketch
+    AS '$libdir/datasketches', 'pg_aod_sketch_intersection_array'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION aod_sketch_intersection(aod_sketch[], int) RETURNS aod_sketch
+    AS '$libdir/datasketches', 'pg_aod_sketch_intersection_array'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+-- set expressions over arrays of theta sketches
+
+CREATE OR REPLACE FUNCTION theta_sketch_eval(text, theta_sketch[]) RETURNS theta_sketch
+    AS '$libdir/datasketches', 'pg_theta_sketch_eval'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_eval(text, theta_sketch[], int) RETURNS theta_sketch
+    AS '$libdir/datasketches', 'pg_theta_sketch_eval'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_eval_estimate(text, theta_sketch[]) RETURNS double precision
+    AS '$libdir/datasketches', 'pg_theta_sketch_eval_estimate'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_eval_estimate(text, theta_sketch[], int) RETURNS double precision
+    AS '$libdir/datasketches', 'pg_theta_sketch_eval_estimate'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+-- estimates of set operations on two theta sketches without building the results, and their Jaccard similarity
+
+CREATE OR REPLACE FUNCTION theta_sketch_union_estimate(theta_sketch, theta_sketch) RETURNS double precision
+    AS '$libdir/datasketches', 'pg_theta_sketch_union_estimate'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_union_estimate(theta_sketch, theta_sketch, int) RETURNS double precision
+    AS '$libdir/datasketches', 'pg_theta_sketch_union_estimate'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_intersection_estimate(theta_sketch, theta_sketch) RETURNS double precision
+    AS '$libdir/datasketches', 'pg_theta_sketch_intersection_estimate'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_a_not_b_estimate(theta_sketch, theta_sketch) RETURNS double precision
+    AS '$libdir/datasketches', 'pg_theta_sketch_a_not_b_estimate'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_jaccard(theta_sketch, theta_sketch) RETURNS double precision[]
+    AS '$libdir/datasketches', 'pg_theta_sketch_jaccard'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+-- pairwise intersection estimates of arrays of theta sketches
+
+CREATE OR REPLACE FUNCTION theta_sketch_overlap_matrix(theta_sketch[]) RETURNS double precision[]
+    AS '$libdir/datasketches', 'pg_theta_sketch_overlap_matrix'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_overlap_matrix(theta_sketch[], int) RETURNS double precision[]
+    AS '$libdir/datasketches', 'pg_theta_sketch_overlap_matrix'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+-- hash once, build many sketches from the hashes
+
+-- the hash of the item for the *_sketch_build_from_hash aggregates, which hash its 8 bytes again:
+-- sketches built from hashes can only be merged with each other, not with sketches built from the items
+CREATE OR REPLACE FUNCTION datasketches_hash(anyelement) RETURNS bigint
+    AS '$libdir/datasketches', 'pg_datasketches_hash'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+-- from datasketches_hash, the sketches can only be merged with sketches built from hashes
+CREATE OR REPLACE AGGREGATE theta_sketch_build_from_hash(bigint) (
+    STYPE = internal,
+    SFUNC = theta_sketch_build_agg,
+    COMBINEFUNC = theta_sketch_union_combine,
+    SERIALFUNC = theta_sketch_serialize_state,
+    DESERIALFUNC = theta_sketch_deserialize_state, 
+    FINALFUNC = theta_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE theta_sketch_build_from_hash(bigint, int) (
+    STYPE = internal,
+    SFUNC = theta_sketch_build_agg,
+    COMBINEFUNC = theta_sketch_union_combine,
+    SERIALFUNC = theta_sketch_serialize_state,
+    DESERIALFUNC = theta_sketch_deserialize_state, 
+    FINALFUNC = theta_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE theta_sketch_build_from_hash(bigint, int, real) (
+    STYPE = internal,
+    SFUNC = theta_sketch_build_agg,
+    COMBINEFUNC = theta_sketch_union_combine,
+    SERIALFUNC = theta_sketch_serialize_state,
+    DESERIALFUNC = theta_sketch_deserialize_state, 
+    FINALFUNC = theta_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+-- from datasketches_hash, the sketches can only be merged with sketches built from hashes
+CREATE OR REPLACE AGGREGATE hll_sketch_build_from_hash(bigint) (
+    STYPE = internal,
+    SFUNC = hll_sketch_build_agg,
+    COMBINEFUNC = hll_sketch_combine,
+    SERIALFUNC = hll_sketch_serialize_state,
+    DESERIALFUNC = hll_sketch_deserialize_state, 
+    FINALFUNC = hll_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE hll_sketch_build_from_hash(bigint, int) (
+    STYPE = internal,
+    SFUNC = hll_sketch_build_agg,
+    COMBINEFUNC = hll_sketch_combine,
+    SERIALFUNC = hll_sketch_serialize_state,
+    DESERIALFUNC = hll_sketch_deserialize_state, 
+    FINALFUNC = hll_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE hll_sketch_build_from_hash(bigint, int, int) (
+    STYPE = internal,
+    SFUNC = hll_sketch_build_agg,
+    COMBINEFUNC = hll_sketch_combine,
+    SERIALFUNC = hll_sketch_serialize_state,
+    DESERIALFUNC = hll_sketch_deserialize_state, 
+    FINALFUNC = hll_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+-- from datasketches_hash, the sketches can only be merged with sketches built from hashes
+CREATE OR REPLACE AGGREGATE cpc_sketch_build_from_hash(bigint) (
+    STYPE = internal,
+    SFUNC = cpc_sketch_build_agg,
+    COMBINEFUNC = cpc_sketch_combine,
+    SERIALFUNC = cpc_sketch_serialize_state,
+    DESERIALFUNC = cpc_sketch_deserialize_state, 
+    FINALFUNC = cpc_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE cpc_sketch_build_from_hash(bigint, int) (
+    STYPE = internal,
+    SFUNC = cpc_sketch_build_agg,
+    COMBINEFUNC = cpc_sketch_combine,
+    SERIALFUNC = cpc_sketch_serialize_state,
+    DESERIALFUNC = cpc_sketch_deserialize_state, 
+    FINALFUNC = cpc_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+-- batches of values packed by the client added to sketches
+
+CREATE OR REPLACE FUNCTION theta_sketch_update_packed(theta_sketch, bytea) RETURNS theta_sketch
+    AS '$libdir/datasketches', 'pg_theta_sketch_update_packed'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_update_packed(theta_sketch, bytea, int) RETURNS theta_sketch
+    AS '$libdir/datasketches', 'pg_theta_sketch_update_packed'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION hll_sketch_update_packed(hll_sketch, bytea) RETURNS hll_sketch
+    AS '$libdir/datasketches', 'pg_hll_sketch_update_packed'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION hll_sketch_update_packed(hll_sketch, bytea, int) RETURNS hll_sketch
+    AS '$libdir/datasketches', 'pg_hll_sketch_update_packed'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_float_sketch_update_packed(kll_float_sketch, bytea) RETURNS kll_float_sketch
+    AS '$libdir/datasketches', 'pg_kll_float_sketch_update_packed'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_float_sketch_update_packed(kll_float_sketch, bytea, int) RETURNS kll_float_sketch
+    AS '$libdir/datasketches', 'pg_kll_float_sketch_update_packed'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
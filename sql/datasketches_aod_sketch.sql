@@ -25,9 +25,19 @@ CREATE OR REPLACE FUNCTION aod_sketch_out(aod_sketch) RETURNS cstring
      AS '$libdir/datasketches', 'pg_sketch_out'
      LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
 
+CREATE OR REPLACE FUNCTION aod_sketch_recv(internal) RETURNS aod_sketch
+     AS '$libdir/datasketches', 'pg_sketch_recv'
+     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION aod_sketch_send(aod_sketch) RETURNS bytea
+     AS '$libdir/datasketches', 'pg_sketch_send'
+     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
 CREATE TYPE aod_sketch (
     INPUT = aod_sketch_in,
     OUTPUT = aod_sketch_out,
+    RECEIVE = aod_sketch_recv,
+    SEND = aod_sketch_send,
     STORAGE = EXTERNAL
 );
 
@@ -202,6 +212,26 @@ CREATE OR REPLACE FUNCTION aod_sketch_intersection(aod_sketch, aod_sketch, int)
     AS '$libdir/datasketches', 'pg_aod_sketch_intersection'
     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
 
+CREATE OR REPLACE FUNCTION aod_sketch_union(aod_sketch[]) RETURNS aod_sketch
+    AS '$libdir/datasketches', 'pg_aod_sketch_union_array'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION aod_sketch_union(aod_sketch[], int) RETURNS aod_sketch
+    AS '$libdir/datasketches', 'pg_aod_sketch_union_array'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION aod_sketch_union(aod_sketch[], int, int) RETURNS aod_sketch
+    AS '$libdir/datasketches', 'pg_aod_sketch_union_array'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION aod_sketch_intersection(aod_sketch[]) RETURNS aod_sketch
+    AS '$libdir/datasketches', 'pg_aod_sketch_intersection_array'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION aod_sketch_intersection(aod_sketch[], int) RETURNS aod_sketch
+    AS '$libdir/datasketches', 'pg_aod_sketch_intersection_array'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
 CREATE OR REPLACE FUNCTION aod_sketch_a_not_b(aod_sketch, aod_sketch) RETURNS aod_sketch
     AS '$libdir/datasketches', 'pg_aod_sketch_a_not_b'
     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
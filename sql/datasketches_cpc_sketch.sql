@@ -25,9 +25,19 @@ CREATE OR REPLACE FUNCTION cpc_sketch_out(cpc_sketch) RETURNS cstring
      AS '$libdir/datasketches', 'pg_sketch_out'
      LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
 
+CREATE OR REPLACE FUNCTION cpc_sketch_recv(internal) RETURNS cpc_sketch
+     AS '$libdir/datasketches', 'pg_sketch_recv'
+     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION cpc_sketch_send(cpc_sketch) RETURNS bytea
+     AS '$libdir/datasketches', 'pg_sketch_send'
+     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
 CREATE TYPE cpc_sketch (
     INPUT = cpc_sketch_in,
     OUTPUT = cpc_sketch_out,
+    RECEIVE = cpc_sketch_recv,
+    SEND = cpc_sketch_send,
     STORAGE = EXTERNAL
 );
 
@@ -77,6 +87,7 @@ CREATE OR REPLACE AGGREGATE cpc_sketch_distinct(anyelement) (
     SERIALFUNC = cpc_sketch_serialize_state,
     DESERIALFUNC = cpc_sketch_deserialize_state, 
     FINALFUNC = cpc_sketch_get_estimate_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -87,6 +98,7 @@ CREATE OR REPLACE AGGREGATE cpc_sketch_distinct(anyelement, int) (
     SERIALFUNC = cpc_sketch_serialize_state,
     DESERIALFUNC = cpc_sketch_deserialize_state, 
     FINALFUNC = cpc_sketch_get_estimate_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -97,6 +109,7 @@ CREATE OR REPLACE AGGREGATE cpc_sketch_build(anyelement) (
     SERIALFUNC = cpc_sketch_serialize_state,
     DESERIALFUNC = cpc_sketch_deserialize_state, 
     FINALFUNC = cpc_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -107,6 +120,30 @@ CREATE OR REPLACE AGGREGATE cpc_sketch_build(anyelement, int) (
     SERIALFUNC = cpc_sketch_serialize_state,
     DESERIALFUNC = cpc_sketch_deserialize_state, 
     FINALFUNC = cpc_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+-- from datasketches_hash, the sketches can only be merged with sketches built from hashes
+CREATE OR REPLACE AGGREGATE cpc_sketch_build_from_hash(bigint) (
+    STYPE = internal,
+    SFUNC = cpc_sketch_build_agg,
+    COMBINEFUNC = cpc_sketch_combine,
+    SERIALFUNC = cpc_sketch_serialize_state,
+    DESERIALFUNC = cpc_sketch_deserialize_state, 
+    FINALFUNC = cpc_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE cpc_sketch_build_from_hash(bigint, int) (
+    STYPE = internal,
+    SFUNC = cpc_sketch_build_agg,
+    COMBINEFUNC = cpc_sketch_combine,
+    SERIALFUNC = cpc_sketch_serialize_state,
+    DESERIALFUNC = cpc_sketch_deserialize_state, 
+    FINALFUNC = cpc_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -117,6 +154,7 @@ CREATE OR REPLACE AGGREGATE cpc_sketch_union(cpc_sketch) (
     SERIALFUNC = cpc_sketch_serialize_state,
     DESERIALFUNC = cpc_sketch_deserialize_state, 
     FINALFUNC = cpc_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -127,6 +165,29 @@ CREATE OR REPLACE AGGREGATE cpc_sketch_union(cpc_sketch, int) (
     SERIALFUNC = cpc_sketch_serialize_state,
     DESERIALFUNC = cpc_sketch_deserialize_state, 
     FINALFUNC = cpc_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE cpc_sketch_union_distinct(cpc_sketch) (
+    STYPE = internal,
+    SFUNC = cpc_sketch_union_agg,
+    COMBINEFUNC = cpc_sketch_combine,
+    SERIALFUNC = cpc_sketch_serialize_state,
+    DESERIALFUNC = cpc_sketch_deserialize_state,
+    FINALFUNC = cpc_sketch_get_estimate_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE cpc_sketch_union_distinct(cpc_sketch, int) (
+    STYPE = internal,
+    SFUNC = cpc_sketch_union_agg,
+    COMBINEFUNC = cpc_sketch_combine,
+    SERIALFUNC = cpc_sketch_serialize_state,
+    DESERIALFUNC = cpc_sketch_deserialize_state,
+    FINALFUNC = cpc_sketch_get_estimate_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -153,3 +214,11 @@ CREATE OR REPLACE FUNCTION cpc_sketch_union(cpc_sketch, cpc_sketch) RETURNS cpc_
 CREATE OR REPLACE FUNCTION cpc_sketch_union(cpc_sketch, cpc_sketch, int) RETURNS cpc_sketch
     AS '$libdir/datasketches', 'pg_cpc_sketch_union'
     LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION cpc_sketch_union(cpc_sketch[]) RETURNS cpc_sketch
+    AS '$libdir/datasketches', 'pg_cpc_sketch_union_array'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION cpc_sketch_union(cpc_sketch[], int) RETURNS cpc_sketch
+    AS '$libdir/datasketches', 'pg_cpc_sketch_union_array'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
@@ -25,9 +25,19 @@ CREATE OR REPLACE FUNCTION frequent_strings_sketch_out(frequent_strings_sketch)
      AS '$libdir/datasketches', 'pg_sketch_out'
      LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
 
+CREATE OR REPLACE FUNCTION frequent_strings_sketch_recv(internal) RETURNS frequent_strings_sketch
+     AS '$libdir/datasketches', 'pg_sketch_recv'
+     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION frequent_strings_sketch_send(frequent_strings_sketch) RETURNS bytea
+     AS '$libdir/datasketches', 'pg_sketch_send'
+     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
 CREATE TYPE frequent_strings_sketch (
     INPUT = frequent_strings_sketch_in,
     OUTPUT = frequent_strings_sketch_out,
+    RECEIVE = frequent_strings_sketch_recv,
+    SEND = frequent_strings_sketch_send,
     STORAGE = EXTERNAL
 );
 
@@ -0,0 +1,22 @@
+-- Licensed to the Apache Software Foundation (ASF) under one
+-- or more contributor license agreements.  See the NOTICE file
+-- distributed with this work for additional information
+-- regarding copyright ownership.  The ASF licenses this file
+-- to you under the Apache License, Version 2.0 (the
+-- "License"); you may not use this file except in compliance
+-- with the License.  You may obtain a copy of the License at
+--
+--   http://www.apache.org/licenses/LICENSE-2.0
+--
+-- Unless required by applicable law or agreed to in writing,
+-- software distributed under the License is distributed on an
+-- "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+-- KIND, either express or implied.  See the License for the
+-- specific language governing permissions and limitations
+-- under the License.
+
+-- the hash of the item for the *_sketch_build_from_hash aggregates, which hash its 8 bytes again:
+-- sketches built from hashes can only be merged with each other, not with sketches built from the items
+CREATE OR REPLACE FUNCTION datasketches_hash(anyelement) RETURNS bigint
+    AS '$libdir/datasketches', 'pg_datasketches_hash'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
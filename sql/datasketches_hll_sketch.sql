@@ -25,9 +25,19 @@ CREATE OR REPLACE FUNCTION hll_sketch_out(hll_sketch) RETURNS cstring
      AS '$libdir/datasketches', 'pg_sketch_out'
      LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
 
+CREATE OR REPLACE FUNCTION hll_sketch_recv(internal) RETURNS hll_sketch
+     AS '$libdir/datasketches', 'pg_sketch_recv'
+     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION hll_sketch_send(hll_sketch) RETURNS bytea
+     AS '$libdir/datasketches', 'pg_sketch_send'
+     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
 CREATE TYPE hll_sketch (
     INPUT = hll_sketch_in,
     OUTPUT = hll_sketch_out,
+    RECEIVE = hll_sketch_recv,
+    SEND = hll_sketch_send,
     STORAGE = EXTERNAL
 );
 
@@ -66,6 +76,34 @@ CREATE OR REPLACE FUNCTION hll_sketch_union_agg(internal, hll_sketch, int, int)
     AS '$libdir/datasketches', 'pg_hll_sketch_union_agg'
     LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
+CREATE OR REPLACE FUNCTION hll_sketch_union_moving_agg(internal, hll_sketch) RETURNS internal
+    AS '$libdir/datasketches', 'pg_hll_sketch_union_moving_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION hll_sketch_union_moving_agg(internal, hll_sketch, int) RETURNS internal
+    AS '$libdir/datasketches', 'pg_hll_sketch_union_moving_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION hll_sketch_union_moving_agg(internal, hll_sketch, int, int) RETURNS internal
+    AS '$libdir/datasketches', 'pg_hll_sketch_union_moving_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION hll_sketch_union_moving_inv(internal, hll_sketch) RETURNS internal
+    AS '$libdir/datasketches', 'pg_hll_sketch_union_moving_inv'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION hll_sketch_union_moving_inv(internal, hll_sketch, int) RETURNS internal
+    AS '$libdir/datasketches', 'pg_hll_sketch_union_moving_inv'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION hll_sketch_union_moving_inv(internal, hll_sketch, int, int) RETURNS internal
+    AS '$libdir/datasketches', 'pg_hll_sketch_union_moving_inv'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION hll_sketch_union_moving_final(internal) RETURNS hll_sketch
+    AS '$libdir/datasketches', 'pg_hll_sketch_union_moving_final'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
 CREATE OR REPLACE FUNCTION hll_sketch_combine(internal, internal) RETURNS internal
     AS '$libdir/datasketches', 'pg_hll_sketch_combine'
     LANGUAGE C IMMUTABLE PARALLEL SAFE;
@@ -85,6 +123,7 @@ CREATE OR REPLACE AGGREGATE hll_sketch_distinct(anyelement) (
     SERIALFUNC = hll_sketch_serialize_state,
     DESERIALFUNC = hll_sketch_deserialize_state, 
     FINALFUNC = hll_sketch_get_estimate_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -95,6 +134,7 @@ CREATE OR REPLACE AGGREGATE hll_sketch_distinct(anyelement, int) (
     SERIALFUNC = hll_sketch_serialize_state,
     DESERIALFUNC = hll_sketch_deserialize_state, 
     FINALFUNC = hll_sketch_get_estimate_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -105,6 +145,7 @@ CREATE OR REPLACE AGGREGATE hll_sketch_build(anyelement) (
     SERIALFUNC = hll_sketch_serialize_state,
     DESERIALFUNC = hll_sketch_deserialize_state, 
     FINALFUNC = hll_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -115,6 +156,7 @@ CREATE OR REPLACE AGGREGATE hll_sketch_build(anyelement, int) (
     SERIALFUNC = hll_sketch_serialize_state,
     DESERIALFUNC = hll_sketch_deserialize_state, 
     FINALFUNC = hll_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -125,6 +167,41 @@ CREATE OR REPLACE AGGREGATE hll_sketch_build(anyelement, int, int) (
     SERIALFUNC = hll_sketch_serialize_state,
     DESERIALFUNC = hll_sketch_deserialize_state, 
     FINALFUNC = hll_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+-- from datasketches_hash, the sketches can only be merged with sketches built from hashes
+CREATE OR REPLACE AGGREGATE hll_sketch_build_from_hash(bigint) (
+    STYPE = internal,
+    SFUNC = hll_sketch_build_agg,
+    COMBINEFUNC = hll_sketch_combine,
+    SERIALFUNC = hll_sketch_serialize_state,
+    DESERIALFUNC = hll_sketch_deserialize_state, 
+    FINALFUNC = hll_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE hll_sketch_build_from_hash(bigint, int) (
+    STYPE = internal,
+    SFUNC = hll_sketch_build_agg,
+    COMBINEFUNC = hll_sketch_combine,
+    SERIALFUNC = hll_sketch_serialize_state,
+    DESERIALFUNC = hll_sketch_deserialize_state, 
+    FINALFUNC = hll_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE hll_sketch_build_from_hash(bigint, int, int) (
+    STYPE = internal,
+    SFUNC = hll_sketch_build_agg,
+    COMBINEFUNC = hll_sketch_combine,
+    SERIALFUNC = hll_sketch_serialize_state,
+    DESERIALFUNC = hll_sketch_deserialize_state, 
+    FINALFUNC = hll_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -135,6 +212,12 @@ CREATE OR REPLACE AGGREGATE hll_sketch_union(hll_sketch) (
     SERIALFUNC = hll_sketch_serialize_state,
     DESERIALFUNC = hll_sketch_deserialize_state, 
     FINALFUNC = hll_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    MSTYPE = internal,
+    MSFUNC = hll_sketch_union_moving_agg,
+    MINVFUNC = hll_sketch_union_moving_inv,
+    MFINALFUNC = hll_sketch_union_moving_final,
+    MFINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -145,6 +228,12 @@ CREATE OR REPLACE AGGREGATE hll_sketch_union(hll_sketch, int) (
     SERIALFUNC = hll_sketch_serialize_state,
     DESERIALFUNC = hll_sketch_deserialize_state, 
     FINALFUNC = hll_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    MSTYPE = internal,
+    MSFUNC = hll_sketch_union_moving_agg,
+    MINVFUNC = hll_sketch_union_moving_inv,
+    MFINALFUNC = hll_sketch_union_moving_final,
+    MFINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -155,6 +244,34 @@ CREATE OR REPLACE AGGREGATE hll_sketch_union(hll_sketch, int, int) (
     SERIALFUNC = hll_sketch_serialize_state,
     DESERIALFUNC = hll_sketch_deserialize_state, 
     FINALFUNC = hll_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    MSTYPE = internal,
+    MSFUNC = hll_sketch_union_moving_agg,
+    MINVFUNC = hll_sketch_union_moving_inv,
+    MFINALFUNC = hll_sketch_union_moving_final,
+    MFINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE hll_sketch_union_distinct(hll_sketch) (
+    STYPE = internal,
+    SFUNC = hll_sketch_union_agg,
+    COMBINEFUNC = hll_sketch_combine,
+    SERIALFUNC = hll_sketch_serialize_state,
+    DESERIALFUNC = hll_sketch_deserialize_state,
+    FINALFUNC = hll_sketch_get_estimate_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE hll_sketch_union_distinct(hll_sketch, int) (
+    STYPE = internal,
+    SFUNC = hll_sketch_union_agg,
+    COMBINEFUNC = hll_sketch_combine,
+    SERIALFUNC = hll_sketch_serialize_state,
+    DESERIALFUNC = hll_sketch_deserialize_state,
+    FINALFUNC = hll_sketch_get_estimate_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -174,14 +291,41 @@ CREATE OR REPLACE FUNCTION hll_sketch_to_string(hll_sketch) RETURNS TEXT
     AS '$libdir/datasketches', 'pg_hll_sketch_to_string'
     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
 
+CREATE OR REPLACE FUNCTION hll_sketch_union_support(internal) RETURNS internal
+    AS '$libdir/datasketches', 'pg_sketch_union_support'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
 CREATE OR REPLACE FUNCTION hll_sketch_union(hll_sketch, hll_sketch) RETURNS hll_sketch
     AS '$libdir/datasketches', 'pg_hll_sketch_union'
-    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+    LANGUAGE C IMMUTABLE PARALLEL SAFE
+    SUPPORT hll_sketch_union_support;
 
 CREATE OR REPLACE FUNCTION hll_sketch_union(hll_sketch, hll_sketch, int) RETURNS hll_sketch
     AS '$libdir/datasketches', 'pg_hll_sketch_union'
-    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+    LANGUAGE C IMMUTABLE PARALLEL SAFE
+    SUPPORT hll_sketch_union_support;
 
 CREATE OR REPLACE FUNCTION hll_sketch_union(hll_sketch, hll_sketch, int, int) RETURNS hll_sketch
     AS '$libdir/datasketches', 'pg_hll_sketch_union'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE
+    SUPPORT hll_sketch_union_support;
+
+CREATE OR REPLACE FUNCTION hll_sketch_union(hll_sketch[]) RETURNS hll_sketch
+    AS '$libdir/datasketches', 'pg_hll_sketch_union_array'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION hll_sketch_union(hll_sketch[], int) RETURNS hll_sketch
+    AS '$libdir/datasketches', 'pg_hll_sketch_union_array'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION hll_sketch_union(hll_sketch[], int, int) RETURNS hll_sketch
+    AS '$libdir/datasketches', 'pg_hll_sketch_union_array'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION hll_sketch_update_packed(hll_sketch, bytea) RETURNS hll_sketch
+    AS '$libdir/datasketches', 'pg_hll_sketch_update_packed'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION hll_sketch_update_packed(hll_sketch, bytea, int) RETURNS hll_sketch
+    AS '$libdir/datasketches', 'pg_hll_sketch_update_packed'
     LANGUAGE C IMMUTABLE PARALLEL SAFE;
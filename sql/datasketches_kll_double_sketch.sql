@@ -25,9 +25,19 @@ CREATE OR REPLACE FUNCTION kll_double_sketch_out(kll_double_sketch) RETURNS cstr
      AS '$libdir/datasketches', 'pg_sketch_out'
      LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
 
+CREATE OR REPLACE FUNCTION kll_double_sketch_recv(internal) RETURNS kll_double_sketch
+     AS '$libdir/datasketches', 'pg_sketch_recv'
+     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_double_sketch_send(kll_double_sketch) RETURNS bytea
+     AS '$libdir/datasketches', 'pg_sketch_send'
+     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
 CREATE TYPE kll_double_sketch (
     INPUT = kll_double_sketch_in,
     OUTPUT = kll_double_sketch_out,
+    RECEIVE = kll_double_sketch_recv,
+    SEND = kll_double_sketch_send,
     STORAGE = EXTERNAL
 );
 
@@ -63,7 +73,7 @@ CREATE OR REPLACE FUNCTION kll_double_sketch_combine(internal, internal) RETURNS
     LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 CREATE OR REPLACE FUNCTION kll_double_sketch_finalize(internal) RETURNS kll_double_sketch
-    AS '$libdir/datasketches', 'pg_kll_double_sketch_serialize'
+    AS '$libdir/datasketches', 'pg_kll_double_sketch_finalize'
     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
 
 CREATE OR REPLACE AGGREGATE kll_double_sketch_build(double precision) (
@@ -73,6 +83,7 @@ CREATE OR REPLACE AGGREGATE kll_double_sketch_build(double precision) (
     SERIALFUNC = kll_double_sketch_serialize,
     DESERIALFUNC = kll_double_sketch_deserialize, 
     FINALFUNC = kll_double_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -83,6 +94,7 @@ CREATE OR REPLACE AGGREGATE kll_double_sketch_build(double precision, int) (
     SERIALFUNC = kll_double_sketch_serialize,
     DESERIALFUNC = kll_double_sketch_deserialize, 
     FINALFUNC = kll_double_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -93,6 +105,7 @@ CREATE OR REPLACE AGGREGATE kll_double_sketch_merge(kll_double_sketch) (
     SERIALFUNC = kll_double_sketch_serialize,
     DESERIALFUNC = kll_double_sketch_deserialize, 
     FINALFUNC = kll_double_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -103,6 +116,87 @@ CREATE OR REPLACE AGGREGATE kll_double_sketch_merge(kll_double_sketch, int) (
     SERIALFUNC = kll_double_sketch_serialize,
     DESERIALFUNC = kll_double_sketch_deserialize, 
     FINALFUNC = kll_double_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE FUNCTION kll_double_sketch_approx_agg(internal, double precision, double precision) RETURNS internal
+    AS '$libdir/datasketches', 'pg_kll_double_sketch_approx_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_double_sketch_approx_agg(internal, double precision, double precision, int) RETURNS internal
+    AS '$libdir/datasketches', 'pg_kll_double_sketch_approx_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_double_sketch_approx_agg(internal, double precision, double precision[]) RETURNS internal
+    AS '$libdir/datasketches', 'pg_kll_double_sketch_approx_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_double_sketch_approx_agg(internal, double precision, double precision[], int) RETURNS internal
+    AS '$libdir/datasketches', 'pg_kll_double_sketch_approx_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_double_sketch_approx_serialize(internal) RETURNS bytea
+    AS '$libdir/datasketches', 'pg_kll_double_sketch_approx_serialize'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_double_sketch_approx_deserialize(bytea, internal) RETURNS internal
+    AS '$libdir/datasketches', 'pg_kll_double_sketch_approx_deserialize'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_double_sketch_approx_combine(internal, internal) RETURNS internal
+    AS '$libdir/datasketches', 'pg_kll_double_sketch_approx_combine'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_double_sketch_approx_quantile(internal) RETURNS double precision
+    AS '$libdir/datasketches', 'pg_kll_double_sketch_approx_quantile'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_double_sketch_approx_quantiles(internal) RETURNS double precision[]
+    AS '$libdir/datasketches', 'pg_kll_double_sketch_approx_quantiles'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE AGGREGATE kll_double_approx_quantile(double precision, double precision) (
+    STYPE = internal,
+    SFUNC = kll_double_sketch_approx_agg,
+    COMBINEFUNC = kll_double_sketch_approx_combine,
+    SERIALFUNC = kll_double_sketch_approx_serialize,
+    DESERIALFUNC = kll_double_sketch_approx_deserialize,
+    FINALFUNC = kll_double_sketch_approx_quantile,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE kll_double_approx_quantile(double precision, double precision, int) (
+    STYPE = internal,
+    SFUNC = kll_double_sketch_approx_agg,
+    COMBINEFUNC = kll_double_sketch_approx_combine,
+    SERIALFUNC = kll_double_sketch_approx_serialize,
+    DESERIALFUNC = kll_double_sketch_approx_deserialize,
+    FINALFUNC = kll_double_sketch_approx_quantile,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE kll_double_approx_quantiles(double precision, double precision[]) (
+    STYPE = internal,
+    SFUNC = kll_double_sketch_approx_agg,
+    COMBINEFUNC = kll_double_sketch_approx_combine,
+    SERIALFUNC = kll_double_sketch_approx_serialize,
+    DESERIALFUNC = kll_double_sketch_approx_deserialize,
+    FINALFUNC = kll_double_sketch_approx_quantiles,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE kll_double_approx_quantiles(double precision, double precision[], int) (
+    STYPE = internal,
+    SFUNC = kll_double_sketch_approx_agg,
+    COMBINEFUNC = kll_double_sketch_approx_combine,
+    SERIALFUNC = kll_double_sketch_approx_serialize,
+    DESERIALFUNC = kll_double_sketch_approx_deserialize,
+    FINALFUNC = kll_double_sketch_approx_quantiles,
+    FINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
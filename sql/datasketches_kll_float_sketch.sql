@@ -25,9 +25,19 @@ CREATE OR REPLACE FUNCTION kll_float_sketch_out(kll_float_sketch) RETURNS cstrin
      AS '$libdir/datasketches', 'pg_sketch_out'
      LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
 
+CREATE OR REPLACE FUNCTION kll_float_sketch_recv(internal) RETURNS kll_float_sketch
+     AS '$libdir/datasketches', 'pg_sketch_recv'
+     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_float_sketch_send(kll_float_sketch) RETURNS bytea
+     AS '$libdir/datasketches', 'pg_sketch_send'
+     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
 CREATE TYPE kll_float_sketch (
     INPUT = kll_float_sketch_in,
     OUTPUT = kll_float_sketch_out,
+    RECEIVE = kll_float_sketch_recv,
+    SEND = kll_float_sketch_send,
     STORAGE = EXTERNAL
 );
 
@@ -50,6 +60,26 @@ CREATE OR REPLACE FUNCTION kll_float_sketch_merge_agg(internal, kll_float_sketch
     AS '$libdir/datasketches', 'pg_kll_float_sketch_merge_agg'
     LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
+CREATE OR REPLACE FUNCTION kll_float_sketch_merge_moving_agg(internal, kll_float_sketch) RETURNS internal
+    AS '$libdir/datasketches', 'pg_kll_float_sketch_merge_moving_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_float_sketch_merge_moving_agg(internal, kll_float_sketch, int) RETURNS internal
+    AS '$libdir/datasketches', 'pg_kll_float_sketch_merge_moving_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_float_sketch_merge_moving_inv(internal, kll_float_sketch) RETURNS internal
+    AS '$libdir/datasketches', 'pg_kll_float_sketch_merge_moving_inv'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_float_sketch_merge_moving_inv(internal, kll_float_sketch, int) RETURNS internal
+    AS '$libdir/datasketches', 'pg_kll_float_sketch_merge_moving_inv'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_float_sketch_merge_moving_final(internal) RETURNS kll_float_sketch
+    AS '$libdir/datasketches', 'pg_kll_float_sketch_merge_moving_final'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
 CREATE OR REPLACE FUNCTION kll_float_sketch_serialize(internal) RETURNS bytea
     AS '$libdir/datasketches', 'pg_kll_float_sketch_serialize'
     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
@@ -63,7 +93,7 @@ CREATE OR REPLACE FUNCTION kll_float_sketch_combine(internal, internal) RETURNS
     LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 CREATE OR REPLACE FUNCTION kll_float_sketch_finalize(internal) RETURNS kll_float_sketch
-    AS '$libdir/datasketches', 'pg_kll_float_sketch_serialize'
+    AS '$libdir/datasketches', 'pg_kll_float_sketch_finalize'
     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
 
 CREATE OR REPLACE AGGREGATE kll_float_sketch_build(real) (
@@ -73,6 +103,7 @@ CREATE OR REPLACE AGGREGATE kll_float_sketch_build(real) (
     SERIALFUNC = kll_float_sketch_serialize,
     DESERIALFUNC = kll_float_sketch_deserialize,
     FINALFUNC = kll_float_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -83,6 +114,7 @@ CREATE OR REPLACE AGGREGATE kll_float_sketch_build(real, int) (
     SERIALFUNC = kll_float_sketch_serialize,
     DESERIALFUNC = kll_float_sketch_deserialize,
     FINALFUNC = kll_float_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -93,6 +125,12 @@ CREATE OR REPLACE AGGREGATE kll_float_sketch_merge(kll_float_sketch) (
     SERIALFUNC = kll_float_sketch_serialize,
     DESERIALFUNC = kll_float_sketch_deserialize,
     FINALFUNC = kll_float_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
+    MSTYPE = internal,
+    MSFUNC = kll_float_sketch_merge_moving_agg,
+    MINVFUNC = kll_float_sketch_merge_moving_inv,
+    MFINALFUNC = kll_float_sketch_merge_moving_final,
+    MFINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -103,6 +141,92 @@ CREATE OR REPLACE AGGREGATE kll_float_sketch_merge(kll_float_sketch, int) (
     SERIALFUNC = kll_float_sketch_serialize,
     DESERIALFUNC = kll_float_sketch_deserialize,
     FINALFUNC = kll_float_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
+    MSTYPE = internal,
+    MSFUNC = kll_float_sketch_merge_moving_agg,
+    MINVFUNC = kll_float_sketch_merge_moving_inv,
+    MFINALFUNC = kll_float_sketch_merge_moving_final,
+    MFINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE FUNCTION kll_float_sketch_approx_agg(internal, real, double precision) RETURNS internal
+    AS '$libdir/datasketches', 'pg_kll_float_sketch_approx_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_float_sketch_approx_agg(internal, real, double precision, int) RETURNS internal
+    AS '$libdir/datasketches', 'pg_kll_float_sketch_approx_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_float_sketch_approx_agg(internal, real, double precision[]) RETURNS internal
+    AS '$libdir/datasketches', 'pg_kll_float_sketch_approx_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_float_sketch_approx_agg(internal, real, double precision[], int) RETURNS internal
+    AS '$libdir/datasketches', 'pg_kll_float_sketch_approx_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_float_sketch_approx_serialize(internal) RETURNS bytea
+    AS '$libdir/datasketches', 'pg_kll_float_sketch_approx_serialize'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_float_sketch_approx_deserialize(bytea, internal) RETURNS internal
+    AS '$libdir/datasketches', 'pg_kll_float_sketch_approx_deserialize'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_float_sketch_approx_combine(internal, internal) RETURNS internal
+    AS '$libdir/datasketches', 'pg_kll_float_sketch_approx_combine'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_float_sketch_approx_quantile(internal) RETURNS real
+    AS '$libdir/datasketches', 'pg_kll_float_sketch_approx_quantile'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_float_sketch_approx_quantiles(internal) RETURNS real[]
+    AS '$libdir/datasketches', 'pg_kll_float_sketch_approx_quantiles'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE AGGREGATE kll_float_approx_quantile(real, double precision) (
+    STYPE = internal,
+    SFUNC = kll_float_sketch_approx_agg,
+    COMBINEFUNC = kll_float_sketch_approx_combine,
+    SERIALFUNC = kll_float_sketch_approx_serialize,
+    DESERIALFUNC = kll_float_sketch_approx_deserialize,
+    FINALFUNC = kll_float_sketch_approx_quantile,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE kll_float_approx_quantile(real, double precision, int) (
+    STYPE = internal,
+    SFUNC = kll_float_sketch_approx_agg,
+    COMBINEFUNC = kll_float_sketch_approx_combine,
+    SERIALFUNC = kll_float_sketch_approx_serialize,
+    DESERIALFUNC = kll_float_sketch_approx_deserialize,
+    FINALFUNC = kll_float_sketch_approx_quantile,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE kll_float_approx_quantiles(real, double precision[]) (
+    STYPE = internal,
+    SFUNC = kll_float_sketch_approx_agg,
+    COMBINEFUNC = kll_float_sketch_approx_combine,
+    SERIALFUNC = kll_float_sketch_approx_serialize,
+    DESERIALFUNC = kll_float_sketch_approx_deserialize,
+    FINALFUNC = kll_float_sketch_approx_quantiles,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE kll_float_approx_quantiles(real, double precision[], int) (
+    STYPE = internal,
+    SFUNC = kll_float_sketch_approx_agg,
+    COMBINEFUNC = kll_float_sketch_approx_combine,
+    SERIALFUNC = kll_float_sketch_approx_serialize,
+    DESERIALFUNC = kll_float_sketch_approx_deserialize,
+    FINALFUNC = kll_float_sketch_approx_quantiles,
+    FINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -149,3 +273,11 @@ CREATE OR REPLACE FUNCTION kll_float_sketch_get_histogram(kll_float_sketch) RETU
 CREATE OR REPLACE FUNCTION kll_float_sketch_get_histogram(kll_float_sketch, int) RETURNS double precision[]
     AS '$libdir/datasketches', 'pg_kll_float_sketch_get_histogram'
     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_float_sketch_update_packed(kll_float_sketch, bytea) RETURNS kll_float_sketch
+    AS '$libdir/datasketches', 'pg_kll_float_sketch_update_packed'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION kll_float_sketch_update_packed(kll_float_sketch, bytea, int) RETURNS kll_float_sketch
+    AS '$libdir/datasketches', 'pg_kll_float_sketch_update_packed'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
@@ -25,9 +25,19 @@ CREATE OR REPLACE FUNCTION quantiles_double_sketch_out(quantiles_double_sketch)
      AS '$libdir/datasketches', 'pg_sketch_out'
      LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
 
+CREATE OR REPLACE FUNCTION quantiles_double_sketch_recv(internal) RETURNS quantiles_double_sketch
+     AS '$libdir/datasketches', 'pg_sketch_recv'
+     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION quantiles_double_sketch_send(quantiles_double_sketch) RETURNS bytea
+     AS '$libdir/datasketches', 'pg_sketch_send'
+     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
 CREATE TYPE quantiles_double_sketch (
     INPUT = quantiles_double_sketch_in,
     OUTPUT = quantiles_double_sketch_out,
+    RECEIVE = quantiles_double_sketch_recv,
+    SEND = quantiles_double_sketch_send,
     STORAGE = EXTERNAL
 );
 
@@ -63,7 +73,7 @@ CREATE OR REPLACE FUNCTION quantiles_double_sketch_combine(internal, internal) R
     LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 CREATE OR REPLACE FUNCTION quantiles_double_sketch_finalize(internal) RETURNS quantiles_double_sketch
-    AS '$libdir/datasketches', 'pg_quantiles_double_sketch_serialize'
+    AS '$libdir/datasketches', 'pg_quantiles_double_sketch_finalize'
     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
 
 CREATE OR REPLACE AGGREGATE quantiles_double_sketch_build(double precision) (
@@ -73,6 +83,7 @@ CREATE OR REPLACE AGGREGATE quantiles_double_sketch_build(double precision) (
     SERIALFUNC = quantiles_double_sketch_serialize,
     DESERIALFUNC = quantiles_double_sketch_deserialize, 
     FINALFUNC = quantiles_double_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -83,6 +94,7 @@ CREATE OR REPLACE AGGREGATE quantiles_double_sketch_build(double precision, int)
     SERIALFUNC = quantiles_double_sketch_serialize,
     DESERIALFUNC = quantiles_double_sketch_deserialize, 
     FINALFUNC = quantiles_double_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -93,6 +105,7 @@ CREATE OR REPLACE AGGREGATE quantiles_double_sketch_merge(quantiles_double_sketc
     SERIALFUNC = quantiles_double_sketch_serialize,
     DESERIALFUNC = quantiles_double_sketch_deserialize, 
     FINALFUNC = quantiles_double_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -103,6 +116,87 @@ CREATE OR REPLACE AGGREGATE quantiles_double_sketch_merge(quantiles_double_sketc
     SERIALFUNC = quantiles_double_sketch_serialize,
     DESERIALFUNC = quantiles_double_sketch_deserialize, 
     FINALFUNC = quantiles_double_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE FUNCTION quantiles_double_sketch_approx_agg(internal, double precision, double precision) RETURNS internal
+    AS '$libdir/datasketches', 'pg_quantiles_double_sketch_approx_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION quantiles_double_sketch_approx_agg(internal, double precision, double precision, int) RETURNS internal
+    AS '$libdir/datasketches', 'pg_quantiles_double_sketch_approx_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION quantiles_double_sketch_approx_agg(internal, double precision, double precision[]) RETURNS internal
+    AS '$libdir/datasketches', 'pg_quantiles_double_sketch_approx_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION quantiles_double_sketch_approx_agg(internal, double precision, double precision[], int) RETURNS internal
+    AS '$libdir/datasketches', 'pg_quantiles_double_sketch_approx_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION quantiles_double_sketch_approx_serialize(internal) RETURNS bytea
+    AS '$libdir/datasketches', 'pg_quantiles_double_sketch_approx_serialize'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION quantiles_double_sketch_approx_deserialize(bytea, internal) RETURNS internal
+    AS '$libdir/datasketches', 'pg_quantiles_double_sketch_approx_deserialize'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION quantiles_double_sketch_approx_combine(internal, internal) RETURNS internal
+    AS '$libdir/datasketches', 'pg_quantiles_double_sketch_approx_combine'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION quantiles_double_sketch_approx_quantile(internal) RETURNS double precision
+    AS '$libdir/datasketches', 'pg_quantiles_double_sketch_approx_quantile'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION quantiles_double_sketch_approx_quantiles(internal) RETURNS double precision[]
+    AS '$libdir/datasketches', 'pg_quantiles_double_sketch_approx_quantiles'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE AGGREGATE quantiles_double_approx_quantile(double precision, double precision) (
+    STYPE = internal,
+    SFUNC = quantiles_double_sketch_approx_agg,
+    COMBINEFUNC = quantiles_double_sketch_approx_combine,
+    SERIALFUNC = quantiles_double_sketch_approx_serialize,
+    DESERIALFUNC = quantiles_double_sketch_approx_deserialize,
+    FINALFUNC = quantiles_double_sketch_approx_quantile,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE quantiles_double_approx_quantile(double precision, double precision, int) (
+    STYPE = internal,
+    SFUNC = quantiles_double_sketch_approx_agg,
+    COMBINEFUNC = quantiles_double_sketch_approx_combine,
+    SERIALFUNC = quantiles_double_sketch_approx_serialize,
+    DESERIALFUNC = quantiles_double_sketch_approx_deserialize,
+    FINALFUNC = quantiles_double_sketch_approx_quantile,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE quantiles_double_approx_quantiles(double precision, double precision[]) (
+    STYPE = internal,
+    SFUNC = quantiles_double_sketch_approx_agg,
+    COMBINEFUNC = quantiles_double_sketch_approx_combine,
+    SERIALFUNC = quantiles_double_sketch_approx_serialize,
+    DESERIALFUNC = quantiles_double_sketch_approx_deserialize,
+    FINALFUNC = quantiles_double_sketch_approx_quantiles,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE quantiles_double_approx_quantiles(double precision, double precision[], int) (
+    STYPE = internal,
+    SFUNC = quantiles_double_sketch_approx_agg,
+    COMBINEFUNC = quantiles_double_sketch_approx_combine,
+    SERIALFUNC = quantiles_double_sketch_approx_serialize,
+    DESERIALFUNC = quantiles_double_sketch_approx_deserialize,
+    FINALFUNC = quantiles_double_sketch_approx_quantiles,
+    FINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
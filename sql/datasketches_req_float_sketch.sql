@@ -25,9 +25,19 @@ CREATE OR REPLACE FUNCTION req_float_sketch_out(req_float_sketch) RETURNS cstrin
      AS '$libdir/datasketches', 'pg_sketch_out'
      LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
 
+CREATE OR REPLACE FUNCTION req_float_sketch_recv(internal) RETURNS req_float_sketch
+     AS '$libdir/datasketches', 'pg_sketch_recv'
+     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION req_float_sketch_send(req_float_sketch) RETURNS bytea
+     AS '$libdir/datasketches', 'pg_sketch_send'
+     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
 CREATE TYPE req_float_sketch (
     INPUT = req_float_sketch_in,
     OUTPUT = req_float_sketch_out,
+    RECEIVE = req_float_sketch_recv,
+    SEND = req_float_sketch_send,
     STORAGE = EXTERNAL
 );
 
@@ -71,7 +81,7 @@ CREATE OR REPLACE FUNCTION req_float_sketch_combine(internal, internal) RETURNS
     LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 CREATE OR REPLACE FUNCTION req_float_sketch_finalize(internal) RETURNS req_float_sketch
-    AS '$libdir/datasketches', 'pg_req_float_sketch_serialize'
+    AS '$libdir/datasketches', 'pg_req_float_sketch_finalize'
     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
 
 CREATE OR REPLACE AGGREGATE req_float_sketch_build(real) (
@@ -81,6 +91,7 @@ CREATE OR REPLACE AGGREGATE req_float_sketch_build(real) (
     SERIALFUNC = req_float_sketch_serialize,
     DESERIALFUNC = req_float_sketch_deserialize, 
     FINALFUNC = req_float_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -91,6 +102,7 @@ CREATE OR REPLACE AGGREGATE req_float_sketch_build(real, int) (
     SERIALFUNC = req_float_sketch_serialize,
     DESERIALFUNC = req_float_sketch_deserialize, 
     FINALFUNC = req_float_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -101,6 +113,7 @@ CREATE OR REPLACE AGGREGATE req_float_sketch_build(real, int, boolean) (
     SERIALFUNC = req_float_sketch_serialize,
     DESERIALFUNC = req_float_sketch_deserialize, 
     FINALFUNC = req_float_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -111,6 +124,7 @@ CREATE OR REPLACE AGGREGATE req_float_sketch_merge(req_float_sketch) (
     SERIALFUNC = req_float_sketch_serialize,
     DESERIALFUNC = req_float_sketch_deserialize, 
     FINALFUNC = req_float_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -121,6 +135,7 @@ CREATE OR REPLACE AGGREGATE req_float_sketch_merge(req_float_sketch, int) (
     SERIALFUNC = req_float_sketch_serialize,
     DESERIALFUNC = req_float_sketch_deserialize, 
     FINALFUNC = req_float_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -131,6 +146,87 @@ CREATE OR REPLACE AGGREGATE req_float_sketch_merge(req_float_sketch, int, boolea
     SERIALFUNC = req_float_sketch_serialize,
     DESERIALFUNC = req_float_sketch_deserialize, 
     FINALFUNC = req_float_sketch_finalize,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE FUNCTION req_float_sketch_approx_agg(internal, real, double precision) RETURNS internal
+    AS '$libdir/datasketches', 'pg_req_float_sketch_approx_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION req_float_sketch_approx_agg(internal, real, double precision, int) RETURNS internal
+    AS '$libdir/datasketches', 'pg_req_float_sketch_approx_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION req_float_sketch_approx_agg(internal, real, double precision[]) RETURNS internal
+    AS '$libdir/datasketches', 'pg_req_float_sketch_approx_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION req_float_sketch_approx_agg(internal, real, double precision[], int) RETURNS internal
+    AS '$libdir/datasketches', 'pg_req_float_sketch_approx_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION req_float_sketch_approx_serialize(internal) RETURNS bytea
+    AS '$libdir/datasketches', 'pg_req_float_sketch_approx_serialize'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION req_float_sketch_approx_deserialize(bytea, internal) RETURNS internal
+    AS '$libdir/datasketches', 'pg_req_float_sketch_approx_deserialize'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION req_float_sketch_approx_combine(internal, internal) RETURNS internal
+    AS '$libdir/datasketches', 'pg_req_float_sketch_approx_combine'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION req_float_sketch_approx_quantile(internal) RETURNS real
+    AS '$libdir/datasketches', 'pg_req_float_sketch_approx_quantile'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION req_float_sketch_approx_quantiles(internal) RETURNS real[]
+    AS '$libdir/datasketches', 'pg_req_float_sketch_approx_quantiles'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE AGGREGATE req_float_approx_quantile(real, double precision) (
+    STYPE = internal,
+    SFUNC = req_float_sketch_approx_agg,
+    COMBINEFUNC = req_float_sketch_approx_combine,
+    SERIALFUNC = req_float_sketch_approx_serialize,
+    DESERIALFUNC = req_float_sketch_approx_deserialize,
+    FINALFUNC = req_float_sketch_approx_quantile,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE req_float_approx_quantile(real, double precision, int) (
+    STYPE = internal,
+    SFUNC = req_float_sketch_approx_agg,
+    COMBINEFUNC = req_float_sketch_approx_combine,
+    SERIALFUNC = req_float_sketch_approx_serialize,
+    DESERIALFUNC = req_float_sketch_approx_deserialize,
+    FINALFUNC = req_float_sketch_approx_quantile,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE req_float_approx_quantiles(real, double precision[]) (
+    STYPE = internal,
+    SFUNC = req_float_sketch_approx_agg,
+    COMBINEFUNC = req_float_sketch_approx_combine,
+    SERIALFUNC = req_float_sketch_approx_serialize,
+    DESERIALFUNC = req_float_sketch_approx_deserialize,
+    FINALFUNC = req_float_sketch_approx_quantiles,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE req_float_approx_quantiles(real, double precision[], int) (
+    STYPE = internal,
+    SFUNC = req_float_sketch_approx_agg,
+    COMBINEFUNC = req_float_sketch_approx_combine,
+    SERIALFUNC = req_float_sketch_approx_serialize,
+    DESERIALFUNC = req_float_sketch_approx_deserialize,
+    FINALFUNC = req_float_sketch_approx_quantiles,
+    FINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -25,9 +25,19 @@ CREATE OR REPLACE FUNCTION theta_sketch_out(theta_sketch) RETURNS cstring
     AS '$libdir/datasketches', 'pg_sketch_out'
     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
 
+CREATE OR REPLACE FUNCTION theta_sketch_recv(internal) RETURNS theta_sketch
+    AS '$libdir/datasketches', 'pg_sketch_recv'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_send(theta_sketch) RETURNS bytea
+    AS '$libdir/datasketches', 'pg_sketch_send'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
 CREATE TYPE theta_sketch (
     INPUT = theta_sketch_in,
     OUTPUT = theta_sketch_out,
+    RECEIVE = theta_sketch_recv,
+    SEND = theta_sketch_send,
     STORAGE = EXTERNAL
 );
 
@@ -62,6 +72,26 @@ CREATE OR REPLACE FUNCTION theta_sketch_union_agg(internal, theta_sketch, int) R
     AS '$libdir/datasketches', 'pg_theta_sketch_union_agg'
     LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
+CREATE OR REPLACE FUNCTION theta_sketch_union_moving_agg(internal, theta_sketch) RETURNS internal
+    AS '$libdir/datasketches', 'pg_theta_sketch_union_moving_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_union_moving_agg(internal, theta_sketch, int) RETURNS internal
+    AS '$libdir/datasketches', 'pg_theta_sketch_union_moving_agg'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_union_moving_inv(internal, theta_sketch) RETURNS internal
+    AS '$libdir/datasketches', 'pg_theta_sketch_union_moving_inv'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_union_moving_inv(internal, theta_sketch, int) RETURNS internal
+    AS '$libdir/datasketches', 'pg_theta_sketch_union_moving_inv'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_union_moving_final(internal) RETURNS theta_sketch
+    AS '$libdir/datasketches', 'pg_theta_sketch_union_moving_final'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
 CREATE OR REPLACE FUNCTION theta_sketch_intersection_agg(internal, theta_sketch) RETURNS internal
     AS '$libdir/datasketches', 'pg_theta_sketch_intersection_agg'
     LANGUAGE C IMMUTABLE PARALLEL SAFE;
@@ -89,6 +119,7 @@ CREATE OR REPLACE AGGREGATE theta_sketch_distinct(anyelement) (
     SERIALFUNC = theta_sketch_serialize_state,
     DESERIALFUNC = theta_sketch_deserialize_state, 
     FINALFUNC = theta_sketch_get_estimate_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -99,6 +130,7 @@ CREATE OR REPLACE AGGREGATE theta_sketch_distinct(anyelement, int) (
     SERIALFUNC = theta_sketch_serialize_state,
     DESERIALFUNC = theta_sketch_deserialize_state, 
     FINALFUNC = theta_sketch_get_estimate_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -109,6 +141,7 @@ CREATE OR REPLACE AGGREGATE theta_sketch_build(anyelement) (
     SERIALFUNC = theta_sketch_serialize_state,
     DESERIALFUNC = theta_sketch_deserialize_state, 
     FINALFUNC = theta_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -119,6 +152,7 @@ CREATE OR REPLACE AGGREGATE theta_sketch_build(anyelement, int) (
     SERIALFUNC = theta_sketch_serialize_state,
     DESERIALFUNC = theta_sketch_deserialize_state, 
     FINALFUNC = theta_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -129,6 +163,41 @@ CREATE OR REPLACE AGGREGATE theta_sketch_build(anyelement, int, real) (
     SERIALFUNC = theta_sketch_serialize_state,
     DESERIALFUNC = theta_sketch_deserialize_state, 
     FINALFUNC = theta_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+-- from datasketches_hash, the sketches can only be merged with sketches built from hashes
+CREATE OR REPLACE AGGREGATE theta_sketch_build_from_hash(bigint) (
+    STYPE = internal,
+    SFUNC = theta_sketch_build_agg,
+    COMBINEFUNC = theta_sketch_union_combine,
+    SERIALFUNC = theta_sketch_serialize_state,
+    DESERIALFUNC = theta_sketch_deserialize_state, 
+    FINALFUNC = theta_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE theta_sketch_build_from_hash(bigint, int) (
+    STYPE = internal,
+    SFUNC = theta_sketch_build_agg,
+    COMBINEFUNC = theta_sketch_union_combine,
+    SERIALFUNC = theta_sketch_serialize_state,
+    DESERIALFUNC = theta_sketch_deserialize_state, 
+    FINALFUNC = theta_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE theta_sketch_build_from_hash(bigint, int, real) (
+    STYPE = internal,
+    SFUNC = theta_sketch_build_agg,
+    COMBINEFUNC = theta_sketch_union_combine,
+    SERIALFUNC = theta_sketch_serialize_state,
+    DESERIALFUNC = theta_sketch_deserialize_state, 
+    FINALFUNC = theta_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -139,6 +208,12 @@ CREATE OR REPLACE AGGREGATE theta_sketch_union(theta_sketch) (
     SERIALFUNC = theta_sketch_serialize_state,
     DESERIALFUNC = theta_sketch_deserialize_state, 
     FINALFUNC = theta_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    MSTYPE = internal,
+    MSFUNC = theta_sketch_union_moving_agg,
+    MINVFUNC = theta_sketch_union_moving_inv,
+    MFINALFUNC = theta_sketch_union_moving_final,
+    MFINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -149,6 +224,34 @@ CREATE OR REPLACE AGGREGATE theta_sketch_union(theta_sketch, int) (
     SERIALFUNC = theta_sketch_serialize_state,
     DESERIALFUNC = theta_sketch_deserialize_state, 
     FINALFUNC = theta_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    MSTYPE = internal,
+    MSFUNC = theta_sketch_union_moving_agg,
+    MINVFUNC = theta_sketch_union_moving_inv,
+    MFINALFUNC = theta_sketch_union_moving_final,
+    MFINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE theta_sketch_union_distinct(theta_sketch) (
+    STYPE = internal,
+    SFUNC = theta_sketch_union_agg,
+    COMBINEFUNC = theta_sketch_union_combine,
+    SERIALFUNC = theta_sketch_serialize_state,
+    DESERIALFUNC = theta_sketch_deserialize_state,
+    FINALFUNC = theta_sketch_get_estimate_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
+    PARALLEL = SAFE
+);
+
+CREATE OR REPLACE AGGREGATE theta_sketch_union_distinct(theta_sketch, int) (
+    STYPE = internal,
+    SFUNC = theta_sketch_union_agg,
+    COMBINEFUNC = theta_sketch_union_combine,
+    SERIALFUNC = theta_sketch_serialize_state,
+    DESERIALFUNC = theta_sketch_deserialize_state,
+    FINALFUNC = theta_sketch_get_estimate_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -159,6 +262,7 @@ CREATE OR REPLACE AGGREGATE theta_sketch_intersection(theta_sketch) (
     SERIALFUNC = theta_sketch_serialize_state,
     DESERIALFUNC = theta_sketch_deserialize_state, 
     FINALFUNC = theta_sketch_from_internal,
+    FINALFUNC_MODIFY = READ_ONLY,
     PARALLEL = SAFE
 );
 
@@ -178,18 +282,88 @@ CREATE OR REPLACE FUNCTION theta_sketch_to_string(theta_sketch) RETURNS TEXT
     AS '$libdir/datasketches', 'pg_theta_sketch_to_string'
     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
 
+CREATE OR REPLACE FUNCTION theta_sketch_union_support(internal) RETURNS internal
+    AS '$libdir/datasketches', 'pg_sketch_union_support'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
 CREATE OR REPLACE FUNCTION theta_sketch_union(theta_sketch, theta_sketch) RETURNS theta_sketch
     AS '$libdir/datasketches', 'pg_theta_sketch_union'
-    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+    LANGUAGE C IMMUTABLE PARALLEL SAFE
+    SUPPORT theta_sketch_union_support;
 
 CREATE OR REPLACE FUNCTION theta_sketch_union(theta_sketch, theta_sketch, int) RETURNS theta_sketch
     AS '$libdir/datasketches', 'pg_theta_sketch_union'
-    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+    LANGUAGE C IMMUTABLE PARALLEL SAFE
+    SUPPORT theta_sketch_union_support;
 
 CREATE OR REPLACE FUNCTION theta_sketch_intersection(theta_sketch, theta_sketch) RETURNS theta_sketch
     AS '$libdir/datasketches', 'pg_theta_sketch_intersection'
     LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
+CREATE OR REPLACE FUNCTION theta_sketch_union(theta_sketch[]) RETURNS theta_sketch
+    AS '$libdir/datasketches', 'pg_theta_sketch_union_array'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_union(theta_sketch[], int) RETURNS theta_sketch
+    AS '$libdir/datasketches', 'pg_theta_sketch_union_array'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_intersection(theta_sketch[]) RETURNS theta_sketch
+    AS '$libdir/datasketches', 'pg_theta_sketch_intersection_array'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
 CREATE OR REPLACE FUNCTION theta_sketch_a_not_b(theta_sketch, theta_sketch) RETURNS theta_sketch
     AS '$libdir/datasketches', 'pg_theta_sketch_a_not_b'
     LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_eval(text, theta_sketch[]) RETURNS theta_sketch
+    AS '$libdir/datasketches', 'pg_theta_sketch_eval'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_eval(text, theta_sketch[], int) RETURNS theta_sketch
+    AS '$libdir/datasketches', 'pg_theta_sketch_eval'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_eval_estimate(text, theta_sketch[]) RETURNS double precision
+    AS '$libdir/datasketches', 'pg_theta_sketch_eval_estimate'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_eval_estimate(text, theta_sketch[], int) RETURNS double precision
+    AS '$libdir/datasketches', 'pg_theta_sketch_eval_estimate'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_union_estimate(theta_sketch, theta_sketch) RETURNS double precision
+    AS '$libdir/datasketches', 'pg_theta_sketch_union_estimate'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_union_estimate(theta_sketch, theta_sketch, int) RETURNS double precision
+    AS '$libdir/datasketches', 'pg_theta_sketch_union_estimate'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_intersection_estimate(theta_sketch, theta_sketch) RETURNS double precision
+    AS '$libdir/datasketches', 'pg_theta_sketch_intersection_estimate'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_a_not_b_estimate(theta_sketch, theta_sketch) RETURNS double precision
+    AS '$libdir/datasketches', 'pg_theta_sketch_a_not_b_estimate'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_jaccard(theta_sketch, theta_sketch) RETURNS double precision[]
+    AS '$libdir/datasketches', 'pg_theta_sketch_jaccard'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_overlap_matrix(theta_sketch[]) RETURNS double precision[]
+    AS '$libdir/datasketches', 'pg_theta_sketch_overlap_matrix'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_overlap_matrix(theta_sketch[], int) RETURNS double precision[]
+    AS '$libdir/datasketches', 'pg_theta_sketch_overlap_matrix'
+    LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_update_packed(theta_sketch, bytea) RETURNS theta_sketch
+    AS '$libdir/datasketches', 'pg_theta_sketch_update_packed'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION theta_sketch_update_packed(theta_sketch, bytea, int) RETURNS theta_sketch
+    AS '$libdir/datasketches', 'pg_theta_sketch_update_packed'
+    LANGUAGE C IMMUTABLE PARALLEL SAFE;
@@ -0,0 +1,70 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <postgres.h>
+#include <utils/memutils.h>
+
+#include "agg_context.h"
+
+#define SKETCH_AGG_CONTEXT_NAME "datasketches aggregate"
+
+int sketch_agg_memory_budget = 0;
+
+MemoryContext sketch_agg_context(MemoryContext aggcontext, const char* family) {
+  MemoryContext context;
+
+  // there are only a few children (one per sketch family used by the query), no need to cache the lookup
+  for (context = aggcontext->firstchild; context != NULL; context = context->nextchild) {
+#if PG_VERSION_NUM >= 110000
+    if (context->ident != NULL && (context->ident == family || strcmp(context->ident, family) == 0)
+        && strcmp(context->name, SKETCH_AGG_CONTEXT_NAME) == 0) {
+      return context;
+    }
+#else
+    if (strcmp(context->name, family) == 0) return context;
+#endif
+  }
+
+#if PG_VERSION_NUM >= 110000
+  // the name must be a constant, the family goes into the identifier (not copied, families are string literals)
+  context = AllocSetContextCreate(aggcontext, SKETCH_AGG_CONTEXT_NAME, ALLOCSET_DEFAULT_SIZES);
+  MemoryContextSetIdentifier(context, family);
+#else
+  context = AllocSetContextCreate(aggcontext, family, ALLOCSET_DEFAULT_SIZES);
+#endif
+  return context;
+}
+
+unsigned sketch_agg_lg_k(MemoryContext context, MemoryContext pool_context, unsigned lg_k, unsigned min_lg_k) {
+#if PG_VERSION_NUM >= 130000
+  Size allocated;
+  Size budget;
+
+  if (sketch_agg_memory_budget <= 0) return lg_k;
+  // only the blocks of this context are counted, which is cheap enough to do for every new group
+  allocated = MemoryContextMemAllocated(context, false);
+  if (pool_context != NULL) allocated += MemoryContextMemAllocated(pool_context, false);
+  budget = (Size) sketch_agg_memory_budget * 1024;
+  while (allocated > budget && lg_k > min_lg_k) {
+    lg_k--;
+    budget *= 2;
+  }
+#endif
+  return lg_k;
+}
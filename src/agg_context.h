@@ -0,0 +1,38 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef AGG_CONTEXT_H
+#define AGG_CONTEXT_H
+
+// memory context for the aggregate states of one sketch family (such as "theta_sketch")
+// a child of the aggregate context created on first use and shared by all groups of the aggregate,
+// so that the memory of the sketches can be told apart in pg_backend_memory_contexts
+// (as "datasketches aggregate" with the family as identifier) and is released in bulk with the aggregate context
+MemoryContext sketch_agg_context(MemoryContext aggcontext, const char* family);
+
+// datasketches.agg_memory_budget in kB, 0 means no limit
+extern int sketch_agg_memory_budget;
+
+// lg_k for a new aggregate state in the given family context: once the memory of the context
+// passes the budget, lg_k is reduced by one for every doubling past it, but not below min_lg_k
+// the sketches of an object pool (see fn_cache.h) live outside of the family context, so its context is counted as well
+// (memory accounting needs PG 13, the budget is ignored with older versions)
+unsigned sketch_agg_lg_k(MemoryContext context, MemoryContext pool_context, unsigned lg_k, unsigned min_lg_k);
+
+#endif
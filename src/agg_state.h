@@ -22,10 +22,13 @@
 
 enum agg_state_type { MUTABLE_SKETCH, IMMUTABLE_SKETCH, UNION, INTERSECTION };
 
+struct object_pool;
+
 struct agg_state {
   enum agg_state_type type;
   unsigned lg_k;
   void* ptr;
+  struct object_pool* pool; // the sketch or union is pooled if not NULL, see fn_cache.h
 };
 
 #endif
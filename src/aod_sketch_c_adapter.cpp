@@ -24,6 +24,9 @@
 
 #include <array_of_doubles_sketch.hpp>
 
+#include <cstring>
+#include <iterator>
+
 #include <boost/accumulators/accumulators.hpp>
 #include <boost/accumulators/statistics/stats.hpp>
 #include <boost/accumulators/statistics/mean.hpp>
@@ -38,6 +41,102 @@ using aod_union_pg = datasketches::array_tuple_union<aod>;
 using aod_intersection_pg = datasketches::array_tuple_intersection<aod, datasketches::default_array_tuple_union_policy<aod>>;
 using aod_a_not_b_pg = datasketches::array_tuple_a_not_b<aod>;
 
+// read-only view of a serialized compact array of doubles sketch
+// provides what union, intersection and a-not-b need from an input sketch without copying the entries
+// layout: preamble longs, serial version, family, sketch type, flags, num values, seed hash (2 bytes), theta (8 bytes),
+// then if there are entries: num entries (4 bytes), unused (4 bytes), keys (8 bytes each), values (num values doubles per entry)
+class wrapped_compact_aod_sketch {
+public:
+  using entry_type = std::pair<uint64_t, aod>;
+
+  // entries are materialized one at a time into a buffer owned by the iterator
+  class const_iterator {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = entry_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const entry_type*;
+    using reference = const entry_type&;
+
+    const_iterator(const char* keys, const char* values, uint8_t num_values, uint32_t index):
+    keys_(keys), values_(values), num_values_(num_values), index_(index), entry_(0, aod(num_values, 0)) {}
+
+    const_iterator& operator++() { ++index_; return *this; }
+    const_iterator operator++(int) { const_iterator tmp(*this); ++index_; return tmp; }
+    bool operator==(const const_iterator& other) const { return index_ == other.index_; }
+    bool operator!=(const const_iterator& other) const { return index_ != other.index_; }
+    reference operator*() const {
+      std::memcpy(&entry_.first, keys_ + sizeof(uint64_t) * index_, sizeof(uint64_t));
+      std::memcpy(entry_.second.data(), values_ + sizeof(double) * num_values_ * index_, sizeof(double) * num_values_);
+      return entry_;
+    }
+    pointer operator->() const { return &**this; }
+
+  private:
+    const char* keys_;
+    const char* values_;
+    uint8_t num_values_;
+    uint32_t index_;
+    mutable entry_type entry_;
+  };
+
+  static wrapped_compact_aod_sketch wrap(const void* data, size_t size) {
+    static const uint8_t SERIAL_VERSION = 1;
+    static const uint8_t SKETCH_FAMILY = 9;
+    static const uint8_t SKETCH_TYPE = 3;
+    static const uint8_t FLAG_EMPTY = 4;
+    static const uint8_t FLAG_HAS_ENTRIES = 8;
+    static const uint8_t FLAG_ORDERED = 16;
+    static const uint16_t default_seed_hash = datasketches::compute_seed_hash(datasketches::DEFAULT_SEED);
+    const char* ptr = static_cast<const char*>(data);
+    if (size < 16) throw std::out_of_range("at least 16 bytes expected, actual " + std::to_string(size));
+    if (ptr[1] != SERIAL_VERSION) throw std::invalid_argument("serial version mismatch");
+    if (ptr[2] != SKETCH_FAMILY) throw std::invalid_argument("sketch family mismatch");
+    if (ptr[3] != SKETCH_TYPE) throw std::invalid_argument("sketch type mismatch");
+    const uint8_t flags = ptr[4];
+    const uint8_t num_values = ptr[5];
+    uint16_t seed_hash;
+    std::memcpy(&seed_hash, ptr + 6, sizeof(seed_hash));
+    uint64_t theta;
+    std::memcpy(&theta, ptr + 8, sizeof(theta));
+    uint32_t num_entries = 0;
+    if (flags & FLAG_HAS_ENTRIES) {
+      if (seed_hash != default_seed_hash) throw std::invalid_argument("seed hash mismatch");
+      if (size < 24) throw std::out_of_range("at least 24 bytes expected, actual " + std::to_string(size));
+      std::memcpy(&num_entries, ptr + 16, sizeof(num_entries));
+      const size_t expected_size = 24 + (sizeof(uint64_t) + sizeof(double) * num_values) * static_cast<size_t>(num_entries);
+      if (size < expected_size) throw std::out_of_range("at least " + std::to_string(expected_size) + " bytes expected, actual " + std::to_string(size));
+    }
+    return wrapped_compact_aod_sketch(flags & FLAG_EMPTY, flags & FLAG_ORDERED, seed_hash, theta, num_values,
+        num_entries, ptr + 24, ptr + 24 + sizeof(uint64_t) * num_entries);
+  }
+
+  bool is_empty() const { return is_empty_; }
+  bool is_ordered() const { return is_ordered_; }
+  uint16_t get_seed_hash() const { return seed_hash_; }
+  uint64_t get_theta64() const { return theta_; }
+  uint32_t get_num_retained() const { return num_entries_; }
+  uint8_t get_num_values() const { return num_values_; }
+
+  const_iterator begin() const { return const_iterator(keys_, values_, num_values_, 0); }
+  const_iterator end() const { return const_iterator(keys_, values_, 0, num_entries_); }
+
+private:
+  bool is_empty_;
+  bool is_ordered_;
+  uint16_t seed_hash_;
+  uint64_t theta_;
+  uint8_t num_values_;
+  uint32_t num_entries_;
+  const char* keys_;
+  const char* values_;
+
+  wrapped_compact_aod_sketch(bool is_empty, bool is_ordered, uint16_t seed_hash, uint64_t theta, uint8_t num_values,
+      uint32_t num_entries, const char* keys, const char* values):
+  is_empty_(is_empty), is_ordered_(is_ordered), seed_hash_(seed_hash), theta_(theta), num_values_(num_values),
+  num_entries_(num_entries), keys_(keys), values_(values) {}
+};
+
 std::ostream& operator<<(std::ostream& os, const aod& v) {
   os << "(";
   for (size_t i = 0; i < v.size(); ++i) {
@@ -113,6 +212,34 @@ void* aod_sketch_compact(void* sketchptr) {
   pg_unreachable();
 }
 
+// for intermediate aggregate states, skips sorting
+void* aod_sketch_compact_unordered(void* sketchptr) {
+  try {
+    auto newptr = new (palloc(sizeof(compact_aod_sketch_pg))) compact_aod_sketch_pg(static_cast<update_aod_sketch_pg*>(sketchptr)->compact(false));
+    static_cast<update_aod_sketch_pg*>(sketchptr)->~update_aod_sketch_pg();
+    pfree(sketchptr);
+    return newptr;
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+  pg_unreachable();
+}
+
+// intermediate states may be unordered, results of final functions are ordered
+void* compact_aod_sketch_ordered(void* sketchptr) {
+  try {
+    auto sketch = static_cast<compact_aod_sketch_pg*>(sketchptr);
+    if (sketch->is_ordered()) return sketchptr;
+    auto newptr = new (palloc(sizeof(compact_aod_sketch_pg))) compact_aod_sketch_pg(*sketch, true);
+    sketch->~compact_aod_sketch_pg();
+    pfree(sketchptr);
+    return newptr;
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+  pg_unreachable();
+}
+
 double update_aod_sketch_get_estimate(const void* sketchptr) {
   try {
     return static_cast<const update_aod_sketch_pg*>(sketchptr)->get_estimate();
@@ -167,6 +294,15 @@ unsigned aod_sketch_get_num_values(const void* sketchptr) {
   pg_unreachable();
 }
 
+unsigned aod_sketch_get_num_values_from_bytes(const void* buffer, unsigned length) {
+  try {
+    return wrapped_compact_aod_sketch::wrap(buffer, length).get_num_values();
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+  pg_unreachable();
+}
+
 ptr_with_size aod_sketch_serialize(const void* sketchptr, unsigned header_size) {
   try {
     ptr_with_size p;
@@ -226,6 +362,23 @@ void aod_union_update(void* unionptr, const void* sketchptr) {
   }
 }
 
+void aod_union_update_with_update_sketch(void* unionptr, const void* sketchptr) {
+  try {
+    static_cast<aod_union_pg*>(unionptr)->update(*static_cast<const update_aod_sketch_pg*>(sketchptr));
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+}
+
+void aod_union_update_with_bytes(void* unionptr, const void* buffer, unsigned length) {
+  try {
+    const auto sketch = wrapped_compact_aod_sketch::wrap(buffer, length);
+    static_cast<aod_union_pg*>(unionptr)->update(sketch);
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+}
+
 void* aod_union_get_result(void* unionptr) {
   try {
     auto sketchptr = new (palloc(sizeof(compact_aod_sketch_pg))) compact_aod_sketch_pg(static_cast<const aod_union_pg*>(unionptr)->get_result());
@@ -238,6 +391,19 @@ void* aod_union_get_result(void* unionptr) {
   pg_unreachable();
 }
 
+// for intermediate aggregate states, skips sorting
+void* aod_union_get_result_unordered(void* unionptr) {
+  try {
+    auto sketchptr = new (palloc(sizeof(compact_aod_sketch_pg))) compact_aod_sketch_pg(static_cast<const aod_union_pg*>(unionptr)->get_result(false));
+    static_cast<aod_union_pg*>(unionptr)->~aod_union_pg();
+    pfree(unionptr);
+    return sketchptr;
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+  pg_unreachable();
+}
+
 void* aod_intersection_new(unsigned num_values) {
   try {
     return new (palloc(sizeof(aod_intersection_pg))) aod_intersection_pg(datasketches::DEFAULT_SEED, num_values);
@@ -264,6 +430,15 @@ void aod_intersection_update(void* interptr, const void* sketchptr) {
   }
 }
 
+void aod_intersection_update_with_bytes(void* interptr, const void* buffer, unsigned length) {
+  try {
+    const auto sketch = wrapped_compact_aod_sketch::wrap(buffer, length);
+    static_cast<aod_intersection_pg*>(interptr)->update(sketch);
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+}
+
 void* aod_intersection_get_result(void* interptr) {
   try {
     auto sketchptr = new (palloc(sizeof(compact_aod_sketch_pg))) compact_aod_sketch_pg(static_cast<aod_intersection_pg*>(interptr)->get_result());
@@ -289,6 +464,20 @@ void* aod_a_not_b(const void* sketchptr1, const void* sketchptr2) {
   pg_unreachable();
 }
 
+// the result is built from the entries of A, so only B is wrapped
+void* aod_a_not_b_with_bytes(const void* sketchptr1, const void* buffer2, unsigned length2) {
+  try {
+    aod_a_not_b_pg a_not_b;
+    return new (palloc(sizeof(compact_aod_sketch_pg))) compact_aod_sketch_pg(a_not_b.compute(
+      *static_cast<const compact_aod_sketch_pg*>(sketchptr1),
+      wrapped_compact_aod_sketch::wrap(buffer2, length2)
+    ));
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+  pg_unreachable();
+}
+
 void* aod_sketch_to_kll_float_sketch(const void* sketchptr, unsigned column_index, unsigned k) {
   try {
     auto kllptr = kll_float_sketch_new(k);
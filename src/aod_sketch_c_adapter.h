@@ -34,12 +34,15 @@ void compact_aod_sketch_delete(void* sketchptr);
 
 void aod_sketch_update(void* sketchptr, const void* data, unsigned length, const double* values);
 void* aod_sketch_compact(void* sketchptr);
+void* aod_sketch_compact_unordered(void* sketchptr);
+void* compact_aod_sketch_ordered(void* sketchptr);
 void aod_sketch_union(void* sketchptr1, const void* sketchptr2);
 double update_aod_sketch_get_estimate(const void* sketchptr);
 double compact_aod_sketch_get_estimate(const void* sketchptr);
 void** aod_sketch_get_estimate_and_bounds(const void* sketchptr, unsigned num_std_devs);
 char* aod_sketch_to_string(const void* sketchptr, bool print_entries);
 unsigned aod_sketch_get_num_values(const void* sketchptr);
+unsigned aod_sketch_get_num_values_from_bytes(const void* buffer, unsigned length);
 
 struct ptr_with_size aod_sketch_serialize(const void* sketchptr, unsigned header_size);
 void* aod_sketch_deserialize(const char* buffer, unsigned length);
@@ -48,14 +51,19 @@ void* aod_union_new(unsigned num_values);
 void* aod_union_new_lgk(unsigned num_values, unsigned lg_k);
 void aod_union_delete(void* unionptr);
 void aod_union_update(void* unionptr, const void* sketchptr);
+void aod_union_update_with_update_sketch(void* unionptr, const void* sketchptr);
+void aod_union_update_with_bytes(void* unionptr, const void* buffer, unsigned length);
 void* aod_union_get_result(void* unionptr);
+void* aod_union_get_result_unordered(void* unionptr);
 
 void* aod_intersection_new(unsigned num_values);
 void aod_intersection_delete(void* interptr);
 void aod_intersection_update(void* interptr, const void* sketchptr);
+void aod_intersection_update_with_bytes(void* interptr, const void* buffer, unsigned length);
 void* aod_intersection_get_result(void* interptr);
 
 void* aod_a_not_b(const void* sketchptr1, const void* sketchptr2);
+void* aod_a_not_b_with_bytes(const void* sketchptr1, const void* buffer2, unsigned length2);
 
 void* aod_sketch_to_kll_float_sketch(const void* sketchptr, unsigned column_index, unsigned k);
 
@@ -26,6 +26,9 @@
 
 #include "aod_sketch_c_adapter.h"
 #include "kll_float_sketch_c_adapter.h"
+#include "fn_cache.h"
+#include "agg_context.h"
+#include "sketch_array.h"
 
 enum aod_agg_state_type { MUTABLE_SKETCH, IMMUTABLE_SKETCH, UNION, INTERSECTION };
 
@@ -55,6 +58,8 @@ PG_FUNCTION_INFO_V1(pg_aod_sketch_to_kll_float_sketch);
 PG_FUNCTION_INFO_V1(pg_aod_sketch_students_t_test);
 PG_FUNCTION_INFO_V1(pg_aod_sketch_to_means);
 PG_FUNCTION_INFO_V1(pg_aod_sketch_to_variances);
+PG_FUNCTION_INFO_V1(pg_aod_sketch_union_array);
+PG_FUNCTION_INFO_V1(pg_aod_sketch_intersection_array);
 
 /* function declarations */
 Datum pg_aod_sketch_build_agg(PG_FUNCTION_ARGS);
@@ -75,24 +80,19 @@ Datum pg_aod_sketch_to_kll_float_sketch(PG_FUNCTION_ARGS);
 Datum pg_aod_sketch_students_t_test(PG_FUNCTION_ARGS);
 Datum pg_aod_sketch_to_means(PG_FUNCTION_ARGS);
 Datum pg_aod_sketch_to_variances(PG_FUNCTION_ARGS);
+Datum pg_aod_sketch_union_array(PG_FUNCTION_ARGS);
+Datum pg_aod_sketch_intersection_array(PG_FUNCTION_ARGS);
 
 Datum pg_aod_sketch_build_agg(PG_FUNCTION_ARGS) {
   struct aod_agg_state* stateptr;
   float p;
 
   // anyelement
-  Oid   element_type;
-  Datum element;
-  int16 typlen;
-  bool  typbyval;
-  char  typalign;
+  const void* element;
+  unsigned length;
 
   // input array of doubles
   ArrayType* arr_in;
-  Oid elmtype_in;
-  int16 elmlen_in;
-  bool elmbyval_in;
-  char elmalign_in;
   Datum* data_in;
   bool* nulls_in;
   int arr_len;
@@ -111,13 +111,12 @@ Datum pg_aod_sketch_build_agg(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "aod_sketch_build_agg called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "aod_sketch"));
 
   // look at the array of values first to know the array length in case we need to create a new sketch
+  // the argument is declared as double precision[], no need to look up the element type
   arr_in = PG_GETARG_ARRAYTYPE_P(2);
-  elmtype_in = ARR_ELEMTYPE(arr_in);
-  get_typlenbyvalalign(elmtype_in, &elmlen_in, &elmbyval_in, &elmalign_in);
-  deconstruct_array(arr_in, elmtype_in, elmlen_in, elmbyval_in, elmalign_in, &data_in, &nulls_in, &arr_len);
+  deconstruct_array(arr_in, FLOAT8OID, sizeof(float8), FLOAT8PASSBYVAL, 'd', &data_in, &nulls_in, &arr_len);
 
   values = palloc(sizeof(double) * arr_len);
   for (i = 0; i < arr_len; i++) {
@@ -139,19 +138,8 @@ Datum pg_aod_sketch_build_agg(PG_FUNCTION_ARGS) {
     stateptr = (struct aod_agg_state*) PG_GETARG_POINTER(0);
   }
 
-  element_type = get_fn_expr_argtype(fcinfo->flinfo, 1);
-  element = PG_GETARG_DATUM(1);
-  get_typlenbyvalalign(element_type, &typlen, &typbyval, &typalign);
-  if (typlen == -1) {
-    // varlena
-    aod_sketch_update(stateptr->ptr, VARDATA_ANY(element), VARSIZE_ANY_EXHDR(element), values);
-  } else if (typbyval) {
-    // fixed-length passed by value
-    aod_sketch_update(stateptr->ptr, &element, typlen, values);
-  } else {
-    // fixed-length passed by reference
-    aod_sketch_update(stateptr->ptr, (void*)element, typlen, values);
-  }
+  element = fn_cache_get_element(fcinfo, 1, &length);
+  aod_sketch_update(stateptr->ptr, element, length, values);
   pfree(values);
   MemoryContextSwitchTo(oldcontext);
 
@@ -161,7 +149,6 @@ Datum pg_aod_sketch_build_agg(PG_FUNCTION_ARGS) {
 Datum pg_aod_sketch_union_agg(PG_FUNCTION_ARGS) {
   struct aod_agg_state* stateptr;
   bytea* sketch_bytes;
-  void* sketchptr;
 
   MemoryContext oldcontext;
   MemoryContext aggcontext;
@@ -175,7 +162,7 @@ Datum pg_aod_sketch_union_agg(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "aod_sketch_union_agg called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "aod_sketch"));
 
   if (PG_ARGISNULL(0)) {
     stateptr = palloc(sizeof(struct aod_agg_state));
@@ -187,14 +174,11 @@ Datum pg_aod_sketch_union_agg(PG_FUNCTION_ARGS) {
     stateptr = (struct aod_agg_state*) PG_GETARG_POINTER(0);
   }
 
-  sketch_bytes = PG_GETARG_BYTEA_P(1);
-  sketchptr = aod_sketch_deserialize(VARDATA(sketch_bytes), VARSIZE(sketch_bytes) - VARHDRSZ);
-  if (stateptr->num_values != aod_sketch_get_num_values(sketchptr)) {
-    compact_aod_sketch_delete(sketchptr);
+  sketch_bytes = PG_GETARG_BYTEA_PP(1);
+  if (stateptr->num_values != aod_sketch_get_num_values_from_bytes(VARDATA_ANY(sketch_bytes), VARSIZE_ANY_EXHDR(sketch_bytes))) {
     elog(ERROR, "pg_aod_sketch_union_agg expects the same num_values in sketches");
   }
-  aod_union_update(stateptr->ptr, sketchptr);
-  compact_aod_sketch_delete(sketchptr);
+  aod_union_update_with_bytes(stateptr->ptr, VARDATA_ANY(sketch_bytes), VARSIZE_ANY_EXHDR(sketch_bytes));
 
   MemoryContextSwitchTo(oldcontext);
 
@@ -204,7 +188,6 @@ Datum pg_aod_sketch_union_agg(PG_FUNCTION_ARGS) {
 Datum pg_aod_sketch_intersection_agg(PG_FUNCTION_ARGS) {
   struct aod_agg_state* stateptr;
   bytea* sketch_bytes;
-  void* sketchptr;
 
   MemoryContext oldcontext;
   MemoryContext aggcontext;
@@ -218,7 +201,7 @@ Datum pg_aod_sketch_intersection_agg(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "aod_sketch_intersection_agg called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "aod_sketch"));
 
   if (PG_ARGISNULL(0)) {
     stateptr = palloc(sizeof(struct aod_agg_state));
@@ -229,10 +212,8 @@ Datum pg_aod_sketch_intersection_agg(PG_FUNCTION_ARGS) {
     stateptr = (struct aod_agg_state*) PG_GETARG_POINTER(0);
   }
 
-  sketch_bytes = PG_GETARG_BYTEA_P(1);
-  sketchptr = aod_sketch_deserialize(VARDATA(sketch_bytes), VARSIZE(sketch_bytes) - VARHDRSZ);
-  aod_intersection_update(stateptr->ptr, sketchptr);
-  compact_aod_sketch_delete(sketchptr);
+  sketch_bytes = PG_GETARG_BYTEA_PP(1);
+  aod_intersection_update_with_bytes(stateptr->ptr, VARDATA_ANY(sketch_bytes), VARSIZE_ANY_EXHDR(sketch_bytes));
 
   MemoryContextSwitchTo(oldcontext);
 
@@ -251,7 +232,7 @@ Datum pg_aod_sketch_from_internal(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "aod_sketch_from_internal called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "aod_sketch"));
 
   stateptr = (struct aod_agg_state*) PG_GETARG_POINTER(0);
   if (stateptr->type == MUTABLE_SKETCH) {
@@ -260,6 +241,8 @@ Datum pg_aod_sketch_from_internal(PG_FUNCTION_ARGS) {
     stateptr->ptr = aod_union_get_result(stateptr->ptr);
   } else if (stateptr->type == INTERSECTION) {
     stateptr->ptr = aod_intersection_get_result(stateptr->ptr);
+  } else {
+    stateptr->ptr = compact_aod_sketch_ordered(stateptr->ptr);
   }
   bytes_out = aod_sketch_serialize(stateptr->ptr, VARHDRSZ);
   compact_aod_sketch_delete(stateptr->ptr);
@@ -271,10 +254,25 @@ Datum pg_aod_sketch_from_internal(PG_FUNCTION_ARGS) {
   PG_RETURN_BYTEA_P(bytes_out.ptr);
 }
 
+// updates the union with the sketch or union of the state, which is consumed
+static void aod_union_update_with_state(void* unionptr, struct aod_agg_state* stateptr) {
+  if (stateptr->type == MUTABLE_SKETCH) {
+    aod_union_update_with_update_sketch(unionptr, stateptr->ptr);
+    update_aod_sketch_delete(stateptr->ptr);
+    return;
+  }
+  if (stateptr->type == UNION) {
+    stateptr->ptr = aod_union_get_result_unordered(stateptr->ptr);
+  }
+  aod_union_update(unionptr, stateptr->ptr);
+  compact_aod_sketch_delete(stateptr->ptr);
+}
+
 Datum pg_aod_sketch_union_combine(PG_FUNCTION_ARGS) {
   struct aod_agg_state* stateptr1;
   struct aod_agg_state* stateptr2;
   struct aod_agg_state* stateptr;
+  void* unionptr;
 
   MemoryContext oldcontext;
   MemoryContext aggcontext;
@@ -284,37 +282,28 @@ Datum pg_aod_sketch_union_combine(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "aod_sketch_union_combine called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "aod_sketch"));
 
   stateptr1 = (struct aod_agg_state*) PG_GETARG_POINTER(0);
   stateptr2 = (struct aod_agg_state*) PG_GETARG_POINTER(1);
 
-  stateptr = palloc(sizeof(struct aod_agg_state));
-  stateptr->type = IMMUTABLE_SKETCH;
-  stateptr->lg_k = stateptr1 ? stateptr1->lg_k : stateptr2->lg_k;
-  stateptr->num_values = stateptr1 ? stateptr1->num_values : stateptr2->num_values;
-  stateptr->ptr = stateptr->lg_k ? aod_union_new_lgk(stateptr->num_values, stateptr->lg_k) : aod_union_new(stateptr->num_values);
-  if (stateptr1) {
-    if (stateptr1->type == UNION) {
-      stateptr1->ptr = aod_union_get_result(stateptr1->ptr);
-    } else if (stateptr1->type == MUTABLE_SKETCH) {
-      stateptr1->ptr = aod_sketch_compact(stateptr1->ptr);
-    }
-    aod_union_update(stateptr->ptr, stateptr1->ptr);
-    compact_aod_sketch_delete(stateptr1->ptr);
-    pfree(stateptr1);
-  }
-  if (stateptr2) {
-    if (stateptr2->type == UNION) {
-      stateptr2->ptr = aod_union_get_result(stateptr2->ptr);
-    } else if (stateptr2->type == MUTABLE_SKETCH) {
-      stateptr2->ptr = aod_sketch_compact(stateptr2->ptr);
+  // the second state is merged into the first one, which becomes a union if it is not one yet
+  // the result is left as a union and compacted (ordered) only by the final function
+  if (stateptr1 == NULL) {
+    stateptr = stateptr2;
+  } else {
+    stateptr = stateptr1;
+    if (stateptr2) {
+      if (stateptr->type != UNION) {
+        unionptr = stateptr->lg_k ? aod_union_new_lgk(stateptr->num_values, stateptr->lg_k) : aod_union_new(stateptr->num_values);
+        aod_union_update_with_state(unionptr, stateptr);
+        stateptr->type = UNION;
+        stateptr->ptr = unionptr;
+      }
+      aod_union_update_with_state(stateptr->ptr, stateptr2);
+      pfree(stateptr2);
     }
-    aod_union_update(stateptr->ptr, stateptr2->ptr);
-    compact_aod_sketch_delete(stateptr2->ptr);
-    pfree(stateptr2);
   }
-  stateptr->ptr = aod_union_get_result(stateptr->ptr);
 
   MemoryContextSwitchTo(oldcontext);
 
@@ -334,7 +323,7 @@ Datum pg_aod_sketch_intersection_combine(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "aod_sketch_intersection_combine called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "aod_sketch"));
 
   stateptr1 = (struct aod_agg_state*) PG_GETARG_POINTER(0);
   stateptr2 = (struct aod_agg_state*) PG_GETARG_POINTER(1);
@@ -378,13 +367,14 @@ Datum pg_aod_sketch_serialize_state(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "aod_sketch_serialize_state called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "aod_sketch"));
 
   stateptr = (struct aod_agg_state*) PG_GETARG_POINTER(0);
+  // intermediate state, ordering is left to the final function
   if (stateptr->type == MUTABLE_SKETCH) {
-    stateptr->ptr = aod_sketch_compact(stateptr->ptr);
+    stateptr->ptr = aod_sketch_compact_unordered(stateptr->ptr);
   } else if (stateptr->type == UNION) {
-    stateptr->ptr = aod_union_get_result(stateptr->ptr);
+    stateptr->ptr = aod_union_get_result_unordered(stateptr->ptr);
   } else if (stateptr->type == INTERSECTION) {
     stateptr->ptr = aod_intersection_get_result(stateptr->ptr);
   }
@@ -412,7 +402,7 @@ Datum pg_aod_sketch_deserialize_state(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "aod_sketch_deserialize_state called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "aod_sketch"));
 
   bytes_in = PG_GETARG_BYTEA_P(0);
   stateptr = palloc(sizeof(struct aod_agg_state));
@@ -477,8 +467,6 @@ Datum pg_aod_sketch_to_string(PG_FUNCTION_ARGS) {
 Datum pg_aod_sketch_union(PG_FUNCTION_ARGS) {
   const bytea* bytes_in1;
   const bytea* bytes_in2;
-  void* sketchptr1;
-  void* sketchptr2;
   void* unionptr;
   void* sketchptr;
   struct ptr_with_size bytes_out;
@@ -489,19 +477,14 @@ Datum pg_aod_sketch_union(PG_FUNCTION_ARGS) {
   lg_k = PG_NARGS() > 3 ? PG_GETARG_INT32(3) : 0;
   unionptr = lg_k ? aod_union_new_lgk(num_values, lg_k) : aod_union_new(num_values);
   if (!PG_ARGISNULL(0)) {
-    bytes_in1 = PG_GETARG_BYTEA_P(0);
-    sketchptr1 = aod_sketch_deserialize(VARDATA(bytes_in1), VARSIZE(bytes_in1) - VARHDRSZ);
-    aod_union_update(unionptr, sketchptr1);
-    compact_aod_sketch_delete(sketchptr1);
+    bytes_in1 = PG_GETARG_BYTEA_PP(0);
+    aod_union_update_with_bytes(unionptr, VARDATA_ANY(bytes_in1), VARSIZE_ANY_EXHDR(bytes_in1));
   }
   if (!PG_ARGISNULL(1)) {
-    bytes_in2 = PG_GETARG_BYTEA_P(1);
-    sketchptr2 = aod_sketch_deserialize(VARDATA(bytes_in2), VARSIZE(bytes_in2) - VARHDRSZ);
-    aod_union_update(unionptr, sketchptr2);
-    compact_aod_sketch_delete(sketchptr2);
+    bytes_in2 = PG_GETARG_BYTEA_PP(1);
+    aod_union_update_with_bytes(unionptr, VARDATA_ANY(bytes_in2), VARSIZE_ANY_EXHDR(bytes_in2));
   }
   sketchptr = aod_union_get_result(unionptr);
-  aod_union_delete(unionptr);
   bytes_out = aod_sketch_serialize(sketchptr, VARHDRSZ);
   compact_aod_sketch_delete(sketchptr);
   SET_VARSIZE(bytes_out.ptr, bytes_out.size);
@@ -511,8 +494,6 @@ Datum pg_aod_sketch_union(PG_FUNCTION_ARGS) {
 Datum pg_aod_sketch_intersection(PG_FUNCTION_ARGS) {
   const bytea* bytes_in1;
   const bytea* bytes_in2;
-  void* sketchptr1;
-  void* sketchptr2;
   void* interptr;
   void* sketchptr;
   struct ptr_with_size bytes_out;
@@ -521,19 +502,14 @@ Datum pg_aod_sketch_intersection(PG_FUNCTION_ARGS) {
   num_values = PG_NARGS() > 2 ? PG_GETARG_INT32(2) : 1;
   interptr = aod_intersection_new(num_values);
   if (!PG_ARGISNULL(0)) {
-    bytes_in1 = PG_GETARG_BYTEA_P(0);
-    sketchptr1 = aod_sketch_deserialize(VARDATA(bytes_in1), VARSIZE(bytes_in1) - VARHDRSZ);
-    aod_intersection_update(interptr, sketchptr1);
-    compact_aod_sketch_delete(sketchptr1);
+    bytes_in1 = PG_GETARG_BYTEA_PP(0);
+    aod_intersection_update_with_bytes(interptr, VARDATA_ANY(bytes_in1), VARSIZE_ANY_EXHDR(bytes_in1));
   }
   if (!PG_ARGISNULL(1)) {
-    bytes_in2 = PG_GETARG_BYTEA_P(1);
-    sketchptr2 = aod_sketch_deserialize(VARDATA(bytes_in2), VARSIZE(bytes_in2) - VARHDRSZ);
-    aod_intersection_update(interptr, sketchptr2);
-    compact_aod_sketch_delete(sketchptr2);
+    bytes_in2 = PG_GETARG_BYTEA_PP(1);
+    aod_intersection_update_with_bytes(interptr, VARDATA_ANY(bytes_in2), VARSIZE_ANY_EXHDR(bytes_in2));
   }
   sketchptr = aod_intersection_get_result(interptr);
-  aod_intersection_delete(interptr);
   bytes_out = aod_sketch_serialize(sketchptr, VARHDRSZ);
   compact_aod_sketch_delete(sketchptr);
   SET_VARSIZE(bytes_out.ptr, bytes_out.size);
@@ -544,7 +520,6 @@ Datum pg_aod_sketch_a_not_b(PG_FUNCTION_ARGS) {
   const bytea* bytes_in1;
   const bytea* bytes_in2;
   void* sketchptr1;
-  void* sketchptr2;
   void* sketchptr;
   struct ptr_with_size bytes_out;
 
@@ -554,11 +529,9 @@ Datum pg_aod_sketch_a_not_b(PG_FUNCTION_ARGS) {
 
   bytes_in1 = PG_GETARG_BYTEA_P(0);
   sketchptr1 = aod_sketch_deserialize(VARDATA(bytes_in1), VARSIZE(bytes_in1) - VARHDRSZ);
-  bytes_in2 = PG_GETARG_BYTEA_P(1);
-  sketchptr2 = aod_sketch_deserialize(VARDATA(bytes_in2), VARSIZE(bytes_in2) - VARHDRSZ);
-  sketchptr = aod_a_not_b(sketchptr1, sketchptr2);
+  bytes_in2 = PG_GETARG_BYTEA_PP(1);
+  sketchptr = aod_a_not_b_with_bytes(sketchptr1, VARDATA_ANY(bytes_in2), VARSIZE_ANY_EXHDR(bytes_in2));
   compact_aod_sketch_delete(sketchptr1);
-  compact_aod_sketch_delete(sketchptr2);
   bytes_out = aod_sketch_serialize(sketchptr, VARHDRSZ);
   compact_aod_sketch_delete(sketchptr);
   SET_VARSIZE(bytes_out.ptr, bytes_out.size);
@@ -675,3 +648,49 @@ Datum pg_aod_sketch_to_variances(PG_FUNCTION_ARGS) {
 
   PG_RETURN_ARRAYTYPE_P(arr_out);
 }
+
+// the whole array in one call, without serializing intermediate results
+Datum pg_aod_sketch_union_array(PG_FUNCTION_ARGS) {
+  struct sketch_array sketches;
+  void* unionptr;
+  void* sketchptr;
+  struct ptr_with_size bytes_out;
+  int num_values;
+  int lg_k;
+  unsigned i;
+
+  num_values = PG_NARGS() > 1 ? PG_GETARG_INT32(1) : 1;
+  lg_k = PG_NARGS() > 2 ? PG_GETARG_INT32(2) : 0;
+  sketch_array_init(&sketches, PG_GETARG_ARRAYTYPE_P(0), false);
+  unionptr = lg_k ? aod_union_new_lgk(num_values, lg_k) : aod_union_new(num_values);
+  for (i = 0; i < sketches.num_sketches; i++) {
+    aod_union_update_with_bytes(unionptr, sketches.buffers[i], sketches.lengths[i]);
+  }
+  sketchptr = aod_union_get_result(unionptr);
+  bytes_out = aod_sketch_serialize(sketchptr, VARHDRSZ);
+  compact_aod_sketch_delete(sketchptr);
+  SET_VARSIZE(bytes_out.ptr, bytes_out.size);
+  PG_RETURN_BYTEA_P(bytes_out.ptr);
+}
+
+Datum pg_aod_sketch_intersection_array(PG_FUNCTION_ARGS) {
+  struct sketch_array sketches;
+  void* interptr;
+  void* sketchptr;
+  struct ptr_with_size bytes_out;
+  int num_values;
+  unsigned i;
+
+  num_values = PG_NARGS() > 1 ? PG_GETARG_INT32(1) : 1;
+  sketch_array_init(&sketches, PG_GETARG_ARRAYTYPE_P(0), false);
+  if (sketches.num_sketches == 0) PG_RETURN_NULL(); // the intersection of nothing is undefined
+  interptr = aod_intersection_new(num_values);
+  for (i = 0; i < sketches.num_sketches; i++) {
+    aod_intersection_update_with_bytes(interptr, sketches.buffers[i], sketches.lengths[i]);
+  }
+  sketchptr = aod_intersection_get_result(interptr);
+  bytes_out = aod_sketch_serialize(sketchptr, VARHDRSZ);
+  compact_aod_sketch_delete(sketchptr);
+  SET_VARSIZE(bytes_out.ptr, bytes_out.size);
+  PG_RETURN_BYTEA_P(bytes_out.ptr);
+}
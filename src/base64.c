@@ -18,8 +18,14 @@
  */
 
 #include <assert.h>
+#include <string.h>
 #include "base64.h"
 
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define B64_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
 static const char bin_to_b64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
 static const char b64_to_bin[128] = {
@@ -33,10 +39,13 @@ static const char b64_to_bin[128] = {
   41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51,  0,  0,  0,  0,  0
 };
 
-// with full padding
-// produces exactly b64_enc_len(srclen) chars
-// no \0 termination
-void b64_encode(const char* src, unsigned srclen, char* dst) {
+// block codecs work on whole groups at the front of the input
+// encoder: consumes a multiple of 3 bytes, returns the number of bytes consumed
+// decoder: consumes a multiple of 4 chars of the base64 alphabet only (no whitespace, padding or invalid chars),
+// returns the number of chars consumed, produces 3 bytes per 4 chars
+typedef unsigned (*b64_block_fn)(const char* src, unsigned srclen, char* dst);
+
+static void b64_encode_scalar(const char* src, unsigned srclen, char* dst) {
   unsigned buf = 0;
   int pos = 2;
 
@@ -60,18 +69,31 @@ void b64_encode(const char* src, unsigned srclen, char* dst) {
   }
 }
 
-// supports no padding or partial padding (one =)
-// ignores invalid chars (fills zeros instead)
-// produces exactly b64_dec_len(src, srclen) bytes
-void b64_decode(const char* src, unsigned srclen, char* dst) {
+static void b64_encode_with(const char* src, unsigned srclen, char* dst, b64_block_fn encode_block) {
+  const unsigned consumed = encode_block ? encode_block(src, srclen, dst) : 0;
+  b64_encode_scalar(src + consumed, srclen - consumed, dst + consumed / 3 * 4);
+}
+
+// the block decoder is tried at group boundaries only
+// anything it does not accept (whitespace, padding, invalid chars) goes through the scalar path
+static unsigned b64_decode_with(const char* src, unsigned srclen, char* dst, b64_block_fn decode_block) {
+  char* const start = dst;
   unsigned buf = 0;
   char c;
   int bits = 0;
   int pos = 0;
   int pad = 0;
 
-  while (srclen--) {
+  while (srclen) {
+    if (decode_block && pos == 0 && pad == 0) {
+      const unsigned consumed = decode_block(src, srclen, dst);
+      src += consumed;
+      srclen -= consumed;
+      dst += consumed / 4 * 3;
+      if (srclen == 0) break;
+    }
     c = *src++;
+    srclen--;
     if (c == ' ' || c == '\t' || c == '\n' || c == '\r') continue;
     bits = 0;
     if (c != '=') {
@@ -96,6 +118,208 @@ void b64_decode(const char* src, unsigned srclen, char* dst) {
     *dst++ = (buf >> 10) & 0xff;
     if (pad == 0) *dst++ = (buf >> 2) & 0xff;
   }
+  return dst - start;
+}
+
+#ifdef B64_X86_DISPATCH
+
+// vectorized codecs after Wojciech Mula and Daniel Lemire, "Faster Base64 Encoding and Decoding Using AVX2 Instructions"
+
+__attribute__((target("sse4.1")))
+static __m128i b64_enc_translate_sse(__m128i indices) {
+  const __m128i shift_lut = _mm_setr_epi8(
+    'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+    '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0
+  );
+  // 0..51 -> 0, 52..61 -> 1..10, 62 -> 11, 63 -> 12, then 0..25 -> 13
+  __m128i lut_index = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+  const __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+  lut_index = _mm_or_si128(lut_index, _mm_and_si128(less, _mm_set1_epi8(13)));
+  return _mm_add_epi8(indices, _mm_shuffle_epi8(shift_lut, lut_index));
+}
+
+__attribute__((target("sse4.1")))
+static unsigned b64_encode_block_sse(const char* src, unsigned srclen, char* dst) {
+  const __m128i enc_shuffle = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+  unsigned consumed = 0;
+  // each step reads 16 bytes and uses 12 of them
+  while (srclen - consumed >= 16) {
+    const __m128i in = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) (src + consumed)), enc_shuffle);
+    // 12 bytes -> 16 six-bit indices
+    const __m128i indices = _mm_or_si128(
+      _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040)),
+      _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010))
+    );
+    _mm_storeu_si128((__m128i*) dst, b64_enc_translate_sse(indices));
+    consumed += 12;
+    dst += 16;
+  }
+  return consumed;
+}
+
+__attribute__((target("avx2")))
+static unsigned b64_encode_block_avx2(const char* src, unsigned srclen, char* dst) {
+  const __m256i enc_shuffle = _mm256_set_epi8(
+    10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+    10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1
+  );
+  const __m256i shift_lut = _mm256_setr_epi8(
+    'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+    '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+    'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+    '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0
+  );
+  unsigned consumed = 0;
+  // each step reads 28 bytes and uses 24 of them, 12 per lane
+  while (srclen - consumed >= 28) {
+    const __m256i in = _mm256_shuffle_epi8(_mm256_inserti128_si256(
+      _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*) (src + consumed))),
+      _mm_loadu_si128((const __m128i*) (src + consumed + 12)), 1
+    ), enc_shuffle);
+    const __m256i indices = _mm256_or_si256(
+      _mm256_mulhi_epu16(_mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00)), _mm256_set1_epi32(0x04000040)),
+      _mm256_mullo_epi16(_mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0)), _mm256_set1_epi32(0x01000010))
+    );
+    __m256i lut_index = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+    const __m256i less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+    lut_index = _mm256_or_si256(lut_index, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+    _mm256_storeu_si256((__m256i*) dst, _mm256_add_epi8(indices, _mm256_shuffle_epi8(shift_lut, lut_index)));
+    consumed += 24;
+    dst += 32;
+  }
+  return consumed;
+}
+
+// 128-bit helpers are always inlined so that the AVX2 path gets them VEX-encoded
+// calling legacy SSE code with dirty upper halves of ymm registers is very slow on some CPUs
+#define B64_SSE_INLINE __attribute__((target("sse4.1"), always_inline)) static inline
+
+// stores exactly 12 bytes from the low part of the register
+B64_SSE_INLINE void b64_store12_sse(char* dst, __m128i bytes) {
+  const int last = _mm_extract_epi32(bytes, 2);
+  _mm_storel_epi64((__m128i*) dst, bytes);
+  memcpy(dst + 8, &last, 4);
+}
+
+// validates 16 chars and packs them into 12 bytes in the low part of the register
+// returns 0 if any char is outside of the base64 alphabet
+B64_SSE_INLINE int b64_dec_lane_sse(__m128i str, __m128i* out) {
+  const __m128i lut_lo = _mm_setr_epi8(
+    0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A
+  );
+  const __m128i lut_hi = _mm_setr_epi8(
+    0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10
+  );
+  const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m128i mask_2f = _mm_set1_epi8(0x2f);
+  const __m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(str, 4), mask_2f);
+  const __m128i lo = _mm_shuffle_epi8(lut_lo, _mm_and_si128(str, mask_2f));
+  const __m128i hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+  __m128i roll;
+  if (!_mm_testz_si128(lo, hi)) return 0;
+  roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(_mm_cmpeq_epi8(str, mask_2f), hi_nibbles));
+  str = _mm_add_epi8(str, roll);
+  str = _mm_maddubs_epi16(str, _mm_set1_epi32(0x01400140));
+  str = _mm_madd_epi16(str, _mm_set1_epi32(0x00011000));
+  *out = _mm_shuffle_epi8(str, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+  return 1;
+}
+
+B64_SSE_INLINE unsigned b64_decode_lanes_sse(const char* src, unsigned srclen, char* dst) {
+  unsigned consumed = 0;
+  __m128i bytes;
+  while (srclen - consumed >= 16) {
+    if (!b64_dec_lane_sse(_mm_loadu_si128((const __m128i*) (src + consumed)), &bytes)) break;
+    b64_store12_sse(dst, bytes);
+    consumed += 16;
+    dst += 12;
+  }
+  return consumed;
+}
+
+__attribute__((target("sse4.1")))
+static unsigned b64_decode_block_sse(const char* src, unsigned srclen, char* dst) {
+  return b64_decode_lanes_sse(src, srclen, dst);
+}
+
+__attribute__((target("avx2")))
+static unsigned b64_decode_block_avx2(const char* src, unsigned srclen, char* dst) {
+  const __m256i lut_lo = _mm256_setr_epi8(
+    0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+    0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A
+  );
+  const __m256i lut_hi = _mm256_setr_epi8(
+    0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10
+  );
+  const __m256i lut_roll = _mm256_setr_epi8(
+    0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0
+  );
+  const __m256i dec_shuffle = _mm256_setr_epi8(
+    2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+    2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1
+  );
+  const __m256i mask_2f = _mm256_set1_epi8(0x2f);
+  unsigned consumed = 0;
+  while (srclen - consumed >= 32) {
+    __m256i str = _mm256_loadu_si256((const __m256i*) (src + consumed));
+    const __m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(str, 4), mask_2f);
+    const __m256i lo = _mm256_shuffle_epi8(lut_lo, _mm256_and_si256(str, mask_2f));
+    const __m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+    __m256i roll;
+    if (!_mm256_testz_si256(lo, hi)) break;
+    roll = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(_mm256_cmpeq_epi8(str, mask_2f), hi_nibbles));
+    str = _mm256_add_epi8(str, roll);
+    str = _mm256_maddubs_epi16(str, _mm256_set1_epi32(0x01400140));
+    str = _mm256_madd_epi16(str, _mm256_set1_epi32(0x00011000));
+    str = _mm256_shuffle_epi8(str, dec_shuffle);
+    b64_store12_sse(dst, _mm256_castsi256_si128(str));
+    b64_store12_sse(dst + 12, _mm256_extracti128_si256(str, 1));
+    consumed += 32;
+    dst += 24;
+  }
+  // a shorter tail may still fit the 128-bit path
+  return consumed + b64_decode_lanes_sse(src + consumed, srclen - consumed, dst);
+}
+
+#endif // B64_X86_DISPATCH
+
+static int impl_selected = 0;
+static b64_block_fn encode_block_impl = NULL;
+static b64_block_fn decode_block_impl = NULL;
+
+// picked once per backend, scalar only if no suitable instruction set
+static void b64_select_impl(void) {
+#ifdef B64_X86_DISPATCH
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    encode_block_impl = b64_encode_block_avx2;
+    decode_block_impl = b64_decode_block_avx2;
+  } else if (__builtin_cpu_supports("sse4.1")) {
+    encode_block_impl = b64_encode_block_sse;
+    decode_block_impl = b64_decode_block_sse;
+  }
+#endif
+  impl_selected = 1;
+}
+
+// with full padding
+// produces exactly b64_enc_len(srclen) chars
+// no \0 termination
+void b64_encode(const char* src, unsigned srclen, char* dst) {
+  if (!impl_selected) b64_select_impl();
+  b64_encode_with(src, srclen, dst, encode_block_impl);
+}
+
+// supports no padding or partial padding (one =)
+// ignores whitespace
+// ignores invalid chars (fills zeros instead)
+// produces at most b64_dec_len(srclen) bytes
+// returns the number of bytes produced
+unsigned b64_decode(const char* src, unsigned srclen, char* dst) {
+  if (!impl_selected) b64_select_impl();
+  return b64_decode_with(src, srclen, dst, decode_block_impl);
 }
 
 // with padding
@@ -103,9 +327,7 @@ unsigned b64_enc_len(unsigned srclen) {
   return ((srclen + 2) / 3) * 4;
 }
 
-unsigned b64_dec_len(const char* src, unsigned srclen) {
-  unsigned pad = 0;
-  if (srclen > 0 && src[srclen - 1] == '=') pad++;
-  if (srclen > 1 && src[srclen - 2] == '=') pad++;
-  return ((srclen * 3) >> 2) - pad;
+// upper bound on the number of bytes produced by b64_decode
+unsigned b64_dec_len(unsigned srclen) {
+  return (srclen >> 2) * 3 + ((srclen & 3) > 1 ? (srclen & 3) - 1 : 0);
 }
@@ -21,8 +21,8 @@
 #define _BASE64_H_
 
 void b64_encode(const char *src, unsigned srclen, char *dst);
-void b64_decode(const char *src, unsigned srclen, char *dst);
+unsigned b64_decode(const char *src, unsigned srclen, char *dst);
 unsigned b64_enc_len(unsigned srclen);
-unsigned b64_dec_len(const char* src, unsigned srclen);
+unsigned b64_dec_len(unsigned srclen);
 
 #endif // _BASE64_H_
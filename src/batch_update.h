@@ -0,0 +1,39 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef BATCH_UPDATE_H
+#define BATCH_UPDATE_H
+
+#include <cstdint>
+
+// packed batches of the *_update_packed functions are little-endian regardless of the platform
+// the byte-wise loads compile to plain loads on little-endian platforms
+static inline uint64_t load_little_endian_u64(const char* data) {
+  uint64_t value = 0;
+  for (unsigned i = 0; i < 8; ++i) value |= static_cast<uint64_t>(static_cast<uint8_t>(data[i])) << (i << 3);
+  return value;
+}
+
+static inline uint32_t load_little_endian_u32(const char* data) {
+  uint32_t value = 0;
+  for (unsigned i = 0; i < 4; ++i) value |= static_cast<uint32_t>(static_cast<uint8_t>(data[i])) << (i << 3);
+  return value;
+}
+
+#endif
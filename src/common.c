@@ -19,6 +19,7 @@
 
 #include <postgres.h>
 #include <utils/builtins.h>
+#include <libpq/pqformat.h>
 
 #include "base64.h"
 
@@ -32,9 +33,13 @@ PG_MODULE_MAGIC;
 
 PG_FUNCTION_INFO_V1(pg_sketch_in);
 PG_FUNCTION_INFO_V1(pg_sketch_out);
+PG_FUNCTION_INFO_V1(pg_sketch_recv);
+PG_FUNCTION_INFO_V1(pg_sketch_send);
 
 Datum pg_sketch_in(PG_FUNCTION_ARGS);
 Datum pg_sketch_out(PG_FUNCTION_ARGS);
+Datum pg_sketch_recv(PG_FUNCTION_ARGS);
+Datum pg_sketch_send(PG_FUNCTION_ARGS);
 
 void pg_error(const char* message);
 Datum pg_float4_get_datum(float x);
@@ -45,10 +50,10 @@ Datum pg_sketch_in(PG_FUNCTION_ARGS) {
   // not invoked for nulls
   bytea* decoded;
   char* encoded = PG_GETARG_CSTRING(0);
+  unsigned decoded_length;
   const unsigned encoded_length = strlen(encoded);
-  const unsigned decoded_length = b64_dec_len(encoded, encoded_length);
-  decoded = palloc(VARHDRSZ + decoded_length);
-  b64_decode(encoded, encoded_length, VARDATA(decoded));
+  decoded = palloc(VARHDRSZ + b64_dec_len(encoded_length));
+  decoded_length = b64_decode(encoded, encoded_length, VARDATA(decoded));
   SET_VARSIZE(decoded, VARHDRSZ + decoded_length);
   PG_RETURN_BYTEA_P(decoded);
 }
@@ -65,6 +70,31 @@ Datum pg_sketch_out(PG_FUNCTION_ARGS) {
   PG_RETURN_CSTRING(encoded);
 }
 
+// external binary representation to type
+// sketches travel as raw serialized bytes, no base64 encoding
+Datum pg_sketch_recv(PG_FUNCTION_ARGS) {
+  // not invoked for nulls
+  bytea* bytes;
+  StringInfo buf = (StringInfo) PG_GETARG_POINTER(0);
+  const int length = buf->len - buf->cursor;
+  bytes = palloc(VARHDRSZ + length);
+  SET_VARSIZE(bytes, VARHDRSZ + length);
+  pq_copymsgbytes(buf, VARDATA(bytes), length);
+  PG_RETURN_BYTEA_P(bytes);
+}
+
+// type to external binary representation
+Datum pg_sketch_send(PG_FUNCTION_ARGS) {
+  // not invoked for nulls
+  StringInfoData buf;
+  bytea* bytes = PG_GETARG_BYTEA_PP(0);
+  // the result is read with a 4-byte header, only short values need to be copied
+  if (!VARATT_IS_SHORT(bytes)) PG_RETURN_BYTEA_P(bytes);
+  pq_begintypsend(&buf);
+  pq_sendbytes(&buf, VARDATA_ANY(bytes), VARSIZE_ANY_EXHDR(bytes));
+  PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
 // These are implementations of redirects defined in postgres_h_substitute.h
 
 Datum pg_float4_get_datum(float x) {
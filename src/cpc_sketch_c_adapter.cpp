@@ -156,3 +156,12 @@ void* cpc_union_get_result(void* unionptr) {
   }
   pg_unreachable();
 }
+
+void* cpc_union_get_result_copy(const void* unionptr) {
+  try {
+    return new (palloc(sizeof(cpc_sketch_pg))) cpc_sketch_pg(static_cast<const cpc_union_pg*>(unionptr)->get_result());
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+  pg_unreachable();
+}
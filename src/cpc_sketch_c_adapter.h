@@ -45,6 +45,7 @@ void* cpc_union_new(unsigned lg_k);
 void cpc_union_delete(void* unionptr);
 void cpc_union_update(void* unionptr, const void* sketchptr);
 void* cpc_union_get_result(void* unionptr);
+void* cpc_union_get_result_copy(const void* unionptr);
 
 #ifdef __cplusplus
 }
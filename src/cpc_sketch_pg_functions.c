@@ -26,8 +26,12 @@
 
 #include "cpc_sketch_c_adapter.h"
 #include "agg_state.h"
+#include "fn_cache.h"
+#include "agg_context.h"
+#include "sketch_array.h"
 
 const unsigned CPC_DEFAULT_LG_K = 11;
+const unsigned CPC_MIN_LG_K = 4;
 
 /* PG_FUNCTION_INFO_V1 macro to pass functions to postgres */
 PG_FUNCTION_INFO_V1(pg_cpc_sketch_build_agg);
@@ -41,6 +45,7 @@ PG_FUNCTION_INFO_V1(pg_cpc_sketch_get_estimate);
 PG_FUNCTION_INFO_V1(pg_cpc_sketch_get_estimate_and_bounds);
 PG_FUNCTION_INFO_V1(pg_cpc_sketch_to_string);
 PG_FUNCTION_INFO_V1(pg_cpc_sketch_union);
+PG_FUNCTION_INFO_V1(pg_cpc_sketch_union_array);
 
 /* function declarations */
 Datum pg_cpc_sketch_build_agg(PG_FUNCTION_ARGS);
@@ -54,16 +59,14 @@ Datum pg_cpc_sketch_get_estimate(PG_FUNCTION_ARGS);
 Datum pg_cpc_sketch_get_estimate_and_bounds(PG_FUNCTION_ARGS);
 Datum pg_cpc_sketch_to_string(PG_FUNCTION_ARGS);
 Datum pg_cpc_sketch_union(PG_FUNCTION_ARGS);
+Datum pg_cpc_sketch_union_array(PG_FUNCTION_ARGS);
 
 Datum pg_cpc_sketch_build_agg(PG_FUNCTION_ARGS) {
   struct agg_state* stateptr;
 
   // anyelement
-  Oid   element_type;
-  Datum element;
-  int16 typlen;
-  bool  typbyval;
-  char  typalign;
+  const void* element;
+  unsigned length;
 
   MemoryContext oldcontext;
   MemoryContext aggcontext;
@@ -77,30 +80,20 @@ Datum pg_cpc_sketch_build_agg(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "cpc_sketch_build_agg called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "cpc_sketch"));
 
   if (PG_ARGISNULL(0)) {
     stateptr = palloc(sizeof(struct agg_state));
     stateptr->type = MUTABLE_SKETCH;
-    stateptr->lg_k = PG_NARGS() > 2 ? PG_GETARG_INT32(2) : CPC_DEFAULT_LG_K;
+    stateptr->lg_k = sketch_agg_lg_k(CurrentMemoryContext, NULL, PG_NARGS() > 2 ? PG_GETARG_INT32(2) : CPC_DEFAULT_LG_K, CPC_MIN_LG_K);
     stateptr->ptr = cpc_sketch_new(stateptr->lg_k);
+    stateptr->pool = NULL;
   } else {
     stateptr = (struct agg_state*) PG_GETARG_POINTER(0);
   }
 
-  element_type = get_fn_expr_argtype(fcinfo->flinfo, 1);
-  element = PG_GETARG_DATUM(1);
-  get_typlenbyvalalign(element_type, &typlen, &typbyval, &typalign);
-  if (typlen == -1) {
-    // varlena
-    cpc_sketch_update(stateptr->ptr, VARDATA_ANY(element), VARSIZE_ANY_EXHDR(element));
-  } else if (typbyval) {
-    // fixed-length passed by value
-    cpc_sketch_update(stateptr->ptr, &element, typlen);
-  } else {
-    // fixed-length passed by reference
-    cpc_sketch_update(stateptr->ptr, (void*)element, typlen);
-  }
+  element = fn_cache_get_element(fcinfo, 1, &length);
+  cpc_sketch_update(stateptr->ptr, element, length);
 
   MemoryContextSwitchTo(oldcontext);
 
@@ -124,11 +117,12 @@ Datum pg_cpc_sketch_union_agg(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "cpc_sketch_union_agg called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "cpc_sketch"));
 
   if (PG_ARGISNULL(0)) {
     stateptr = palloc(sizeof(struct agg_state));
     stateptr->type = UNION;
+    stateptr->pool = NULL;
     stateptr->lg_k = PG_NARGS() > 2 ? PG_GETARG_INT32(2) : CPC_DEFAULT_LG_K;
     stateptr->ptr = cpc_union_new(stateptr->lg_k);
   } else {
@@ -145,9 +139,11 @@ Datum pg_cpc_sketch_union_agg(PG_FUNCTION_ARGS) {
   PG_RETURN_POINTER(stateptr);
 }
 
+// does not destroy the state, so that window aggregates can call it after every row
 Datum pg_cpc_sketch_from_internal(PG_FUNCTION_ARGS) {
   struct agg_state* stateptr;
   struct ptr_with_size bytes_out;
+  void* sketchptr;
 
   MemoryContext oldcontext;
   MemoryContext aggcontext;
@@ -157,25 +153,24 @@ Datum pg_cpc_sketch_from_internal(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "cpc_sketch_from_internal called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "cpc_sketch"));
 
   stateptr = (struct agg_state*) PG_GETARG_POINTER(0);
-  if (stateptr->type == UNION) {
-    stateptr->ptr = cpc_union_get_result(stateptr->ptr);
-  }
-  bytes_out = cpc_sketch_serialize(stateptr->ptr, VARHDRSZ);
-  cpc_sketch_delete(stateptr->ptr);
-  pfree(stateptr);
-  SET_VARSIZE(bytes_out.ptr, bytes_out.size);
 
   MemoryContextSwitchTo(oldcontext);
 
+  sketchptr = stateptr->type == UNION ? cpc_union_get_result_copy(stateptr->ptr) : stateptr->ptr;
+  bytes_out = cpc_sketch_serialize(sketchptr, VARHDRSZ);
+  if (sketchptr != stateptr->ptr) cpc_sketch_delete(sketchptr);
+  SET_VARSIZE(bytes_out.ptr, bytes_out.size);
+
   PG_RETURN_BYTEA_P(bytes_out.ptr);
 }
 
 Datum pg_cpc_sketch_get_estimate_from_internal(PG_FUNCTION_ARGS) {
   struct agg_state* stateptr;
   double estimate;
+  void* sketchptr;
 
   MemoryContext oldcontext;
   MemoryContext aggcontext;
@@ -185,15 +180,20 @@ Datum pg_cpc_sketch_get_estimate_from_internal(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "cpc_sketch_get_estimate_from_internal called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "cpc_sketch"));
 
   stateptr = (struct agg_state*) PG_GETARG_POINTER(0);
-  estimate = cpc_sketch_get_estimate(stateptr->ptr);
-  cpc_sketch_delete(stateptr->ptr);
-  pfree(stateptr);
 
   MemoryContextSwitchTo(oldcontext);
 
+  if (stateptr->type == UNION) {
+    sketchptr = cpc_union_get_result_copy(stateptr->ptr);
+    estimate = cpc_sketch_get_estimate(sketchptr);
+    cpc_sketch_delete(sketchptr);
+  } else {
+    estimate = cpc_sketch_get_estimate(stateptr->ptr);
+  }
+
   PG_RETURN_FLOAT8(estimate);
 }
 
@@ -201,6 +201,7 @@ Datum pg_cpc_sketch_combine(PG_FUNCTION_ARGS) {
   struct agg_state* stateptr1;
   struct agg_state* stateptr2;
   struct agg_state* stateptr;
+  void* unionptr;
 
   MemoryContext oldcontext;
   MemoryContext aggcontext;
@@ -210,33 +211,32 @@ Datum pg_cpc_sketch_combine(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "cpc_sketch_from_combine called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "cpc_sketch"));
 
   stateptr1 = (struct agg_state*) PG_GETARG_POINTER(0);
   stateptr2 = (struct agg_state*) PG_GETARG_POINTER(1);
 
-  stateptr = palloc(sizeof(struct agg_state));
-  stateptr->type = MUTABLE_SKETCH;
-  stateptr->lg_k = stateptr1 ? stateptr1->lg_k : stateptr2->lg_k;
-  stateptr->ptr = cpc_union_new(stateptr->lg_k);
-
-  if (stateptr1) {
-    if (stateptr1->type == UNION) {
-      stateptr1->ptr = cpc_union_get_result(stateptr1->ptr);
-    }
-    cpc_union_update(stateptr->ptr, stateptr1->ptr);
-    cpc_sketch_delete(stateptr1->ptr);
-    pfree(stateptr1);
-  }
-  if (stateptr2) {
-    if (stateptr2->type == UNION) {
-      stateptr2->ptr = cpc_union_get_result(stateptr2->ptr);
+  // the second state is merged into the first one, which becomes a union if it is not one yet
+  if (stateptr1 == NULL) {
+    stateptr = stateptr2;
+  } else {
+    stateptr = stateptr1;
+    if (stateptr2) {
+      if (stateptr->type != UNION) {
+        unionptr = cpc_union_new(stateptr->lg_k);
+        cpc_union_update(unionptr, stateptr->ptr);
+        cpc_sketch_delete(stateptr->ptr);
+        stateptr->type = UNION;
+        stateptr->ptr = unionptr;
+      }
+      if (stateptr2->type == UNION) {
+        stateptr2->ptr = cpc_union_get_result(stateptr2->ptr);
+      }
+      cpc_union_update(stateptr->ptr, stateptr2->ptr);
+      cpc_sketch_delete(stateptr2->ptr);
+      pfree(stateptr2);
     }
-    cpc_union_update(stateptr->ptr, stateptr2->ptr);
-    cpc_sketch_delete(stateptr2->ptr);
-    pfree(stateptr2);
   }
-  stateptr->ptr = cpc_union_get_result(stateptr->ptr);
 
   MemoryContextSwitchTo(oldcontext);
 
@@ -255,7 +255,7 @@ Datum pg_cpc_sketch_serialize_state(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "cpc_sketch_serialize_state called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "cpc_sketch"));
 
   stateptr = (struct agg_state*) PG_GETARG_POINTER(0);
   if (stateptr->type == UNION) {
@@ -284,11 +284,12 @@ Datum pg_cpc_sketch_deserialize_state(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "cpc_sketch_deserialize_state called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "cpc_sketch"));
 
   bytes_in = PG_GETARG_BYTEA_P(0);
   stateptr = palloc(sizeof(struct agg_state));
   stateptr->type = MUTABLE_SKETCH;
+  stateptr->pool = NULL;
   stateptr->lg_k = *VARDATA(bytes_in);
   stateptr->ptr = cpc_sketch_deserialize(VARDATA(bytes_in) + 1, VARSIZE(bytes_in) - VARHDRSZ - 1);
 
@@ -373,3 +374,27 @@ Datum pg_cpc_sketch_union(PG_FUNCTION_ARGS) {
   SET_VARSIZE(bytes_out.ptr, bytes_out.size);
   PG_RETURN_BYTEA_P(bytes_out.ptr);
 }
+
+// the whole array in one call, without serializing intermediate results
+Datum pg_cpc_sketch_union_array(PG_FUNCTION_ARGS) {
+  struct sketch_array sketches;
+  void* unionptr;
+  void* sketchptr;
+  struct ptr_with_size bytes_out;
+  int lg_k;
+  unsigned i;
+
+  lg_k = PG_NARGS() > 1 ? PG_GETARG_INT32(1) : CPC_DEFAULT_LG_K;
+  sketch_array_init(&sketches, PG_GETARG_ARRAYTYPE_P(0), false);
+  unionptr = cpc_union_new(lg_k);
+  for (i = 0; i < sketches.num_sketches; i++) {
+    sketchptr = cpc_sketch_deserialize(sketches.buffers[i], sketches.lengths[i]);
+    cpc_union_update(unionptr, sketchptr);
+    cpc_sketch_delete(sketchptr);
+  }
+  sketchptr = cpc_union_get_result(unionptr);
+  bytes_out = cpc_sketch_serialize(sketchptr, VARHDRSZ);
+  cpc_sketch_delete(sketchptr);
+  SET_VARSIZE(bytes_out.ptr, bytes_out.size);
+  PG_RETURN_BYTEA_P(bytes_out.ptr);
+}
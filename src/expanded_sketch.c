@@ -0,0 +1,169 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#include <postgres.h>
+#include <fmgr.h>
+#include <utils/memutils.h>
+#if PG_VERSION_NUM >= 180000
+#include <nodes/supportnodes.h>
+#endif
+
+#include "expanded_sketch.h"
+
+// Since version 16 of PG, all functionality for variable-length
+// data was moved from postgres.h into the new file varatt.h
+#if PG_VERSION_NUM >= 160000
+#include "varatt.h"
+#endif
+
+/* PG_FUNCTION_INFO_V1 macro to pass functions to postgres */
+PG_FUNCTION_INFO_V1(pg_sketch_union_support);
+
+/* function declarations */
+Datum pg_sketch_union_support(PG_FUNCTION_ARGS);
+
+static Size expanded_sketch_get_flat_size(ExpandedObjectHeader* eohptr);
+static void expanded_sketch_flatten_into(ExpandedObjectHeader* eohptr, void* result, Size allocated_size);
+
+static const ExpandedObjectMethods expanded_sketch_methods = {
+  expanded_sketch_get_flat_size,
+  expanded_sketch_flatten_into
+};
+
+static bytea* expanded_sketch_flatten(struct expanded_sketch* esketch) {
+  struct ptr_with_size bytes_out;
+  MemoryContext oldcontext;
+  if (esketch->flat == NULL) {
+    // getting the result may reorganize the union
+    oldcontext = MemoryContextSwitchTo(esketch->hdr.eoh_context);
+    bytes_out = esketch->ops->union_serialize(esketch->unionptr, esketch->result_param, VARHDRSZ);
+    SET_VARSIZE(bytes_out.ptr, bytes_out.size);
+    esketch->flat = (bytea*) bytes_out.ptr;
+    MemoryContextSwitchTo(oldcontext);
+  }
+  return esketch->flat;
+}
+
+static Size expanded_sketch_get_flat_size(ExpandedObjectHeader* eohptr) {
+  return VARSIZE(expanded_sketch_flatten((struct expanded_sketch*) eohptr));
+}
+
+static void expanded_sketch_flatten_into(ExpandedObjectHeader* eohptr, void* result, Size allocated_size) {
+  const bytea* flat = expanded_sketch_flatten((struct expanded_sketch*) eohptr);
+  Assert(allocated_size == VARSIZE(flat));
+  memcpy(result, flat, allocated_size);
+}
+
+static struct expanded_sketch* expanded_sketch_from_datum(Datum datum, const struct sketch_union_ops* ops) {
+  ExpandedObjectHeader* eohptr;
+  if (!VARATT_IS_EXTERNAL_EXPANDED(DatumGetPointer(datum))) return NULL;
+  eohptr = DatumGetEOHP(datum);
+  if (eohptr->eoh_methods != &expanded_sketch_methods) return NULL;
+  if (((struct expanded_sketch*) eohptr)->ops != ops) return NULL;
+  return (struct expanded_sketch*) eohptr;
+}
+
+struct expanded_sketch* expanded_sketch_new(const struct sketch_union_ops* ops, unsigned param, unsigned result_param) {
+  struct expanded_sketch* esketch;
+  MemoryContext oldcontext;
+  MemoryContext objcontext = AllocSetContextCreate(CurrentMemoryContext, "expanded sketch", ALLOCSET_DEFAULT_SIZES);
+  esketch = MemoryContextAlloc(objcontext, sizeof(struct expanded_sketch));
+  EOH_init_header(&esketch->hdr, &expanded_sketch_methods, objcontext);
+  esketch->ops = ops;
+  esketch->param = param;
+  esketch->result_param = result_param;
+  esketch->flat = NULL;
+  oldcontext = MemoryContextSwitchTo(objcontext);
+  esketch->unionptr = ops->union_new(param);
+  MemoryContextSwitchTo(oldcontext);
+  return esketch;
+}
+
+struct expanded_sketch* expanded_sketch_get_rw(Datum datum, const struct sketch_union_ops* ops, unsigned param, unsigned result_param) {
+  struct expanded_sketch* esketch;
+  if (!VARATT_IS_EXTERNAL_EXPANDED_RW(DatumGetPointer(datum))) return NULL;
+  esketch = expanded_sketch_from_datum(datum, ops);
+  if (esketch == NULL || esketch->param != param || esketch->result_param != result_param) return NULL;
+  return esketch;
+}
+
+bytea* expanded_sketch_get_bytes(Datum datum, const struct sketch_union_ops* ops) {
+  struct expanded_sketch* esketch = expanded_sketch_from_datum(datum, ops);
+  if (esketch) return expanded_sketch_flatten(esketch);
+  return (bytea*) PG_DETOAST_DATUM_PACKED(datum);
+}
+
+void expanded_sketch_update(struct expanded_sketch* esketch, const char* buffer, unsigned length) {
+  MemoryContext oldcontext = MemoryContextSwitchTo(esketch->hdr.eoh_context);
+  esketch->ops->union_update(esketch->unionptr, buffer, length);
+  MemoryContextSwitchTo(oldcontext);
+  // the buffer may be the flat form of the same object
+  if (esketch->flat) {
+    pfree(esketch->flat);
+    esketch->flat = NULL;
+  }
+}
+
+Datum expanded_sketch_union(FunctionCallInfo fcinfo, const struct sketch_union_ops* ops, unsigned param, unsigned result_param) {
+  struct expanded_sketch* esketch = NULL;
+  bytea* bytes_in;
+  int other = 1;
+
+  if (!PG_ARGISNULL(0)) esketch = expanded_sketch_get_rw(PG_GETARG_DATUM(0), ops, param, result_param);
+  if (esketch == NULL && !PG_ARGISNULL(1)) {
+    esketch = expanded_sketch_get_rw(PG_GETARG_DATUM(1), ops, param, result_param);
+    if (esketch) other = 0;
+  }
+  if (esketch == NULL) {
+    esketch = expanded_sketch_new(ops, param, result_param);
+    if (!PG_ARGISNULL(0)) {
+      bytes_in = expanded_sketch_get_bytes(PG_GETARG_DATUM(0), ops);
+      expanded_sketch_update(esketch, VARDATA_ANY(bytes_in), VARSIZE_ANY_EXHDR(bytes_in));
+    }
+  }
+  if (!PG_ARGISNULL(other)) {
+    bytes_in = expanded_sketch_get_bytes(PG_GETARG_DATUM(other), ops);
+    expanded_sketch_update(esketch, VARDATA_ANY(bytes_in), VARSIZE_ANY_EXHDR(bytes_in));
+  }
+  return expanded_sketch_get_datum(esketch);
+}
+
+// planner support function of union functions
+// since version 18 of PG, it lets PL/pgSQL pass a variable such as s in s := theta_sketch_union(s, x)
+// as a read-write expanded object, so that the union in the variable is updated in place
+Datum pg_sketch_union_support(PG_FUNCTION_ARGS) {
+#if PG_VERSION_NUM >= 180000
+  Node* rawreq = (Node*) PG_GETARG_POINTER(0);
+  SupportRequestModifyInPlace* req;
+  Param* arg;
+  int i;
+
+  if (IsA(rawreq, SupportRequestModifyInPlace)) {
+    req = (SupportRequestModifyInPlace*) rawreq;
+    for (i = 0; i < 2 && i < list_length(req->args); i++) {
+      arg = (Param*) list_nth(req->args, i);
+      if (arg && IsA(arg, Param) && arg->paramkind == PARAM_EXTERN && arg->paramid == req->paramid) {
+        PG_RETURN_POINTER(arg);
+      }
+    }
+  }
+#endif
+  PG_RETURN_POINTER(NULL);
+}
@@ -0,0 +1,58 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef EXPANDED_SKETCH_H
+#define EXPANDED_SKETCH_H
+
+#include <fmgr.h>
+#include <utils/expandeddatum.h>
+
+#include "union_ops.h"
+
+// result of a union function kept as a live union object (a PG expanded object),
+// so that nested calls such as theta_sketch_union(theta_sketch_union(a, b), c) and PL/pgSQL variables
+// pass the union along instead of serializing and deserializing it at every step
+// the sketch is serialized only when PG needs the flat value, for storage or for other functions
+struct expanded_sketch {
+  ExpandedObjectHeader hdr;
+  const struct sketch_union_ops* ops;
+  unsigned param;
+  unsigned result_param;
+  void* unionptr;
+  bytea* flat; // serialized result, null if not computed since the last update
+};
+
+// the object gets its own memory context, a child of the current one
+struct expanded_sketch* expanded_sketch_new(const struct sketch_union_ops* ops, unsigned param, unsigned result_param);
+
+// the argument if it is a read-write expanded sketch with the same union settings, which the function may update in place, null otherwise
+struct expanded_sketch* expanded_sketch_get_rw(Datum datum, const struct sketch_union_ops* ops, unsigned param, unsigned result_param);
+
+// serialized sketch of an argument, expanded or not (use VARDATA_ANY and VARSIZE_ANY_EXHDR)
+bytea* expanded_sketch_get_bytes(Datum datum, const struct sketch_union_ops* ops);
+
+void expanded_sketch_update(struct expanded_sketch* esketch, const char* buffer, unsigned length);
+
+// union of the first two arguments of a union function (either may be null)
+// a read-write argument is a temporary result, such as of a nested call, and gets updated in place
+Datum expanded_sketch_union(FunctionCallInfo fcinfo, const struct sketch_union_ops* ops, unsigned param, unsigned result_param);
+
+#define expanded_sketch_get_datum(esketch) EOHPGetRWDatum(&(esketch)->hdr)
+
+#endif
@@ -0,0 +1,284 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <postgres.h>
+#include <fmgr.h>
+#include <utils/memutils.h>
+#include <utils/lsyscache.h>
+#include <utils/array.h>
+#include <nodes/execnodes.h>
+#include <nodes/plannodes.h>
+
+#include "fn_cache.h"
+
+// one free object per kind is enough for plain GROUP BY, a few more serve grouping sets
+#define OBJECT_POOL_SIZE 4
+
+struct object_pool_entry {
+  enum object_pool_kind kind;
+  unsigned lg_k;
+  void* ptr;
+};
+
+struct object_pool {
+  MemoryContext context;
+  unsigned num_entries;
+  struct object_pool_entry entries[OBJECT_POOL_SIZE];
+};
+
+struct fn_cache {
+  // sketch argument
+  // on-disk toasted values are identified by the toast pointer without fetching them
+  // other values are compared by bytes
+  MemoryContext sketch_context;
+  bool has_sketch;
+  bool has_toast_pointer;
+  struct varatt_external toast_pointer;
+  bytea* sketch_bytes;
+  void* sketchptr;
+
+  // array argument
+  MemoryContext array_context;
+  bool has_array;
+  bool array_of_double;
+  ArrayType* array_bytes;
+  void* array_values;
+  int array_length;
+
+  // text argument
+  MemoryContext text_context;
+  bool has_text;
+  text* text_bytes;
+  void* parsed_text;
+
+  // anyelement argument
+  bool has_element_type;
+  int16 element_typlen;
+  bool element_typbyval;
+
+  // pool of objects for sort-based aggregation
+  bool has_pool_checked;
+  struct object_pool* pool;
+};
+
+static struct fn_cache* get_fn_cache(FunctionCallInfo fcinfo) {
+  struct fn_cache* cache = (struct fn_cache*) fcinfo->flinfo->fn_extra;
+  if (cache == NULL) {
+    cache = MemoryContextAllocZero(fcinfo->flinfo->fn_mcxt, sizeof(struct fn_cache));
+    fcinfo->flinfo->fn_extra = cache;
+  }
+  return cache;
+}
+
+void* fn_cache_get_sketch(FunctionCallInfo fcinfo, int argno, fn_cache_deserialize_fn deserialize, fn_cache_prepare_fn prepare) {
+  struct fn_cache* cache = get_fn_cache(fcinfo);
+  struct varlena* datum = (struct varlena*) PG_GETARG_POINTER(argno);
+  struct varatt_external toast_pointer;
+  const bool has_toast_pointer = VARATT_IS_EXTERNAL_ONDISK(datum);
+  bytea* bytes_in;
+  MemoryContext oldcontext;
+
+  if (has_toast_pointer) {
+    memcpy(&toast_pointer, VARDATA_EXTERNAL(datum), sizeof(toast_pointer));
+    if (cache->has_sketch && cache->has_toast_pointer
+        && cache->toast_pointer.va_valueid == toast_pointer.va_valueid
+        && cache->toast_pointer.va_toastrelid == toast_pointer.va_toastrelid) {
+      return cache->sketchptr;
+    }
+  }
+  bytes_in = PG_GETARG_BYTEA_P(argno);
+  if (!has_toast_pointer && cache->has_sketch && !cache->has_toast_pointer
+      && VARSIZE(bytes_in) == VARSIZE(cache->sketch_bytes)
+      && memcmp(VARDATA(bytes_in), VARDATA(cache->sketch_bytes), VARSIZE(bytes_in) - VARHDRSZ) == 0) {
+    return cache->sketchptr;
+  }
+
+  cache->has_sketch = false;
+  if (cache->sketch_context == NULL) {
+    cache->sketch_context = AllocSetContextCreate(fcinfo->flinfo->fn_mcxt, "datasketches cached sketch", ALLOCSET_DEFAULT_SIZES);
+  }
+  MemoryContextReset(cache->sketch_context);
+  oldcontext = MemoryContextSwitchTo(cache->sketch_context);
+  if (has_toast_pointer) {
+    cache->toast_pointer = toast_pointer;
+  } else {
+    cache->sketch_bytes = palloc(VARSIZE(bytes_in));
+    memcpy(cache->sketch_bytes, bytes_in, VARSIZE(bytes_in));
+  }
+  cache->sketchptr = deserialize(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ);
+  if (prepare) prepare(cache->sketchptr);
+  MemoryContextSwitchTo(oldcontext);
+  cache->has_toast_pointer = has_toast_pointer;
+  cache->has_sketch = true;
+  return cache->sketchptr;
+}
+
+static const void* fn_cache_get_array(FunctionCallInfo fcinfo, int argno, bool of_double, int* length) {
+  struct fn_cache* cache = get_fn_cache(fcinfo);
+  ArrayType* arr_in = PG_GETARG_ARRAYTYPE_P(argno);
+  Oid elmtype_in;
+  int16 elmlen_in;
+  bool elmbyval_in;
+  char elmalign_in;
+  Datum* data_in;
+  bool* nulls_in;
+  int arr_len_in;
+  int i;
+  MemoryContext oldcontext;
+
+  if (cache->has_array && cache->array_of_double == of_double
+      && VARSIZE(arr_in) == VARSIZE(cache->array_bytes)
+      && memcmp(arr_in, cache->array_bytes, VARSIZE(arr_in)) == 0) {
+    *length = cache->array_length;
+    return cache->array_values;
+  }
+
+  cache->has_array = false;
+  if (cache->array_context == NULL) {
+    cache->array_context = AllocSetContextCreate(fcinfo->flinfo->fn_mcxt, "datasketches cached array", ALLOCSET_SMALL_SIZES);
+  }
+  MemoryContextReset(cache->array_context);
+  elmtype_in = ARR_ELEMTYPE(arr_in);
+  get_typlenbyvalalign(elmtype_in, &elmlen_in, &elmbyval_in, &elmalign_in);
+  deconstruct_array(arr_in, elmtype_in, elmlen_in, elmbyval_in, elmalign_in, &data_in, &nulls_in, &arr_len_in);
+
+  oldcontext = MemoryContextSwitchTo(cache->array_context);
+  cache->array_bytes = palloc(VARSIZE(arr_in));
+  memcpy(cache->array_bytes, arr_in, VARSIZE(arr_in));
+  if (of_double) {
+    double* values = palloc(sizeof(double) * arr_len_in);
+    for (i = 0; i < arr_len_in; i++) values[i] = nulls_in[i] ? 0 : DatumGetFloat8(data_in[i]);
+    cache->array_values = values;
+  } else {
+    float* values = palloc(sizeof(float) * arr_len_in);
+    for (i = 0; i < arr_len_in; i++) values[i] = nulls_in[i] ? 0 : DatumGetFloat4(data_in[i]);
+    cache->array_values = values;
+  }
+  MemoryContextSwitchTo(oldcontext);
+  cache->array_of_double = of_double;
+  cache->array_length = arr_len_in;
+  cache->has_array = true;
+  *length = arr_len_in;
+  return cache->array_values;
+}
+
+const float* fn_cache_get_float_array(FunctionCallInfo fcinfo, int argno, int* length) {
+  return fn_cache_get_array(fcinfo, argno, false, length);
+}
+
+const double* fn_cache_get_double_array(FunctionCallInfo fcinfo, int argno, int* length) {
+  return fn_cache_get_array(fcinfo, argno, true, length);
+}
+
+const void* fn_cache_get_parsed_text(FunctionCallInfo fcinfo, int argno, fn_cache_parse_fn parse) {
+  struct fn_cache* cache = get_fn_cache(fcinfo);
+  text* text_in = PG_GETARG_TEXT_PP(argno);
+  MemoryContext oldcontext;
+
+  if (cache->has_text
+      && VARSIZE_ANY_EXHDR(text_in) == VARSIZE_ANY_EXHDR(cache->text_bytes)
+      && memcmp(VARDATA_ANY(text_in), VARDATA_ANY(cache->text_bytes), VARSIZE_ANY_EXHDR(text_in)) == 0) {
+    return cache->parsed_text;
+  }
+
+  cache->has_text = false;
+  if (cache->text_context == NULL) {
+    cache->text_context = AllocSetContextCreate(fcinfo->flinfo->fn_mcxt, "datasketches cached text", ALLOCSET_SMALL_SIZES);
+  }
+  MemoryContextReset(cache->text_context);
+  oldcontext = MemoryContextSwitchTo(cache->text_context);
+  cache->text_bytes = palloc(VARSIZE_ANY(text_in));
+  memcpy(cache->text_bytes, text_in, VARSIZE_ANY(text_in));
+  cache->parsed_text = parse(VARDATA_ANY(text_in), VARSIZE_ANY_EXHDR(text_in));
+  MemoryContextSwitchTo(oldcontext);
+  cache->has_text = true;
+  return cache->parsed_text;
+}
+
+static const void* get_element(FunctionCallInfo fcinfo, int argno, unsigned* length, bool detoast) {
+  struct fn_cache* cache = get_fn_cache(fcinfo);
+  Datum* element = &PG_GETARG_DATUM(argno);
+  char typalign;
+
+  if (!cache->has_element_type) {
+    get_typlenbyvalalign(get_fn_expr_argtype(fcinfo->flinfo, argno), &cache->element_typlen, &cache->element_typbyval, &typalign);
+    cache->has_element_type = true;
+  }
+  if (cache->element_typlen == -1) {
+    // varlena
+    const struct varlena* value = detoast ? PG_DETOAST_DATUM_PACKED(*element) : (const struct varlena*) DatumGetPointer(*element);
+    *length = VARSIZE_ANY_EXHDR(value);
+    return VARDATA_ANY(value);
+  }
+  *length = cache->element_typlen;
+  if (cache->element_typbyval) {
+    // fixed-length passed by value
+    return element;
+  }
+  // fixed-length passed by reference
+  return DatumGetPointer(*element);
+}
+
+const void* fn_cache_get_element(FunctionCallInfo fcinfo, int argno, unsigned* length) {
+  return get_element(fcinfo, argno, length, false);
+}
+
+const void* fn_cache_get_element_detoasted(FunctionCallInfo fcinfo, int argno, unsigned* length) {
+  return get_element(fcinfo, argno, length, true);
+}
+
+struct object_pool* fn_cache_get_object_pool(FunctionCallInfo fcinfo) {
+  struct fn_cache* cache = get_fn_cache(fcinfo);
+  if (!cache->has_pool_checked) {
+    // hash and mixed strategies keep all groups alive at once, window aggregates reuse the state
+    if (fcinfo->context != NULL && IsA(fcinfo->context, AggState)
+        && ((Agg*) ((AggState*) fcinfo->context)->ss.ps.plan)->aggstrategy == AGG_SORTED) {
+      cache->pool = MemoryContextAllocZero(fcinfo->flinfo->fn_mcxt, sizeof(struct object_pool));
+      cache->pool->context = AllocSetContextCreate(fcinfo->flinfo->fn_mcxt, "datasketches object pool", ALLOCSET_DEFAULT_SIZES);
+    }
+    cache->has_pool_checked = true;
+  }
+  return cache->pool;
+}
+
+MemoryContext object_pool_context(const struct object_pool* pool) {
+  return pool->context;
+}
+
+void* object_pool_acquire(struct object_pool* pool, enum object_pool_kind kind, unsigned lg_k) {
+  unsigned i;
+  void* ptr;
+  for (i = 0; i < pool->num_entries; i++) {
+    if (pool->entries[i].kind == kind && pool->entries[i].lg_k == lg_k) {
+      ptr = pool->entries[i].ptr;
+      pool->entries[i] = pool->entries[--pool->num_entries];
+      return ptr;
+    }
+  }
+  return NULL;
+}
+
+bool object_pool_release(struct object_pool* pool, enum object_pool_kind kind, unsigned lg_k, void* ptr) {
+  if (pool->num_entries == OBJECT_POOL_SIZE) return false;
+  pool->entries[pool->num_entries].kind = kind;
+  pool->entries[pool->num_entries].lg_k = lg_k;
+  pool->entries[pool->num_entries].ptr = ptr;
+  pool->num_entries++;
+  return true;
+}
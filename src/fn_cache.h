@@ -0,0 +1,70 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef FN_CACHE_H
+#define FN_CACHE_H
+
+// per call site cache in flinfo->fn_extra
+// keeps the last deserialized sketch, the last parsed array argument and the last parsed text argument
+// so that calls repeating the same inputs (such as a sketch joined to many rows) reuse them
+// also keeps the properties of the type of an anyelement argument to avoid catalog lookups on every row
+
+typedef void* (*fn_cache_deserialize_fn)(const char* buffer, unsigned length);
+typedef void (*fn_cache_prepare_fn)(const void* sketchptr);
+
+// the returned sketch belongs to the cache and must not be deleted
+// prepare (optional) is called once after deserialization in the long-lived context
+void* fn_cache_get_sketch(FunctionCallInfo fcinfo, int argno, fn_cache_deserialize_fn deserialize, fn_cache_prepare_fn prepare);
+
+// elements of a float4[] or float8[] argument, nulls as zeros
+// the returned array belongs to the cache and must not be freed
+const float* fn_cache_get_float_array(FunctionCallInfo fcinfo, int argno, int* length);
+const double* fn_cache_get_double_array(FunctionCallInfo fcinfo, int argno, int* length);
+
+// result of parsing a text argument (such as an expression), parsed again only when the text changes
+// parse is called in the long-lived context, the result belongs to the cache
+typedef void* (*fn_cache_parse_fn)(const char* str, unsigned length);
+const void* fn_cache_get_parsed_text(FunctionCallInfo fcinfo, int argno, fn_cache_parse_fn parse);
+
+// bytes of an anyelement argument as they are hashed into sketches:
+// the datum itself for types passed by value, the data without the header for varlena types
+// the type of the argument is resolved on the first call only
+const void* fn_cache_get_element(FunctionCallInfo fcinfo, int argno, unsigned* length);
+// the same with compressed or out-of-line varlena values expanded, so that equal values give equal bytes
+const void* fn_cache_get_element_detoasted(FunctionCallInfo fcinfo, int argno, unsigned* length);
+
+// reset sketch and union objects reused across the groups of a sort-based aggregation (GroupAggregate):
+// the final function of a group runs before the next group starts, so instead of destroying its object
+// it can hand it over to the next group of the same call site, which saves allocating and clearing the tables
+// pooled objects live in a context of the call site that outlives the aggregate context reset between groups,
+// so all their allocations (creation, updates, reset) must happen in object_pool_context
+
+enum object_pool_kind { POOLED_THETA_SKETCH, POOLED_THETA_UNION, POOLED_HLL_UNION };
+
+struct object_pool;
+
+// NULL if the transition function is not called by a sort-based aggregation
+struct object_pool* fn_cache_get_object_pool(FunctionCallInfo fcinfo);
+MemoryContext object_pool_context(const struct object_pool* pool);
+// a reset object of the given kind and lg_k or NULL
+void* object_pool_acquire(struct object_pool* pool, enum object_pool_kind kind, unsigned lg_k);
+// the object must be reset, returns false if the pool is full and the object is still owned by the caller
+bool object_pool_release(struct object_pool* pool, enum object_pool_kind kind, unsigned lg_k, void* ptr);
+
+#endif
@@ -26,6 +26,7 @@
 #include <funcapi.h>
 
 #include "frequent_strings_sketch_c_adapter.h"
+#include "agg_context.h"
 
 /* PG_FUNCTION_INFO_V1 macro to pass functions to postgres */
 PG_FUNCTION_INFO_V1(pg_frequent_strings_sketch_build_agg);
@@ -68,7 +69,7 @@ Datum pg_frequent_strings_sketch_build_agg(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "frequent_strings_sketch_build_agg called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "frequent_strings_sketch"));
 
   if (PG_ARGISNULL(0)) {
     lg_k = PG_GETARG_INT32(1);
@@ -107,7 +108,7 @@ Datum pg_frequent_strings_sketch_merge_agg(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "frequent_strings_sketch_merge_agg called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "frequent_strings_sketch"));
 
   if (PG_ARGISNULL(0)) {
     lg_k = PG_GETARG_INT32(1);
@@ -153,7 +154,7 @@ Datum pg_frequent_strings_sketch_deserialize(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "frequent_strings_sketch_deserialize called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "frequent_strings_sketch"));
 
   bytes_in = PG_GETARG_BYTEA_P(0);
   sketchptr = frequent_strings_sketch_deserialize(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ);
@@ -176,7 +177,7 @@ Datum pg_frequent_strings_sketch_combine(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "frequent_strings_sketch_combine called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "frequent_strings_sketch"));
 
   sketchptr1 = PG_GETARG_POINTER(0);
   sketchptr2 = PG_GETARG_POINTER(1);
@@ -20,13 +20,33 @@
 // PostgreSQL hooks to execute on loading and unloading
 // CPC sketch needs global initialization of compression tables
 
+#include <postgres.h>
+#include <utils/guc.h>
+
 #include "cpc_sketch_c_adapter.h"
+#include "agg_context.h"
 
 void _PG_init(void);
 void _PG_fini(void);
 
 void _PG_init() {
   cpc_init();
+
+  DefineCustomIntVariable(
+    "datasketches.agg_memory_budget",
+    "Memory of the aggregate states of one sketch family past which new groups get smaller sketches.",
+    "Applies to theta, HLL and CPC build aggregates. Zero means no limit.",
+    &sketch_agg_memory_budget,
+    0, 0, MAX_KILOBYTES,
+    PGC_USERSET,
+    GUC_UNIT_KB,
+    NULL, NULL, NULL
+  );
+#if PG_VERSION_NUM >= 150000
+  MarkGUCPrefixReserved("datasketches");
+#else
+  EmitWarningsOnPlaceholders("datasketches");
+#endif
 }
 
 void _PG_fini() {
@@ -0,0 +1,42 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <postgres.h>
+#include <fmgr.h>
+
+#include "hash_c_adapter.h"
+#include "fn_cache.h"
+
+/* PG_FUNCTION_INFO_V1 macro to pass functions to postgres */
+PG_FUNCTION_INFO_V1(pg_datasketches_hash);
+
+/* function declarations */
+Datum pg_datasketches_hash(PG_FUNCTION_ARGS);
+
+// the hash of the item as the sketches compute it, with the default seed
+// the *_sketch_build_from_hash aggregates take it instead of the item, so that the item is read and hashed in full once
+// for any number of sketches, the aggregates hash the 8 bytes of the hash again: their sketches can only be merged
+// with each other, not with sketches built from the items
+Datum pg_datasketches_hash(PG_FUNCTION_ARGS) {
+  const void* element;
+  unsigned length;
+
+  element = fn_cache_get_element_detoasted(fcinfo, 0, &length);
+  PG_RETURN_INT64((int64) datasketches_hash(element, length));
+}
@@ -20,12 +20,38 @@
 #include "hll_sketch_c_adapter.h"
 #include "allocator.h"
 #include "postgres_h_substitute.h"
+#include "batch_update.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
 #include <hll.hpp>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 using hll_sketch_pg = datasketches::hll_sketch_alloc<palloc_allocator<char>>;
 using hll_union_pg = datasketches::hll_union_alloc<palloc_allocator<char>>;
 
+// union plus a register array that HLL_8 and HLL_4 inputs with lg_k >= lg_max_k are merged into
+// straight from their serialized form, the registers are fed to the union as one HLL_8 sketch before taking the result
+// the first such input goes to the union as a sketch, so that a union of one keeps its HIP estimate
+struct hll_union_with_registers {
+  hll_union_pg sketch_union;
+  uint8_t lg_max_k;
+  bool has_hll_mode_input;
+  uint8_t* registers; // allocated on first use
+
+  explicit hll_union_with_registers(unsigned lg_max_k): sketch_union(lg_max_k), lg_max_k(lg_max_k), has_hll_mode_input(false), registers(nullptr) {}
+  ~hll_union_with_registers() { if (registers != nullptr) pfree(registers); }
+};
+
+static void hll_union_merge_registers_into_union(hll_union_with_registers& u);
+
 void* hll_sketch_new(unsigned lg_k) {
   try {
     return new (palloc(sizeof(hll_sketch_pg))) hll_sketch_pg(lg_k);
@@ -64,6 +90,16 @@ void hll_sketch_update(void* sketchptr, const void* data, unsigned length) {
   }
 }
 
+// the hashes are passed as 8-byte items, as the build aggregates get bigint values
+void hll_sketch_update_packed(void* sketchptr, const char* data, unsigned num_items) {
+  try {
+    auto& sketch = *static_cast<hll_sketch_pg*>(sketchptr);
+    for (unsigned i = 0; i < num_items; ++i) sketch.update(load_little_endian_u64(data + (i << 3)));
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+}
+
 double hll_sketch_get_estimate(const void* sketchptr) {
   try {
     return static_cast<const hll_sketch_pg*>(sketchptr)->get_estimate();
@@ -126,7 +162,7 @@ void* hll_sketch_deserialize(const char* buffer, unsigned length) {
 
 void* hll_union_new(unsigned lg_k) {
   try {
-    return new (palloc(sizeof(hll_union_pg))) hll_union_pg(lg_k);
+    return new (palloc(sizeof(hll_union_with_registers))) hll_union_with_registers(lg_k);
   } catch (std::exception& e) {
     pg_error(e.what());
   }
@@ -135,7 +171,7 @@ void* hll_union_new(unsigned lg_k) {
 
 void hll_union_delete(void* unionptr) {
   try {
-    static_cast<hll_union_pg*>(unionptr)->~hll_union_pg();
+    static_cast<hll_union_with_registers*>(unionptr)->~hll_union_with_registers();
     pfree(unionptr);
   } catch (std::exception& e) {
     pg_error(e.what());
@@ -144,7 +180,20 @@ void hll_union_delete(void* unionptr) {
 
 void hll_union_update(void* unionptr, const void* sketchptr) {
   try {
-    static_cast<hll_union_pg*>(unionptr)->update(*static_cast<const hll_sketch_pg*>(sketchptr));
+    static_cast<hll_union_with_registers*>(unionptr)->sketch_union.update(*static_cast<const hll_sketch_pg*>(sketchptr));
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+}
+
+static bool hll_union_merge_registers_from_bytes(hll_union_with_registers& u, const uint8_t* bytes, unsigned length);
+
+void hll_union_update_with_bytes(void* unionptr, const char* buffer, unsigned length) {
+  try {
+    auto& u = *static_cast<hll_union_with_registers*>(unionptr);
+    if (!hll_union_merge_registers_from_bytes(u, reinterpret_cast<const uint8_t*>(buffer), length)) {
+      u.sketch_union.update(hll_sketch_pg::deserialize(buffer, length));
+    }
   } catch (std::exception& e) {
     pg_error(e.what());
   }
@@ -152,8 +201,10 @@ void hll_union_update(void* unionptr, const void* sketchptr) {
 
 void* hll_union_get_result(void* unionptr) {
   try {
-    auto sketchptr = new (palloc(sizeof(hll_sketch_pg))) hll_sketch_pg(static_cast<const hll_union_pg*>(unionptr)->get_result());
-    static_cast<hll_union_pg*>(unionptr)->~hll_union_pg();
+    auto& u = *static_cast<hll_union_with_registers*>(unionptr);
+    hll_union_merge_registers_into_union(u);
+    auto sketchptr = new (palloc(sizeof(hll_sketch_pg))) hll_sketch_pg(u.sketch_union.get_result());
+    u.~hll_union_with_registers();
     pfree(unionptr);
     return sketchptr;
   } catch (std::exception& e) {
@@ -164,10 +215,12 @@ void* hll_union_get_result(void* unionptr) {
 
 void* hll_union_get_result_tgt_type(void* unionptr, unsigned tgt_type) {
   try {
-    auto sketchptr = new (palloc(sizeof(hll_sketch_pg))) hll_sketch_pg(static_cast<const hll_union_pg*>(unionptr)->get_result(
+    auto& u = *static_cast<hll_union_with_registers*>(unionptr);
+    hll_union_merge_registers_into_union(u);
+    auto sketchptr = new (palloc(sizeof(hll_sketch_pg))) hll_sketch_pg(u.sketch_union.get_result(
       tgt_type == 4 ? datasketches::target_hll_type::HLL_4 : tgt_type == 6 ? datasketches::target_hll_type::HLL_6 : datasketches::target_hll_type::HLL_8
     ));
-    static_cast<hll_union_pg*>(unionptr)->~hll_union_pg();
+    u.~hll_union_with_registers();
     pfree(unionptr);
     return sketchptr;
   } catch (std::exception& e) {
@@ -175,3 +228,217 @@ void* hll_union_get_result_tgt_type(void* unionptr, unsigned tgt_type) {
   }
   pg_unreachable();
 }
+
+void hll_union_merge_pending(void* unionptr) {
+  try {
+    hll_union_merge_registers_into_union(*static_cast<hll_union_with_registers*>(unionptr));
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+}
+
+void* hll_union_get_result_copy(const void* unionptr, unsigned tgt_type) {
+  try {
+    const auto& u = *static_cast<const hll_union_with_registers*>(unionptr);
+    return new (palloc(sizeof(hll_sketch_pg))) hll_sketch_pg(u.sketch_union.get_result(
+      tgt_type == 6 ? datasketches::target_hll_type::HLL_6 : tgt_type == 8 ? datasketches::target_hll_type::HLL_8 : datasketches::target_hll_type::HLL_4
+    ));
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+  pg_unreachable();
+}
+
+double hll_union_get_estimate(const void* unionptr) {
+  try {
+    return static_cast<const hll_union_with_registers*>(unionptr)->sketch_union.get_estimate();
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+  pg_unreachable();
+}
+
+void hll_union_reset(void* unionptr) {
+  try {
+    auto& u = *static_cast<hll_union_with_registers*>(unionptr);
+    u.sketch_union.reset();
+    u.has_hll_mode_input = false;
+    if (u.registers != nullptr) {
+      pfree(u.registers);
+      u.registers = nullptr;
+    }
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+}
+
+// accessor that reads only the serialized preamble
+// returns false if the bytes must be fully deserialized instead
+// layout in HLL mode: preamble ints, serial version, family, lg k, lg arr, flags, cur min, mode,
+// HIP accumulator (8 bytes), kxq0 (8 bytes), kxq1 (8 bytes), num at cur min (4 bytes), aux count (4 bytes), registers
+// the HIP estimate is what the sketch reports unless it is out of order (built by a union)
+// list and set modes need the coupons to estimate
+
+static const uint8_t HLL_FAMILY = 7;
+static const uint8_t HLL_PREAMBLE_INTS = 10;
+static const uint8_t HLL_SERIAL_VERSION = 1;
+static const uint8_t HLL_MODE = 2;
+static const uint8_t HLL_TYPE_4 = 0;
+static const uint8_t HLL_TYPE_8 = 2;
+static const uint8_t HLL_FLAG_BIG_ENDIAN = 1;
+static const uint8_t HLL_FLAG_COMPACT = 8;
+static const uint8_t HLL_FLAG_OUT_OF_ORDER = 16;
+static const uint8_t HLL_MAX_LG_K = 21;
+static const unsigned HLL_REGISTERS_OFFSET = 40;
+static const unsigned HLL_AUX_KEY_BITS = 26;
+static const uint8_t HLL_AUX_TOKEN = 15;
+
+bool hll_sketch_peek_estimate(const char* buffer, unsigned length, double* estimate) {
+  if (length < 16 || buffer[0] != HLL_PREAMBLE_INTS || buffer[2] != HLL_FAMILY) return false;
+  if ((buffer[7] & 3) != HLL_MODE || (buffer[5] & HLL_FLAG_OUT_OF_ORDER)) return false;
+  std::memcpy(estimate, buffer + 8, sizeof(double));
+  return true;
+}
+
+// element-wise max of register arrays
+static inline void hll_registers_max(uint8_t* dst, const uint8_t* src, uint32_t n) {
+  uint32_t i = 0;
+#if defined(__SSE2__)
+  for (; i + 16 <= n; i += 16) {
+    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+    const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_max_epu8(a, b));
+  }
+#elif defined(__ARM_NEON)
+  for (; i + 16 <= n; i += 16) {
+    vst1q_u8(dst + i, vmaxq_u8(vld1q_u8(dst + i), vld1q_u8(src + i)));
+  }
+#endif
+  for (; i < n; ++i) dst[i] = std::max(dst[i], src[i]);
+}
+
+// element-wise max with packed 4-bit registers (low nibble first) offset by cur_min
+// n is the number of source bytes, so 2n registers are updated
+// exceptions (AUX_TOKEN) come out as cur_min + 15, which is not above the real value from the aux map
+static inline void hll4_registers_max(uint8_t* dst, const uint8_t* src, uint32_t n, uint8_t cur_min) {
+  uint32_t i = 0;
+#if defined(__SSE2__)
+  const __m128i mask = _mm_set1_epi8(0x0f);
+  const __m128i offset = _mm_set1_epi8(static_cast<char>(cur_min));
+  for (; i + 16 <= n; i += 16) {
+    const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    const __m128i lo = _mm_add_epi8(_mm_and_si128(b, mask), offset);
+    const __m128i hi = _mm_add_epi8(_mm_and_si128(_mm_srli_epi16(b, 4), mask), offset);
+    __m128i* d = reinterpret_cast<__m128i*>(dst + 2 * i);
+    _mm_storeu_si128(d, _mm_max_epu8(_mm_loadu_si128(d), _mm_unpacklo_epi8(lo, hi)));
+    _mm_storeu_si128(d + 1, _mm_max_epu8(_mm_loadu_si128(d + 1), _mm_unpackhi_epi8(lo, hi)));
+  }
+#elif defined(__ARM_NEON)
+  const uint8x16_t mask = vdupq_n_u8(0x0f);
+  const uint8x16_t offset = vdupq_n_u8(cur_min);
+  for (; i + 16 <= n; i += 16) {
+    const uint8x16_t b = vld1q_u8(src + i);
+    const uint8x16x2_t slots = vzipq_u8(vaddq_u8(vandq_u8(b, mask), offset), vaddq_u8(vshrq_n_u8(b, 4), offset));
+    uint8_t* d = dst + 2 * i;
+    vst1q_u8(d, vmaxq_u8(vld1q_u8(d), slots.val[0]));
+    vst1q_u8(d + 16, vmaxq_u8(vld1q_u8(d + 16), slots.val[1]));
+  }
+#endif
+  for (; i < n; ++i) {
+    dst[2 * i] = std::max(dst[2 * i], static_cast<uint8_t>((src[i] & 0x0f) + cur_min));
+    dst[2 * i + 1] = std::max(dst[2 * i + 1], static_cast<uint8_t>((src[i] >> 4) + cur_min));
+  }
+}
+
+// returns false if the bytes must be deserialized and merged by the union instead:
+// the first input in HLL mode, list and set modes, HLL_6, lg_k below the union's lg_max_k, big endian or malformed input
+// registers of a sketch with a larger lg_k fold onto slot & (k - 1), as the union does when it downsamples
+static bool hll_union_merge_registers_from_bytes(hll_union_with_registers& u, const uint8_t* bytes, unsigned length) {
+  if (length < HLL_REGISTERS_OFFSET) return false;
+  if (bytes[0] != HLL_PREAMBLE_INTS || bytes[1] != HLL_SERIAL_VERSION || bytes[2] != HLL_FAMILY) return false;
+  if ((bytes[7] & 3) != HLL_MODE || (bytes[5] & HLL_FLAG_BIG_ENDIAN)) return false;
+  const uint8_t lg_k = bytes[3];
+  if (lg_k < u.lg_max_k || lg_k > HLL_MAX_LG_K) return false;
+  const uint8_t tgt_type = (bytes[7] >> 2) & 3;
+  const uint32_t k = 1 << lg_k;
+  const uint32_t union_k = 1 << u.lg_max_k;
+  const uint8_t* src = bytes + HLL_REGISTERS_OFFSET;
+
+  // HLL_4 exceptions follow the registers: aux_count pairs if compact, otherwise the whole hash table
+  uint32_t aux_ints = 0;
+  if (tgt_type == HLL_TYPE_8) {
+    if (length < HLL_REGISTERS_OFFSET + k) return false;
+  } else if (tgt_type == HLL_TYPE_4) {
+    uint32_t aux_count;
+    std::memcpy(&aux_count, bytes + 36, sizeof(aux_count));
+    if (bytes[5] & HLL_FLAG_COMPACT) {
+      aux_ints = aux_count;
+    } else if (aux_count > 0) {
+      if (bytes[4] > lg_k) return false;
+      aux_ints = 1 << bytes[4];
+    }
+    if (length < HLL_REGISTERS_OFFSET + k / 2 + static_cast<uint64_t>(aux_ints) * sizeof(uint32_t)) return false;
+  } else {
+    return false;
+  }
+  if (!u.has_hll_mode_input) {
+    u.has_hll_mode_input = true;
+    return false;
+  }
+
+  if (u.registers == nullptr) {
+    u.registers = static_cast<uint8_t*>(palloc(union_k));
+    std::memset(u.registers, 0, union_k);
+  }
+
+  if (tgt_type == HLL_TYPE_8) {
+    for (uint32_t i = 0; i < k; i += union_k) hll_registers_max(u.registers, src + i, union_k);
+  } else {
+    const uint8_t cur_min = bytes[6];
+    for (uint32_t i = 0; i < k / 2; i += union_k / 2) hll4_registers_max(u.registers, src + i, union_k / 2, cur_min);
+    const uint8_t* aux = src + k / 2;
+    for (uint32_t i = 0; i < aux_ints; ++i) {
+      uint32_t pair;
+      std::memcpy(&pair, aux + i * sizeof(pair), sizeof(pair));
+      if (pair == 0) continue; // empty slot in the hash table of an updatable sketch
+      const uint32_t slot = pair & (union_k - 1);
+      u.registers[slot] = std::max(u.registers[slot], static_cast<uint8_t>(pair >> HLL_AUX_KEY_BITS));
+    }
+  }
+  return true;
+}
+
+// serializes the accumulated registers as an out of order HLL_8 sketch and updates the union with it
+static void hll_union_merge_registers_into_union(hll_union_with_registers& u) {
+  if (u.registers == nullptr) return;
+  const uint32_t k = 1 << u.lg_max_k;
+  uint8_t cur_min = u.registers[0];
+  uint32_t num_at_cur_min = 0;
+  double kxq0 = 0;
+  double kxq1 = 0;
+  for (uint32_t i = 0; i < k; ++i) {
+    const uint8_t value = u.registers[i];
+    if (value < cur_min) {
+      cur_min = value;
+      num_at_cur_min = 0;
+    }
+    if (value == cur_min) ++num_at_cur_min;
+    if (value < 32) kxq0 += std::ldexp(1.0, -value);
+    else kxq1 += std::ldexp(1.0, -value);
+  }
+  std::vector<uint8_t, palloc_allocator<uint8_t>> bytes(HLL_REGISTERS_OFFSET + k, 0);
+  bytes[0] = HLL_PREAMBLE_INTS;
+  bytes[1] = HLL_SERIAL_VERSION;
+  bytes[2] = HLL_FAMILY;
+  bytes[3] = u.lg_max_k;
+  bytes[5] = HLL_FLAG_OUT_OF_ORDER;
+  bytes[6] = cur_min;
+  bytes[7] = HLL_MODE | (HLL_TYPE_8 << 2);
+  std::memcpy(bytes.data() + 16, &kxq0, sizeof(kxq0));
+  std::memcpy(bytes.data() + 24, &kxq1, sizeof(kxq1));
+  std::memcpy(bytes.data() + 32, &num_at_cur_min, sizeof(num_at_cur_min));
+  std::memcpy(bytes.data() + HLL_REGISTERS_OFFSET, u.registers, k);
+  pfree(u.registers);
+  u.registers = nullptr;
+  u.sketch_union.update(hll_sketch_pg::deserialize(bytes.data(), bytes.size()));
+}
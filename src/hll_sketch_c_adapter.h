@@ -31,6 +31,8 @@ void* hll_sketch_new_tgt_type(unsigned lg_k, unsigned tgt_type);
 void hll_sketch_delete(void* sketchptr);
 
 void hll_sketch_update(void* sketchptr, const void* data, unsigned length);
+// little-endian 64-bit hashes, see datasketches_hash
+void hll_sketch_update_packed(void* sketchptr, const char* data, unsigned num_items);
 void hll_sketch_merge(void* sketchptr1, const void* sketchptr2);
 double hll_sketch_get_estimate(const void* sketchptr);
 void** hll_sketch_get_estimate_and_bounds(const void* sketchptr, unsigned num_std_devs);
@@ -39,11 +41,22 @@ char* hll_sketch_to_string(const void* sketchptr);
 struct ptr_with_size hll_sketch_serialize(const void* sketchptr, unsigned header_size);
 void* hll_sketch_deserialize(const char* buffer, unsigned length);
 
+// enough for the estimate
+static const unsigned HLL_SKETCH_ESTIMATE_SLICE_SIZE = 16;
+bool hll_sketch_peek_estimate(const char* buffer, unsigned length, double* estimate);
+
 void* hll_union_new(unsigned lg_k);
 void hll_union_delete(void* unionptr);
 void hll_union_update(void* unionptr, const void* sketchptr);
+void hll_union_update_with_bytes(void* unionptr, const char* buffer, unsigned length);
 void* hll_union_get_result(void* unionptr);
 void* hll_union_get_result_tgt_type(void* unionptr, unsigned tgt_type);
+// registers merged from serialized bytes are kept aside until the result is needed
+// the union is kept by these, hll_union_merge_pending must be called before getting the result
+void hll_union_merge_pending(void* unionptr);
+void* hll_union_get_result_copy(const void* unionptr, unsigned tgt_type);
+double hll_union_get_estimate(const void* unionptr);
+void hll_union_reset(void* unionptr);
 
 #ifdef __cplusplus
 }
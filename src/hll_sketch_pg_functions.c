@@ -25,6 +25,11 @@
 #include <catalog/pg_type.h>
 
 #include "hll_sketch_c_adapter.h"
+#include "fn_cache.h"
+#include "agg_context.h"
+#include "window_queue.h"
+#include "expanded_sketch.h"
+#include "sketch_array.h"
 
 enum hll_agg_state_type { SKETCH, UNION };
 
@@ -33,9 +38,11 @@ struct hll_agg_state {
   unsigned lg_k;
   unsigned tgt_type;
   void* ptr;
+  struct object_pool* pool; // the union is pooled if not NULL, see fn_cache.h
 };
 
 const unsigned HLL_DEFAULT_LG_K = 12;
+const unsigned HLL_MIN_LG_K = 4;
 
 /* PG_FUNCTION_INFO_V1 macro to pass functions to postgres */
 PG_FUNCTION_INFO_V1(pg_hll_sketch_build_agg);
@@ -49,6 +56,11 @@ PG_FUNCTION_INFO_V1(pg_hll_sketch_get_estimate);
 PG_FUNCTION_INFO_V1(pg_hll_sketch_get_estimate_and_bounds);
 PG_FUNCTION_INFO_V1(pg_hll_sketch_to_string);
 PG_FUNCTION_INFO_V1(pg_hll_sketch_union);
+PG_FUNCTION_INFO_V1(pg_hll_sketch_union_moving_agg);
+PG_FUNCTION_INFO_V1(pg_hll_sketch_union_moving_inv);
+PG_FUNCTION_INFO_V1(pg_hll_sketch_union_moving_final);
+PG_FUNCTION_INFO_V1(pg_hll_sketch_union_array);
+PG_FUNCTION_INFO_V1(pg_hll_sketch_update_packed);
 
 /* function declarations */
 Datum pg_hll_sketch_build_agg(PG_FUNCTION_ARGS);
@@ -62,16 +74,44 @@ Datum pg_hll_sketch_get_estimate(PG_FUNCTION_ARGS);
 Datum pg_hll_sketch_get_estimate_and_bounds(PG_FUNCTION_ARGS);
 Datum pg_hll_sketch_to_string(PG_FUNCTION_ARGS);
 Datum pg_hll_sketch_union(PG_FUNCTION_ARGS);
+Datum pg_hll_sketch_union_moving_agg(PG_FUNCTION_ARGS);
+Datum pg_hll_sketch_union_moving_inv(PG_FUNCTION_ARGS);
+Datum pg_hll_sketch_union_moving_final(PG_FUNCTION_ARGS);
+Datum pg_hll_sketch_union_array(PG_FUNCTION_ARGS);
+Datum pg_hll_sketch_update_packed(PG_FUNCTION_ARGS);
+
+// the result of the pooled union of the state, which is reset and handed over to the next group
+static void* hll_agg_state_release(struct hll_agg_state* stateptr) {
+  void* sketchptr;
+  MemoryContext oldcontext = MemoryContextSwitchTo(object_pool_context(stateptr->pool));
+  hll_union_merge_pending(stateptr->ptr);
+  MemoryContextSwitchTo(oldcontext);
+  sketchptr = hll_union_get_result_copy(stateptr->ptr, stateptr->tgt_type);
+  MemoryContextSwitchTo(object_pool_context(stateptr->pool));
+  hll_union_reset(stateptr->ptr);
+  if (!object_pool_release(stateptr->pool, POOLED_HLL_UNION, stateptr->lg_k, stateptr->ptr)) {
+    hll_union_delete(stateptr->ptr);
+  }
+  MemoryContextSwitchTo(oldcontext);
+  stateptr->ptr = NULL;
+  stateptr->pool = NULL;
+  return sketchptr;
+}
+
+// a pooled union is only used by sorted aggregation, where the group gets no more updates after the final function
+// it is handed over to the next group, the state keeps the result
+static void hll_agg_state_release_to_result(struct hll_agg_state* stateptr) {
+  if (stateptr->pool == NULL) return;
+  stateptr->ptr = hll_agg_state_release(stateptr);
+  stateptr->type = SKETCH;
+}
 
 Datum pg_hll_sketch_build_agg(PG_FUNCTION_ARGS) {
   struct hll_agg_state* stateptr;
 
   // anyelement
-  Oid   element_type;
-  Datum element;
-  int16 typlen;
-  bool  typbyval;
-  char  typalign;
+  const void* element;
+  unsigned length;
 
   MemoryContext oldcontext;
   MemoryContext aggcontext;
@@ -85,12 +125,12 @@ Datum pg_hll_sketch_build_agg(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "hll_sketch_build_agg called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "hll_sketch"));
 
   if (PG_ARGISNULL(0)) {
     stateptr = palloc(sizeof(struct hll_agg_state));
     stateptr->type = SKETCH;
-    stateptr->lg_k = PG_NARGS() > 2 ? PG_GETARG_INT32(2) : HLL_DEFAULT_LG_K;
+    stateptr->lg_k = sketch_agg_lg_k(CurrentMemoryContext, NULL, PG_NARGS() > 2 ? PG_GETARG_INT32(2) : HLL_DEFAULT_LG_K, HLL_MIN_LG_K);
     stateptr->tgt_type = PG_NARGS() > 3 ? PG_GETARG_INT32(3) : 0;
     if (stateptr->tgt_type) {
       if ((stateptr->tgt_type != 4) && (stateptr->tgt_type != 6) && (stateptr->tgt_type != 8)) {
@@ -100,23 +140,13 @@ Datum pg_hll_sketch_build_agg(PG_FUNCTION_ARGS) {
     } else {
       stateptr->ptr = hll_sketch_new(stateptr->lg_k);
     }
+    stateptr->pool = NULL;
   } else {
     stateptr = (struct hll_agg_state*) PG_GETARG_POINTER(0);
   }
 
-  element_type = get_fn_expr_argtype(fcinfo->flinfo, 1);
-  element = PG_GETARG_DATUM(1);
-  get_typlenbyvalalign(element_type, &typlen, &typbyval, &typalign);
-  if (typlen == -1) {
-    // varlena
-    hll_sketch_update(stateptr->ptr, VARDATA_ANY(element), VARSIZE_ANY_EXHDR(element));
-  } else if (typbyval) {
-    // fixed-length passed by value
-    hll_sketch_update(stateptr->ptr, &element, typlen);
-  } else {
-    // fixed-length passed by reference
-    hll_sketch_update(stateptr->ptr, (void*)element, typlen);
-  }
+  element = fn_cache_get_element(fcinfo, 1, &length);
+  hll_sketch_update(stateptr->ptr, element, length);
 
   MemoryContextSwitchTo(oldcontext);
 
@@ -126,7 +156,6 @@ Datum pg_hll_sketch_build_agg(PG_FUNCTION_ARGS) {
 Datum pg_hll_sketch_union_agg(PG_FUNCTION_ARGS) {
   struct hll_agg_state* stateptr;
   bytea* sketch_bytes;
-  void* sketchptr;
 
   MemoryContext oldcontext;
   MemoryContext aggcontext;
@@ -140,11 +169,12 @@ Datum pg_hll_sketch_union_agg(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "hll_sketch_union_agg called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "hll_sketch"));
 
   if (PG_ARGISNULL(0)) {
     stateptr = palloc(sizeof(struct hll_agg_state));
     stateptr->type = UNION;
+    stateptr->pool = fn_cache_get_object_pool(fcinfo);
     stateptr->lg_k = PG_NARGS() > 2 ? PG_GETARG_INT32(2) : HLL_DEFAULT_LG_K;
     stateptr->tgt_type = PG_NARGS() > 3 ? PG_GETARG_INT32(3) : 0;
     if (stateptr->tgt_type) {
@@ -152,24 +182,29 @@ Datum pg_hll_sketch_union_agg(PG_FUNCTION_ARGS) {
         elog(ERROR, "hll_sketch_union_agg: unsupported target type, must be 4, 6 or 8");
       }
     }
-    stateptr->ptr = hll_union_new(stateptr->lg_k);
+    stateptr->ptr = stateptr->pool ? object_pool_acquire(stateptr->pool, POOLED_HLL_UNION, stateptr->lg_k) : NULL;
   } else {
     stateptr = (struct hll_agg_state*) PG_GETARG_POINTER(0);
   }
 
-  sketch_bytes = PG_GETARG_BYTEA_P(1);
-  sketchptr = hll_sketch_deserialize(VARDATA(sketch_bytes), VARSIZE(sketch_bytes) - VARHDRSZ);
-  hll_union_update(stateptr->ptr, sketchptr);
-  hll_sketch_delete(sketchptr);
+  sketch_bytes = PG_GETARG_BYTEA_PP(1);
+  // a pooled union outlives the aggregate context
+  if (stateptr->pool) MemoryContextSwitchTo(object_pool_context(stateptr->pool));
+  if (stateptr->ptr == NULL) {
+    stateptr->ptr = hll_union_new(stateptr->lg_k);
+  }
+  hll_union_update_with_bytes(stateptr->ptr, VARDATA_ANY(sketch_bytes), VARSIZE_ANY_EXHDR(sketch_bytes));
 
   MemoryContextSwitchTo(oldcontext);
 
   PG_RETURN_POINTER(stateptr);
 }
 
+// does not destroy the state, so that window aggregates can call it after every row
 Datum pg_hll_sketch_from_internal(PG_FUNCTION_ARGS) {
   struct hll_agg_state* stateptr;
   struct ptr_with_size bytes_out;
+  void* sketchptr;
 
   MemoryContext oldcontext;
   MemoryContext aggcontext;
@@ -179,23 +214,19 @@ Datum pg_hll_sketch_from_internal(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "hll_sketch_from_internal called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "hll_sketch"));
 
   stateptr = (struct hll_agg_state*) PG_GETARG_POINTER(0);
-  if (stateptr->type == UNION) {
-    if (stateptr->tgt_type) {
-      stateptr->ptr = hll_union_get_result_tgt_type(stateptr->ptr, stateptr->tgt_type);
-    } else {
-      stateptr->ptr = hll_union_get_result(stateptr->ptr);
-    }
-  }
-  bytes_out = hll_sketch_serialize(stateptr->ptr, VARHDRSZ);
-  hll_sketch_delete(stateptr->ptr);
-  pfree(stateptr);
-  SET_VARSIZE(bytes_out.ptr, bytes_out.size);
+  hll_agg_state_release_to_result(stateptr);
+  if (stateptr->type == UNION) hll_union_merge_pending(stateptr->ptr);
 
   MemoryContextSwitchTo(oldcontext);
 
+  sketchptr = stateptr->type == UNION ? hll_union_get_result_copy(stateptr->ptr, stateptr->tgt_type) : stateptr->ptr;
+  bytes_out = hll_sketch_serialize(sketchptr, VARHDRSZ);
+  if (sketchptr != stateptr->ptr) hll_sketch_delete(sketchptr);
+  SET_VARSIZE(bytes_out.ptr, bytes_out.size);
+
   PG_RETURN_BYTEA_P(bytes_out.ptr);
 }
 
@@ -211,12 +242,16 @@ Datum pg_hll_sketch_get_estimate_from_internal(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "hll_sketch_get_estimate_from_internal called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "hll_sketch"));
 
   stateptr = (struct hll_agg_state*) PG_GETARG_POINTER(0);
-  estimate = hll_sketch_get_estimate(stateptr->ptr);
-  hll_sketch_delete(stateptr->ptr);
-  pfree(stateptr);
+  hll_agg_state_release_to_result(stateptr);
+  if (stateptr->type == UNION) {
+    hll_union_merge_pending(stateptr->ptr);
+    estimate = hll_union_get_estimate(stateptr->ptr); // the estimate without getting the result
+  } else {
+    estimate = hll_sketch_get_estimate(stateptr->ptr);
+  }
 
   MemoryContextSwitchTo(oldcontext);
 
@@ -227,6 +262,7 @@ Datum pg_hll_sketch_combine(PG_FUNCTION_ARGS) {
   struct hll_agg_state* stateptr1;
   struct hll_agg_state* stateptr2;
   struct hll_agg_state* stateptr;
+  void* unionptr;
 
   MemoryContext oldcontext;
   MemoryContext aggcontext;
@@ -236,45 +272,33 @@ Datum pg_hll_sketch_combine(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "hll_sketch_combine called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "hll_sketch"));
 
   stateptr1 = (struct hll_agg_state*) PG_GETARG_POINTER(0);
   stateptr2 = (struct hll_agg_state*) PG_GETARG_POINTER(1);
 
-  stateptr = palloc(sizeof(struct hll_agg_state));
-  stateptr->type = SKETCH;
-  stateptr->lg_k = stateptr1 ? stateptr1->lg_k : stateptr2->lg_k;
-  stateptr->tgt_type = stateptr1 ? stateptr1->tgt_type : stateptr2->tgt_type;
-  stateptr->ptr = hll_union_new(stateptr->lg_k);
-
-  if (stateptr1) {
-    if (stateptr1->type == UNION) {
-      if (stateptr1->tgt_type) {
-        stateptr1->ptr = hll_union_get_result_tgt_type(stateptr1->ptr, stateptr1->tgt_type);
-      } else {
-        stateptr1->ptr = hll_union_get_result(stateptr1->ptr);
+  // the second state is merged into the first one, which becomes a union if it is not one yet
+  // the result is left as a union and converted to the target type only by the final function
+  if (stateptr1 == NULL) {
+    stateptr = stateptr2;
+  } else {
+    stateptr = stateptr1;
+    if (stateptr2) {
+      if (stateptr->type != UNION) {
+        unionptr = hll_union_new(stateptr->lg_k);
+        hll_union_update(unionptr, stateptr->ptr);
+        hll_sketch_delete(stateptr->ptr);
+        stateptr->type = UNION;
+        stateptr->ptr = unionptr;
       }
-    }
-    hll_union_update(stateptr->ptr, stateptr1->ptr);
-    hll_sketch_delete(stateptr1->ptr);
-    pfree(stateptr1);
-  }
-  if (stateptr2) {
-    if (stateptr2->type == UNION) {
-      if (stateptr2->tgt_type) {
-        stateptr2->ptr = hll_union_get_result_tgt_type(stateptr2->ptr, stateptr2->tgt_type);
-      } else {
-        stateptr2->ptr = hll_union_get_result(stateptr2->ptr);
+      if (stateptr2->type == UNION) {
+        // HLL_8 is the cheapest form to merge, no need to pack into HLL_4
+        stateptr2->ptr = hll_union_get_result_tgt_type(stateptr2->ptr, 8);
       }
+      hll_union_update(stateptr->ptr, stateptr2->ptr);
+      hll_sketch_delete(stateptr2->ptr);
+      pfree(stateptr2);
     }
-    hll_union_update(stateptr->ptr, stateptr2->ptr);
-    hll_sketch_delete(stateptr2->ptr);
-    pfree(stateptr2);
-  }
-  if (stateptr->tgt_type) {
-    stateptr->ptr = hll_union_get_result_tgt_type(stateptr->ptr, stateptr->tgt_type);
-  } else {
-    stateptr->ptr = hll_union_get_result(stateptr->ptr);
   }
 
   MemoryContextSwitchTo(oldcontext);
@@ -294,7 +318,7 @@ Datum pg_hll_sketch_serialize_state(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "hll_sketch_serialize_state called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "hll_sketch"));
 
   stateptr = (struct hll_agg_state*) PG_GETARG_POINTER(0);
   if (stateptr->type == UNION) {
@@ -328,11 +352,12 @@ Datum pg_hll_sketch_deserialize_state(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "hll_sketch_deserialize_state called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "hll_sketch"));
 
   bytes_in = PG_GETARG_BYTEA_P(0);
   stateptr = palloc(sizeof(struct hll_agg_state));
   stateptr->type = SKETCH;
+  stateptr->pool = NULL;
   stateptr->lg_k = *VARDATA(bytes_in);
   stateptr->tgt_type = *(VARDATA(bytes_in) + 1);
   stateptr->ptr = hll_sketch_deserialize(VARDATA(bytes_in) + 2, VARSIZE(bytes_in) - VARHDRSZ - 2);
@@ -346,10 +371,14 @@ Datum pg_hll_sketch_get_estimate(PG_FUNCTION_ARGS) {
   const bytea* bytes_in;
   void* sketchptr;
   double estimate;
-  bytes_in = PG_GETARG_BYTEA_P(0);
-  sketchptr = hll_sketch_deserialize(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ);
-  estimate = hll_sketch_get_estimate(sketchptr);
-  hll_sketch_delete(sketchptr);
+  // HIP estimate is in the preamble, try to read just that
+  bytes_in = PG_GETARG_BYTEA_P_SLICE(0, 0, HLL_SKETCH_ESTIMATE_SLICE_SIZE);
+  if (!hll_sketch_peek_estimate(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ, &estimate)) {
+    bytes_in = PG_GETARG_BYTEA_P(0);
+    sketchptr = hll_sketch_deserialize(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ);
+    estimate = hll_sketch_get_estimate(sketchptr);
+    hll_sketch_delete(sketchptr);
+  }
   PG_RETURN_FLOAT8(estimate);
 }
 
@@ -388,14 +417,25 @@ Datum pg_hll_sketch_to_string(PG_FUNCTION_ARGS) {
   PG_RETURN_TEXT_P(cstring_to_text(str));
 }
 
-Datum pg_hll_sketch_union(PG_FUNCTION_ARGS) {
-  const bytea* bytes_in1;
-  const bytea* bytes_in2;
-  void* sketchptr1;
-  void* sketchptr2;
-  void* unionptr;
-  void* sketchptr;
+// intermediate results are kept as HLL_8, which the union takes without conversion
+static struct ptr_with_size hll_union_ops_serialize(void* unionptr, unsigned tgt_type, unsigned header_size) {
   struct ptr_with_size bytes_out;
+  void* sketchptr;
+  hll_union_merge_pending(unionptr);
+  sketchptr = hll_union_get_result_copy(unionptr, tgt_type ? tgt_type : 8);
+  bytes_out = hll_sketch_serialize(sketchptr, header_size);
+  hll_sketch_delete(sketchptr);
+  return bytes_out;
+}
+
+static const struct sketch_union_ops hll_union_ops = {
+  hll_union_new,
+  hll_union_update_with_bytes,
+  hll_union_ops_serialize,
+  hll_union_delete
+};
+
+Datum pg_hll_sketch_union(PG_FUNCTION_ARGS) {
   unsigned lg_k;
   unsigned tgt_type;
 
@@ -406,18 +446,96 @@ Datum pg_hll_sketch_union(PG_FUNCTION_ARGS) {
       elog(ERROR, "hll_sketch_union: unsupported target type, must be 4, 6 or 8");
     }
   }
-  unionptr = hll_union_new(lg_k);
-  if (!PG_ARGISNULL(0)) {
-    bytes_in1 = PG_GETARG_BYTEA_P(0);
-    sketchptr1 = hll_sketch_deserialize(VARDATA(bytes_in1), VARSIZE(bytes_in1) - VARHDRSZ);
-    hll_union_update(unionptr, sketchptr1);
-    hll_sketch_delete(sketchptr1);
+  PG_RETURN_DATUM(expanded_sketch_union(fcinfo, &hll_union_ops, lg_k, tgt_type ? tgt_type : 4));
+}
+
+// moving-aggregate mode of hll_sketch_union over sliding window frames, see window_queue.h
+Datum pg_hll_sketch_union_moving_agg(PG_FUNCTION_ARGS) {
+  struct window_queue* queue;
+  bytea* sketch_bytes;
+  unsigned lg_k;
+  unsigned tgt_type;
+
+  MemoryContext oldcontext;
+  MemoryContext aggcontext;
+
+  if (!AggCheckCallContext(fcinfo, &aggcontext)) {
+    elog(ERROR, "hll_sketch_union_moving_agg called in non-aggregate context");
+  }
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "hll_sketch"));
+
+  if (PG_ARGISNULL(0)) {
+    lg_k = PG_NARGS() > 2 ? PG_GETARG_INT32(2) : HLL_DEFAULT_LG_K;
+    tgt_type = PG_NARGS() > 3 ? PG_GETARG_INT32(3) : 0;
+    if (tgt_type) {
+      if ((tgt_type != 4) && (tgt_type != 6) && (tgt_type != 8)) {
+        elog(ERROR, "hll_sketch_union_moving_agg: unsupported target type, must be 4, 6 or 8");
+      }
+    }
+    queue = window_queue_new(&hll_union_ops, lg_k, tgt_type ? tgt_type : 4);
+  } else {
+    queue = (struct window_queue*) PG_GETARG_POINTER(0);
   }
+
+  // the inverse function skips null values too
   if (!PG_ARGISNULL(1)) {
-    bytes_in2 = PG_GETARG_BYTEA_P(1);
-    sketchptr2 = hll_sketch_deserialize(VARDATA(bytes_in2), VARSIZE(bytes_in2) - VARHDRSZ);
-    hll_union_update(unionptr, sketchptr2);
-    hll_sketch_delete(sketchptr2);
+    sketch_bytes = PG_GETARG_BYTEA_PP(1);
+    window_queue_push(queue, VARDATA_ANY(sketch_bytes), VARSIZE_ANY_EXHDR(sketch_bytes));
+  }
+
+  MemoryContextSwitchTo(oldcontext);
+
+  PG_RETURN_POINTER(queue);
+}
+
+Datum pg_hll_sketch_union_moving_inv(PG_FUNCTION_ARGS) {
+  struct window_queue* queue;
+
+  if (!AggCheckCallContext(fcinfo, NULL)) {
+    elog(ERROR, "hll_sketch_union_moving_inv called in non-aggregate context");
+  }
+
+  queue = (struct window_queue*) PG_GETARG_POINTER(0);
+  if (!PG_ARGISNULL(1)) window_queue_pop(queue);
+
+  PG_RETURN_POINTER(queue);
+}
+
+Datum pg_hll_sketch_union_moving_final(PG_FUNCTION_ARGS) {
+  bytea* bytes_out;
+
+  if (PG_ARGISNULL(0)) PG_RETURN_NULL();
+
+  if (!AggCheckCallContext(fcinfo, NULL)) {
+    elog(ERROR, "hll_sketch_union_moving_final called in non-aggregate context");
+  }
+
+  bytes_out = window_queue_get_result((struct window_queue*) PG_GETARG_POINTER(0));
+  if (bytes_out == NULL) PG_RETURN_NULL();
+  PG_RETURN_BYTEA_P(bytes_out);
+}
+
+// the whole array in one call, without serializing intermediate results
+Datum pg_hll_sketch_union_array(PG_FUNCTION_ARGS) {
+  struct sketch_array sketches;
+  void* unionptr;
+  void* sketchptr;
+  struct ptr_with_size bytes_out;
+  unsigned lg_k;
+  unsigned tgt_type;
+  unsigned i;
+
+  lg_k = PG_NARGS() > 1 ? PG_GETARG_INT32(1) : HLL_DEFAULT_LG_K;
+  tgt_type = PG_NARGS() > 2 ? PG_GETARG_INT32(2) : 0;
+  if (tgt_type) {
+    if ((tgt_type != 4) && (tgt_type != 6) && (tgt_type != 8)) {
+      elog(ERROR, "hll_sketch_union: unsupported target type, must be 4, 6 or 8");
+    }
+  }
+  sketch_array_init(&sketches, PG_GETARG_ARRAYTYPE_P(0), false);
+  unionptr = hll_union_new(lg_k);
+  for (i = 0; i < sketches.num_sketches; i++) {
+    hll_union_update_with_bytes(unionptr, sketches.buffers[i], sketches.lengths[i]);
   }
   if (tgt_type) {
     sketchptr = hll_union_get_result_tgt_type(unionptr, tgt_type);
@@ -427,6 +545,35 @@ Datum pg_hll_sketch_union(PG_FUNCTION_ARGS) {
   bytes_out = hll_sketch_serialize(sketchptr, VARHDRSZ);
   hll_sketch_delete(sketchptr);
   SET_VARSIZE(bytes_out.ptr, bytes_out.size);
-  
+  PG_RETURN_BYTEA_P(bytes_out.ptr);
+}
+
+// adds a batch of hashes packed by the client to the sketch
+// a null sketch is a new one with the given lg_k, otherwise the sketch keeps its parameters
+Datum pg_hll_sketch_update_packed(PG_FUNCTION_ARGS) {
+  const bytea* bytes_in;
+  const bytea* packed;
+  void* sketchptr;
+  struct ptr_with_size bytes_out;
+
+  if (PG_ARGISNULL(1)) {
+    if (PG_ARGISNULL(0)) PG_RETURN_NULL();
+    PG_RETURN_DATUM(PG_GETARG_DATUM(0));
+  }
+  packed = PG_GETARG_BYTEA_PP(1);
+  if (VARSIZE_ANY_EXHDR(packed) % 8) {
+    elog(ERROR, "hll_sketch_update_packed expects packed 64-bit hashes, got %u bytes", (unsigned) VARSIZE_ANY_EXHDR(packed));
+  }
+
+  if (PG_ARGISNULL(0)) {
+    sketchptr = hll_sketch_new(PG_NARGS() > 2 && !PG_ARGISNULL(2) ? PG_GETARG_INT32(2) : HLL_DEFAULT_LG_K);
+  } else {
+    bytes_in = PG_GETARG_BYTEA_PP(0);
+    sketchptr = hll_sketch_deserialize(VARDATA_ANY(bytes_in), VARSIZE_ANY_EXHDR(bytes_in));
+  }
+  hll_sketch_update_packed(sketchptr, VARDATA_ANY(packed), VARSIZE_ANY_EXHDR(packed) / 8);
+  bytes_out = hll_sketch_serialize(sketchptr, VARHDRSZ);
+  hll_sketch_delete(sketchptr);
+  SET_VARSIZE(bytes_out.ptr, bytes_out.size);
   PG_RETURN_BYTEA_P(bytes_out.ptr);
 }
@@ -21,6 +21,7 @@
 #include "allocator.h"
 #include "postgres_h_substitute.h"
 
+#include <cstring>
 #include <kll_sketch.hpp>
 
 using kll_double_sketch = datasketches::kll_sketch<double, std::less<double>, palloc_allocator<double>>;
@@ -104,6 +105,16 @@ double kll_double_sketch_get_min_item(const void *sketchptr) {
     pg_unreachable();
 }
 
+void kll_double_sketch_setup_sorted_view(const void* sketchptr) {
+  try {
+    // quantile queries build the sorted view on first use and keep it in the sketch
+    auto sketch = static_cast<const kll_double_sketch*>(sketchptr);
+    if (!sketch->is_empty()) sketch->get_quantile(0);
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+}
+
 char* kll_double_sketch_to_string(const void* sketchptr) {
   try {
     auto str = static_cast<const kll_double_sketch*>(sketchptr)->to_string();
@@ -183,3 +194,51 @@ Datum* kll_double_sketch_get_quantiles(const void* sketchptr, const double* frac
   }
   pg_unreachable();
 }
+
+// accessors that read only the serialized preamble
+// return false if the bytes must be fully deserialized instead
+// layout: preamble ints, serial version, family, flags, k (2 bytes), m, unused,
+// then if more than one item: n (8 bytes), min k (2 bytes), num levels, unused, levels (4 bytes each), min item, max item
+// or if exactly one item: the item
+
+static const uint8_t KLL_FAMILY = 15;
+static const uint8_t KLL_FLAG_EMPTY = 1;
+static const uint8_t KLL_FLAG_SINGLE_ITEM = 4;
+
+bool kll_double_sketch_peek_n(const char* buffer, unsigned length, unsigned long long* n) {
+  if (length < 8 || buffer[2] != KLL_FAMILY) return false;
+  if (buffer[3] & KLL_FLAG_EMPTY) {
+    *n = 0;
+  } else if (buffer[3] & KLL_FLAG_SINGLE_ITEM) {
+    *n = 1;
+  } else {
+    uint64_t value;
+    if (length < 16) return false;
+    std::memcpy(&value, buffer + 8, sizeof(value));
+    *n = value;
+  }
+  return true;
+}
+
+static bool kll_double_sketch_peek_item(const char* buffer, unsigned length, bool max, double* item) {
+  unsigned offset;
+  // empty sketch has no min and max, let deserialization report that
+  if (length < 8 || buffer[2] != KLL_FAMILY || (buffer[3] & KLL_FLAG_EMPTY)) return false;
+  if (buffer[3] & KLL_FLAG_SINGLE_ITEM) {
+    offset = 8;
+  } else {
+    if (length < 20) return false;
+    offset = 20 + sizeof(uint32_t) * static_cast<uint8_t>(buffer[18]) + (max ? sizeof(double) : 0);
+  }
+  if (length < offset + sizeof(double)) return false;
+  std::memcpy(item, buffer + offset, sizeof(double));
+  return true;
+}
+
+bool kll_double_sketch_peek_min_item(const char* buffer, unsigned length, double* item) {
+  return kll_double_sketch_peek_item(buffer, length, false, item);
+}
+
+bool kll_double_sketch_peek_max_item(const char* buffer, unsigned length, double* item) {
+  return kll_double_sketch_peek_item(buffer, length, true, item);
+}
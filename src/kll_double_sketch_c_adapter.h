@@ -39,11 +39,21 @@ unsigned long long kll_double_sketch_get_n(const void* sketchptr);
 double kll_double_sketch_get_max_item(const void* sketchptr);
 double kll_double_sketch_get_min_item(const void* sketchptr);
 char* kll_double_sketch_to_string(const void* sketchptr);
+// for sketches that outlive the current memory context and are queried repeatedly
+void kll_double_sketch_setup_sorted_view(const void* sketchptr);
 
 struct ptr_with_size kll_double_sketch_serialize(const void* sketchptr, unsigned header_size);
 void* kll_double_sketch_deserialize(const char* buffer, unsigned length);
 unsigned kll_double_sketch_get_serialized_size_bytes(const void* sketchptr);
 
+// enough for n
+static const unsigned KLL_DOUBLE_SKETCH_N_SLICE_SIZE = 16;
+// enough for min and max items unless the sketch has unusually many levels
+static const unsigned KLL_DOUBLE_SKETCH_MIN_MAX_SLICE_SIZE = 512;
+bool kll_double_sketch_peek_n(const char* buffer, unsigned length, unsigned long long* n);
+bool kll_double_sketch_peek_min_item(const char* buffer, unsigned length, double* item);
+bool kll_double_sketch_peek_max_item(const char* buffer, unsigned length, double* item);
+
 void** kll_double_sketch_get_pmf_or_cdf(const void* sketchptr, const double* split_points, unsigned num_split_points, bool is_cdf, bool scale);
 void** kll_double_sketch_get_quantiles(const void* sketchptr, const double* fractions, unsigned num_fractions);
 
@@ -25,13 +25,23 @@
 #include <catalog/pg_type.h>
 
 #include "kll_double_sketch_c_adapter.h"
+#include "fn_cache.h"
+#include "quantiles_agg_state.h"
+#include "agg_context.h"
 
 /* PG_FUNCTION_INFO_V1 macro to pass functions to postgres */
 PG_FUNCTION_INFO_V1(pg_kll_double_sketch_build_agg);
 PG_FUNCTION_INFO_V1(pg_kll_double_sketch_merge_agg);
 PG_FUNCTION_INFO_V1(pg_kll_double_sketch_serialize);
+PG_FUNCTION_INFO_V1(pg_kll_double_sketch_finalize);
 PG_FUNCTION_INFO_V1(pg_kll_double_sketch_deserialize);
 PG_FUNCTION_INFO_V1(pg_kll_double_sketch_combine);
+PG_FUNCTION_INFO_V1(pg_kll_double_sketch_approx_agg);
+PG_FUNCTION_INFO_V1(pg_kll_double_sketch_approx_serialize);
+PG_FUNCTION_INFO_V1(pg_kll_double_sketch_approx_deserialize);
+PG_FUNCTION_INFO_V1(pg_kll_double_sketch_approx_combine);
+PG_FUNCTION_INFO_V1(pg_kll_double_sketch_approx_quantile);
+PG_FUNCTION_INFO_V1(pg_kll_double_sketch_approx_quantiles);
 PG_FUNCTION_INFO_V1(pg_kll_double_sketch_get_rank);
 PG_FUNCTION_INFO_V1(pg_kll_double_sketch_get_quantile);
 PG_FUNCTION_INFO_V1(pg_kll_double_sketch_get_n);
@@ -47,8 +57,15 @@ PG_FUNCTION_INFO_V1(pg_kll_double_sketch_get_histogram);
 Datum pg_kll_double_sketch_build_agg(PG_FUNCTION_ARGS);
 Datum pg_kll_double_sketch_merge_agg(PG_FUNCTION_ARGS);
 Datum pg_kll_double_sketch_serialize(PG_FUNCTION_ARGS);
+Datum pg_kll_double_sketch_finalize(PG_FUNCTION_ARGS);
 Datum pg_kll_double_sketch_deserialize(PG_FUNCTION_ARGS);
 Datum pg_kll_double_sketch_combine(PG_FUNCTION_ARGS);
+Datum pg_kll_double_sketch_approx_agg(PG_FUNCTION_ARGS);
+Datum pg_kll_double_sketch_approx_serialize(PG_FUNCTION_ARGS);
+Datum pg_kll_double_sketch_approx_deserialize(PG_FUNCTION_ARGS);
+Datum pg_kll_double_sketch_approx_combine(PG_FUNCTION_ARGS);
+Datum pg_kll_double_sketch_approx_quantile(PG_FUNCTION_ARGS);
+Datum pg_kll_double_sketch_approx_quantiles(PG_FUNCTION_ARGS);
 Datum pg_kll_double_sketch_get_rank(PG_FUNCTION_ARGS);
 Datum pg_kll_double_sketch_get_quantile(PG_FUNCTION_ARGS);
 Datum pg_kll_double_sketch_get_n(PG_FUNCTION_ARGS);
@@ -62,8 +79,35 @@ Datum pg_kll_double_sketch_get_histogram(PG_FUNCTION_ARGS);
 
 static const unsigned DEFAULT_NUM_BINS = 10;
 
+static void kll_double_agg_state_promote(struct quantiles_agg_state* stateptr) {
+  unsigned i;
+  if (stateptr->ptr) return;
+  stateptr->ptr = kll_double_sketch_new(stateptr->k);
+  for (i = 0; i < stateptr->num_values; i++) kll_double_sketch_update(stateptr->ptr, stateptr->values[i]);
+  quantiles_agg_state_free_values(stateptr);
+}
+
+static void kll_double_agg_state_update(struct quantiles_agg_state* stateptr, double value) {
+  if (!stateptr->ptr && quantiles_agg_state_add_value(stateptr, value)) return;
+  kll_double_agg_state_promote(stateptr);
+  kll_double_sketch_update(stateptr->ptr, value);
+}
+
+// merges state2 into state1 and frees state2
+static void kll_double_agg_state_merge(struct quantiles_agg_state* stateptr1, struct quantiles_agg_state* stateptr2) {
+  unsigned i;
+  if (stateptr2->ptr) {
+    kll_double_agg_state_promote(stateptr1);
+    kll_double_sketch_merge(stateptr1->ptr, stateptr2->ptr);
+    kll_double_sketch_delete(stateptr2->ptr);
+  } else {
+    for (i = 0; i < stateptr2->num_values; i++) kll_double_agg_state_update(stateptr1, stateptr2->values[i]);
+  }
+  quantiles_agg_state_delete(stateptr2);
+}
+
 Datum pg_kll_double_sketch_build_agg(PG_FUNCTION_ARGS) {
-  void* sketchptr;
+  struct quantiles_agg_state* stateptr;
   double value;
   int k;
 
@@ -79,25 +123,25 @@ Datum pg_kll_double_sketch_build_agg(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "kll_double_sketch_build_agg called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "kll_double_sketch"));
 
   if (PG_ARGISNULL(0)) {
     k = PG_NARGS() > 2 ? PG_GETARG_INT32(2) : DEFAULT_K;
-    sketchptr = kll_double_sketch_new(k);
+    stateptr = quantiles_agg_state_new(k, false);
   } else {
-    sketchptr = PG_GETARG_POINTER(0);
+    stateptr = (struct quantiles_agg_state*) PG_GETARG_POINTER(0);
   }
 
   value = PG_GETARG_FLOAT8(1);
-  kll_double_sketch_update(sketchptr, value);
+  kll_double_agg_state_update(stateptr, value);
 
   MemoryContextSwitchTo(oldcontext);
 
-  PG_RETURN_POINTER(sketchptr);
+  PG_RETURN_POINTER(stateptr);
 }
 
 Datum pg_kll_double_sketch_merge_agg(PG_FUNCTION_ARGS) {
-  void* unionptr;
+  struct quantiles_agg_state* stateptr;
   bytea* sketch_bytes;
   void* sketchptr;
   int k;
@@ -114,27 +158,28 @@ Datum pg_kll_double_sketch_merge_agg(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "kll_double_sketch_merge_agg called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "kll_double_sketch"));
 
   if (PG_ARGISNULL(0)) {
     k = PG_NARGS() > 2 ? PG_GETARG_INT32(2) : DEFAULT_K;
-    unionptr = kll_double_sketch_new(k);
+    stateptr = quantiles_agg_state_new(k, false);
   } else {
-    unionptr = PG_GETARG_POINTER(0);
+    stateptr = (struct quantiles_agg_state*) PG_GETARG_POINTER(0);
   }
 
   sketch_bytes = PG_GETARG_BYTEA_P(1);
   sketchptr = kll_double_sketch_deserialize(VARDATA(sketch_bytes), VARSIZE(sketch_bytes) - VARHDRSZ);
-  kll_double_sketch_merge(unionptr, sketchptr);
+  kll_double_agg_state_promote(stateptr);
+  kll_double_sketch_merge(stateptr->ptr, sketchptr);
   kll_double_sketch_delete(sketchptr);
 
   MemoryContextSwitchTo(oldcontext);
 
-  PG_RETURN_POINTER(unionptr);
+  PG_RETURN_POINTER(stateptr);
 }
 
 Datum pg_kll_double_sketch_serialize(PG_FUNCTION_ARGS) {
-  void* sketchptr;
+  struct quantiles_agg_state* stateptr;
   struct ptr_with_size bytes_out;
   MemoryContext aggcontext;
 
@@ -142,16 +187,44 @@ Datum pg_kll_double_sketch_serialize(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "kll_double_sketch_serialize called in non-aggregate context");
   }
-  sketchptr = PG_GETARG_POINTER(0);
-  bytes_out = kll_double_sketch_serialize(sketchptr, VARHDRSZ);
-  kll_double_sketch_delete(sketchptr);
+  stateptr = (struct quantiles_agg_state*) PG_GETARG_POINTER(0);
+  // exact values become a sketch only here, so the output is always a regular serialized sketch
+  kll_double_agg_state_promote(stateptr);
+  bytes_out = kll_double_sketch_serialize(stateptr->ptr, VARHDRSZ);
+  kll_double_sketch_delete(stateptr->ptr);
+  quantiles_agg_state_delete(stateptr);
+  SET_VARSIZE(bytes_out.ptr, bytes_out.size);
+  PG_RETURN_BYTEA_P(bytes_out.ptr);
+}
+
+// unlike serialize, does not destroy the state, so that window aggregates can call it after every row
+Datum pg_kll_double_sketch_finalize(PG_FUNCTION_ARGS) {
+  struct quantiles_agg_state* stateptr;
+  struct ptr_with_size bytes_out;
+
+  MemoryContext oldcontext;
+  MemoryContext aggcontext;
+
+  if (PG_ARGISNULL(0)) PG_RETURN_NULL();
+
+  if (!AggCheckCallContext(fcinfo, &aggcontext)) {
+    elog(ERROR, "kll_double_sketch_finalize called in non-aggregate context");
+  }
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "kll_double_sketch"));
+
+  stateptr = (struct quantiles_agg_state*) PG_GETARG_POINTER(0);
+  kll_double_agg_state_promote(stateptr);
+
+  MemoryContextSwitchTo(oldcontext);
+
+  bytes_out = kll_double_sketch_serialize(stateptr->ptr, VARHDRSZ);
   SET_VARSIZE(bytes_out.ptr, bytes_out.size);
   PG_RETURN_BYTEA_P(bytes_out.ptr);
 }
 
 Datum pg_kll_double_sketch_deserialize(PG_FUNCTION_ARGS) {
   const bytea* bytes_in;
-  void* sketchptr;
+  struct quantiles_agg_state* stateptr;
 
   MemoryContext oldcontext;
   MemoryContext aggcontext;
@@ -161,20 +234,21 @@ Datum pg_kll_double_sketch_deserialize(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "kll_double_sketch_deserialize called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "kll_double_sketch"));
 
   bytes_in = PG_GETARG_BYTEA_P(0);
-  sketchptr = kll_double_sketch_deserialize(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ);
+  stateptr = quantiles_agg_state_new(0, false);
+  stateptr->ptr = kll_double_sketch_deserialize(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ);
 
   MemoryContextSwitchTo(oldcontext);
 
-  PG_RETURN_POINTER(sketchptr);
+  PG_RETURN_POINTER(stateptr);
 }
 
 Datum pg_kll_double_sketch_combine(PG_FUNCTION_ARGS) {
-  void* sketchptr1;
-  void* sketchptr2;
-  void* sketchptr;
+  struct quantiles_agg_state* stateptr1;
+  struct quantiles_agg_state* stateptr2;
+  struct quantiles_agg_state* stateptr;
 
   MemoryContext oldcontext;
   MemoryContext aggcontext;
@@ -184,60 +258,218 @@ Datum pg_kll_double_sketch_combine(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "kll_double_sketch_combine called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "kll_double_sketch"));
 
-  sketchptr1 = PG_GETARG_POINTER(0);
-  sketchptr2 = PG_GETARG_POINTER(1);
+  stateptr1 = (struct quantiles_agg_state*) PG_GETARG_POINTER(0);
+  stateptr2 = (struct quantiles_agg_state*) PG_GETARG_POINTER(1);
 
-  if (sketchptr1) {
-    sketchptr = sketchptr1;
-    if (sketchptr2) {
-      kll_double_sketch_merge(sketchptr, sketchptr2);
+  if (stateptr1) {
+    stateptr = stateptr1;
+    if (stateptr2) {
+      kll_double_agg_state_merge(stateptr, stateptr2);
     }
-    kll_double_sketch_delete(sketchptr2);
   } else {
-    sketchptr = sketchptr2;
+    stateptr = stateptr2;
   }
 
   MemoryContextSwitchTo(oldcontext);
 
-  PG_RETURN_POINTER(sketchptr);
+  PG_RETURN_POINTER(stateptr);
 }
 
-Datum pg_kll_double_sketch_get_rank(PG_FUNCTION_ARGS) {
+Datum pg_kll_double_sketch_approx_agg(PG_FUNCTION_ARGS) {
+  struct quantiles_agg_state* stateptr;
+  double value;
+  int k;
+
+  MemoryContext oldcontext;
+  MemoryContext aggcontext;
+
+  if (PG_ARGISNULL(0) && PG_ARGISNULL(1)) {
+    PG_RETURN_NULL();
+  } else if (PG_ARGISNULL(1)) {
+    PG_RETURN_POINTER(PG_GETARG_POINTER(0)); // no update value. return unmodified state
+  }
+
+  if (!AggCheckCallContext(fcinfo, &aggcontext)) {
+    elog(ERROR, "kll_double_sketch_approx_agg called in non-aggregate context");
+  }
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "kll_double_sketch"));
+
+  if (PG_ARGISNULL(0)) {
+    k = PG_NARGS() > 3 ? PG_GETARG_INT32(3) : DEFAULT_K;
+    stateptr = quantiles_agg_state_new(k, false);
+    quantiles_agg_state_set_fractions(stateptr, fcinfo, 2);
+  } else {
+    stateptr = (struct quantiles_agg_state*) PG_GETARG_POINTER(0);
+  }
+
+  value = PG_GETARG_FLOAT8(1);
+  kll_double_agg_state_update(stateptr, value);
+
+  MemoryContextSwitchTo(oldcontext);
+
+  PG_RETURN_POINTER(stateptr);
+}
+
+Datum pg_kll_double_sketch_approx_serialize(PG_FUNCTION_ARGS) {
+  struct quantiles_agg_state* stateptr;
+  struct ptr_with_size bytes_out;
+  unsigned header_size;
+  MemoryContext aggcontext;
+
+  if (PG_ARGISNULL(0)) PG_RETURN_NULL();
+  if (!AggCheckCallContext(fcinfo, &aggcontext)) {
+    elog(ERROR, "kll_double_sketch_approx_serialize called in non-aggregate context");
+  }
+  stateptr = (struct quantiles_agg_state*) PG_GETARG_POINTER(0);
+  kll_double_agg_state_promote(stateptr);
+  header_size = quantiles_agg_state_header_size(stateptr);
+  bytes_out = kll_double_sketch_serialize(stateptr->ptr, VARHDRSZ + header_size);
+  quantiles_agg_state_write_header(stateptr, VARDATA(bytes_out.ptr));
+  kll_double_sketch_delete(stateptr->ptr);
+  quantiles_agg_state_delete(stateptr);
+  SET_VARSIZE(bytes_out.ptr, bytes_out.size);
+  PG_RETURN_BYTEA_P(bytes_out.ptr);
+}
+
+Datum pg_kll_double_sketch_approx_deserialize(PG_FUNCTION_ARGS) {
   const bytea* bytes_in;
+  struct quantiles_agg_state* stateptr;
+  unsigned header_size;
+
+  MemoryContext oldcontext;
+  MemoryContext aggcontext;
+
+  if (PG_ARGISNULL(0)) PG_RETURN_NULL();
+
+  if (!AggCheckCallContext(fcinfo, &aggcontext)) {
+    elog(ERROR, "kll_double_sketch_approx_deserialize called in non-aggregate context");
+  }
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "kll_double_sketch"));
+
+  bytes_in = PG_GETARG_BYTEA_P(0);
+  stateptr = quantiles_agg_state_new(0, false);
+  header_size = quantiles_agg_state_read_header(stateptr, VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ);
+  stateptr->ptr = kll_double_sketch_deserialize(VARDATA(bytes_in) + header_size, VARSIZE(bytes_in) - VARHDRSZ - header_size);
+
+  MemoryContextSwitchTo(oldcontext);
+
+  PG_RETURN_POINTER(stateptr);
+}
+
+Datum pg_kll_double_sketch_approx_combine(PG_FUNCTION_ARGS) {
+  struct quantiles_agg_state* stateptr1;
+  struct quantiles_agg_state* stateptr2;
+  struct quantiles_agg_state* stateptr;
+
+  MemoryContext oldcontext;
+  MemoryContext aggcontext;
+
+  if (PG_ARGISNULL(0) && PG_ARGISNULL(1)) PG_RETURN_NULL();
+
+  if (!AggCheckCallContext(fcinfo, &aggcontext)) {
+    elog(ERROR, "kll_double_sketch_approx_combine called in non-aggregate context");
+  }
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "kll_double_sketch"));
+
+  stateptr1 = (struct quantiles_agg_state*) PG_GETARG_POINTER(0);
+  stateptr2 = (struct quantiles_agg_state*) PG_GETARG_POINTER(1);
+
+  if (stateptr1) {
+    stateptr = stateptr1;
+    if (stateptr2) {
+      kll_double_agg_state_merge(stateptr, stateptr2);
+    }
+  } else {
+    stateptr = stateptr2;
+  }
+
+  MemoryContextSwitchTo(oldcontext);
+
+  PG_RETURN_POINTER(stateptr);
+}
+
+// the sketch is queried in place, there is no serialized sketch in between
+Datum pg_kll_double_sketch_approx_quantile(PG_FUNCTION_ARGS) {
+  struct quantiles_agg_state* stateptr;
+  double value;
+  MemoryContext oldcontext;
+  MemoryContext aggcontext;
+
+  if (PG_ARGISNULL(0)) PG_RETURN_NULL();
+  if (!AggCheckCallContext(fcinfo, &aggcontext)) {
+    elog(ERROR, "kll_double_sketch_approx_quantile called in non-aggregate context");
+  }
+  stateptr = (struct quantiles_agg_state*) PG_GETARG_POINTER(0);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "kll_double_sketch"));
+  kll_double_agg_state_promote(stateptr);
+  MemoryContextSwitchTo(oldcontext);
+  value = kll_double_sketch_get_quantile(stateptr->ptr, stateptr->fractions[0]);
+  PG_RETURN_FLOAT8(value);
+}
+
+Datum pg_kll_double_sketch_approx_quantiles(PG_FUNCTION_ARGS) {
+  struct quantiles_agg_state* stateptr;
+  MemoryContext oldcontext;
+  MemoryContext aggcontext;
+
+  // output array of quantiles
+  Datum* quantiles;
+  ArrayType* arr_out;
+  int16 elmlen_out;
+  bool elmbyval_out;
+  char elmalign_out;
+
+  if (PG_ARGISNULL(0)) PG_RETURN_NULL();
+  if (!AggCheckCallContext(fcinfo, &aggcontext)) {
+    elog(ERROR, "kll_double_sketch_approx_quantiles called in non-aggregate context");
+  }
+  stateptr = (struct quantiles_agg_state*) PG_GETARG_POINTER(0);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "kll_double_sketch"));
+  kll_double_agg_state_promote(stateptr);
+  MemoryContextSwitchTo(oldcontext);
+  quantiles = (Datum*) kll_double_sketch_get_quantiles(stateptr->ptr, stateptr->fractions, stateptr->num_fractions);
+
+  // construct output array of quantiles
+  get_typlenbyvalalign(FLOAT8OID, &elmlen_out, &elmbyval_out, &elmalign_out);
+  arr_out = construct_array(quantiles, stateptr->num_fractions, FLOAT8OID, elmlen_out, elmbyval_out, elmalign_out);
+
+  PG_RETURN_ARRAYTYPE_P(arr_out);
+}
+
+Datum pg_kll_double_sketch_get_rank(PG_FUNCTION_ARGS) {
   void* sketchptr;
   double value;
   double rank;
-  bytes_in = PG_GETARG_BYTEA_P(0);
-  sketchptr = kll_double_sketch_deserialize(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ);
+  sketchptr = fn_cache_get_sketch(fcinfo, 0, kll_double_sketch_deserialize, kll_double_sketch_setup_sorted_view);
   value = PG_GETARG_FLOAT8(1);
   rank = kll_double_sketch_get_rank(sketchptr, value);
-  kll_double_sketch_delete(sketchptr);
   PG_RETURN_FLOAT8(rank);
 }
 
 Datum pg_kll_double_sketch_get_quantile(PG_FUNCTION_ARGS) {
-  const bytea* bytes_in;
   void* sketchptr;
   double value;
   double rank;
-  bytes_in = PG_GETARG_BYTEA_P(0);
-  sketchptr = kll_double_sketch_deserialize(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ);
+  sketchptr = fn_cache_get_sketch(fcinfo, 0, kll_double_sketch_deserialize, kll_double_sketch_setup_sorted_view);
   rank = PG_GETARG_FLOAT8(1);
   value = kll_double_sketch_get_quantile(sketchptr, rank);
-  kll_double_sketch_delete(sketchptr);
   PG_RETURN_FLOAT8(value);
 }
 
 Datum pg_kll_double_sketch_get_n(PG_FUNCTION_ARGS) {
   const bytea* bytes_in;
   void* sketchptr;
-  uint64 n;
-  bytes_in = PG_GETARG_BYTEA_P(0);
-  sketchptr = kll_double_sketch_deserialize(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ);
-  n = kll_double_sketch_get_n(sketchptr);
-  kll_double_sketch_delete(sketchptr);
+  unsigned long long n;
+  // n is in the preamble, try to read just that
+  bytes_in = PG_GETARG_BYTEA_P_SLICE(0, 0, KLL_DOUBLE_SKETCH_N_SLICE_SIZE);
+  if (!kll_double_sketch_peek_n(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ, &n)) {
+    bytes_in = PG_GETARG_BYTEA_P(0);
+    sketchptr = kll_double_sketch_deserialize(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ);
+    n = kll_double_sketch_get_n(sketchptr);
+    kll_double_sketch_delete(sketchptr);
+  }
   PG_RETURN_INT64(n);
 }
 
@@ -245,10 +477,14 @@ Datum pg_kll_double_sketch_get_max_item(PG_FUNCTION_ARGS) {
     const bytea* bytes_in;
     void* sketchptr;
     double value;
-    bytes_in = PG_GETARG_BYTEA_P(0);
-    sketchptr = kll_double_sketch_deserialize(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ);
-    value = kll_double_sketch_get_max_item(sketchptr);
-    kll_double_sketch_delete(sketchptr);
+    // max item follows the preamble and levels, try to read just that
+    bytes_in = PG_GETARG_BYTEA_P_SLICE(0, 0, KLL_DOUBLE_SKETCH_MIN_MAX_SLICE_SIZE);
+    if (!kll_double_sketch_peek_max_item(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ, &value)) {
+        bytes_in = PG_GETARG_BYTEA_P(0);
+        sketchptr = kll_double_sketch_deserialize(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ);
+        value = kll_double_sketch_get_max_item(sketchptr);
+        kll_double_sketch_delete(sketchptr);
+    }
     PG_RETURN_FLOAT8(value);
 }
 
@@ -256,10 +492,14 @@ Datum pg_kll_double_sketch_get_min_item(PG_FUNCTION_ARGS) {
     const bytea* bytes_in;
     void* sketchptr;
     double value;
-    bytes_in = PG_GETARG_BYTEA_P(0);
-    sketchptr = kll_double_sketch_deserialize(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ);
-    value = kll_double_sketch_get_min_item(sketchptr);
-    kll_double_sketch_delete(sketchptr);
+    // min item follows the preamble and levels, try to read just that
+    bytes_in = PG_GETARG_BYTEA_P_SLICE(0, 0, KLL_DOUBLE_SKETCH_MIN_MAX_SLICE_SIZE);
+    if (!kll_double_sketch_peek_min_item(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ, &value)) {
+        bytes_in = PG_GETARG_BYTEA_P(0);
+        sketchptr = kll_double_sketch_deserialize(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ);
+        value = kll_double_sketch_get_min_item(sketchptr);
+        kll_double_sketch_delete(sketchptr);
+    }
     PG_RETURN_FLOAT8(value);
 }
 
@@ -275,19 +515,11 @@ Datum pg_kll_double_sketch_to_string(PG_FUNCTION_ARGS) {
 }
 
 Datum pg_kll_double_sketch_get_pmf(PG_FUNCTION_ARGS) {
-  const bytea* bytes_in;
   void* sketchptr;
 
   // input array of split points
-  ArrayType* arr_in;
-  Oid elmtype_in;
-  int16 elmlen_in;
-  bool elmbyval_in;
-  char elmalign_in;
-  Datum* data_in;
-  bool* nulls_in;
   int arr_len_in;
-  double* split_points;
+  const double* split_points;
 
   // output array of fractions
   Datum* result;
@@ -297,47 +529,25 @@ Datum pg_kll_double_sketch_get_pmf(PG_FUNCTION_ARGS) {
   char elmalign_out;
   int arr_len_out;
 
-  int i;
-
-  bytes_in = PG_GETARG_BYTEA_P(0);
-  sketchptr = kll_double_sketch_deserialize(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ);
-
-  arr_in = PG_GETARG_ARRAYTYPE_P(1);
-  elmtype_in = ARR_ELEMTYPE(arr_in);
-  get_typlenbyvalalign(elmtype_in, &elmlen_in, &elmbyval_in, &elmalign_in);
-  deconstruct_array(arr_in, elmtype_in, elmlen_in, elmbyval_in, elmalign_in, &data_in, &nulls_in, &arr_len_in);
+  sketchptr = fn_cache_get_sketch(fcinfo, 0, kll_double_sketch_deserialize, kll_double_sketch_setup_sorted_view);
 
-  split_points = palloc(sizeof(double) * arr_len_in);
-  for (i = 0; i < arr_len_in; i++) {
-    split_points[i] = DatumGetFloat8(data_in[i]);
-  }
+  split_points = fn_cache_get_double_array(fcinfo, 1, &arr_len_in);
   result = (Datum*) kll_double_sketch_get_pmf_or_cdf(sketchptr, split_points, arr_len_in, false, false);
-  pfree(split_points);
 
   // construct output array of fractions
   arr_len_out = arr_len_in + 1; // N split points divide the number line into N+1 intervals
   get_typlenbyvalalign(FLOAT8OID, &elmlen_out, &elmbyval_out, &elmalign_out);
   arr_out = construct_array(result, arr_len_out, FLOAT8OID, elmlen_out, elmbyval_out, elmalign_out);
 
-  kll_double_sketch_delete(sketchptr);
-
   PG_RETURN_ARRAYTYPE_P(arr_out);
 }
 
 Datum pg_kll_double_sketch_get_cdf(PG_FUNCTION_ARGS) {
-  const bytea* bytes_in;
   void* sketchptr;
 
   // input array of split points
-  ArrayType* arr_in;
-  Oid elmtype_in;
-  int16 elmlen_in;
-  bool elmbyval_in;
-  char elmalign_in;
-  Datum* data_in;
-  bool* nulls_in;
   int arr_len_in;
-  double* split_points;
+  const double* split_points;
 
   // output array of fractions
   Datum* result;
@@ -347,47 +557,25 @@ Datum pg_kll_double_sketch_get_cdf(PG_FUNCTION_ARGS) {
   char elmalign_out;
   int arr_len_out;
 
-  int i;
-
-  bytes_in = PG_GETARG_BYTEA_P(0);
-  sketchptr = kll_double_sketch_deserialize(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ);
-
-  arr_in = PG_GETARG_ARRAYTYPE_P(1);
-  elmtype_in = ARR_ELEMTYPE(arr_in);
-  get_typlenbyvalalign(elmtype_in, &elmlen_in, &elmbyval_in, &elmalign_in);
-  deconstruct_array(arr_in, elmtype_in, elmlen_in, elmbyval_in, elmalign_in, &data_in, &nulls_in, &arr_len_in);
+  sketchptr = fn_cache_get_sketch(fcinfo, 0, kll_double_sketch_deserialize, kll_double_sketch_setup_sorted_view);
 
-  split_points = palloc(sizeof(double) * arr_len_in);
-  for (i = 0; i < arr_len_in; i++) {
-    split_points[i] = DatumGetFloat8(data_in[i]);
-  }
+  split_points = fn_cache_get_double_array(fcinfo, 1, &arr_len_in);
   result = (Datum*) kll_double_sketch_get_pmf_or_cdf(sketchptr, split_points, arr_len_in, true, false);
-  pfree(split_points);
 
   // construct output array of fractions
   arr_len_out = arr_len_in + 1; // N split points divide the number line into N+1 intervals
   get_typlenbyvalalign(FLOAT8OID, &elmlen_out, &elmbyval_out, &elmalign_out);
   arr_out = construct_array(result, arr_len_out, FLOAT8OID, elmlen_out, elmbyval_out, elmalign_out);
 
-  kll_double_sketch_delete(sketchptr);
-
   PG_RETURN_ARRAYTYPE_P(arr_out);
 }
 
 Datum pg_kll_double_sketch_get_quantiles(PG_FUNCTION_ARGS) {
-  const bytea* bytes_in;
   void* sketchptr;
 
   // input array of fractions
-  ArrayType* arr_in;
-  Oid elmtype_in;
-  int16 elmlen_in;
-  bool elmbyval_in;
-  char elmalign_in;
-  Datum* data_in;
-  bool* nulls_in;
   int arr_len;
-  double* fractions;
+  const double* fractions;
 
   // output array of quantiles
   Datum* quantiles;
@@ -396,34 +584,19 @@ Datum pg_kll_double_sketch_get_quantiles(PG_FUNCTION_ARGS) {
   bool elmbyval_out;
   char elmalign_out;
 
-  int i;
+  sketchptr = fn_cache_get_sketch(fcinfo, 0, kll_double_sketch_deserialize, kll_double_sketch_setup_sorted_view);
 
-  bytes_in = PG_GETARG_BYTEA_P(0);
-  sketchptr = kll_double_sketch_deserialize(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ);
-
-  arr_in = PG_GETARG_ARRAYTYPE_P(1);
-  elmtype_in = ARR_ELEMTYPE(arr_in);
-  get_typlenbyvalalign(elmtype_in, &elmlen_in, &elmbyval_in, &elmalign_in);
-  deconstruct_array(arr_in, elmtype_in, elmlen_in, elmbyval_in, elmalign_in, &data_in, &nulls_in, &arr_len);
-
-  fractions = palloc(sizeof(double) * arr_len);
-  for (i = 0; i < arr_len; i++) {
-    fractions[i] = DatumGetFloat8(data_in[i]);
-  }
+  fractions = fn_cache_get_double_array(fcinfo, 1, &arr_len);
   quantiles = (Datum*) kll_double_sketch_get_quantiles(sketchptr, fractions, arr_len);
-  pfree(fractions);
 
   // construct output array of quantiles
   get_typlenbyvalalign(FLOAT8OID, &elmlen_out, &elmbyval_out, &elmalign_out);
   arr_out = construct_array(quantiles, arr_len, FLOAT8OID, elmlen_out, elmbyval_out, elmalign_out);
 
-  kll_double_sketch_delete(sketchptr);
-
   PG_RETURN_ARRAYTYPE_P(arr_out);
 }
 
 Datum pg_kll_double_sketch_get_histogram(PG_FUNCTION_ARGS) {
-  const bytea* bytes_in;
   void* sketchptr;
   int num_bins;
 
@@ -441,8 +614,7 @@ Datum pg_kll_double_sketch_get_histogram(PG_FUNCTION_ARGS) {
   double delta;
   int i;
 
-  bytes_in = PG_GETARG_BYTEA_P(0);
-  sketchptr = kll_double_sketch_deserialize(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ);
+  sketchptr = fn_cache_get_sketch(fcinfo, 0, kll_double_sketch_deserialize, kll_double_sketch_setup_sorted_view);
 
   num_bins = PG_NARGS() > 1 ? PG_GETARG_INT32(1) : DEFAULT_NUM_BINS;
   if (num_bins < 2) {
@@ -464,7 +636,5 @@ Datum pg_kll_double_sketch_get_histogram(PG_FUNCTION_ARGS) {
   get_typlenbyvalalign(FLOAT8OID, &elmlen_out, &elmbyval_out, &elmalign_out);
   arr_out = construct_array(result, arr_len_out, FLOAT8OID, elmlen_out, elmbyval_out, elmalign_out);
 
-  kll_double_sketch_delete(sketchptr);
-
   PG_RETURN_ARRAYTYPE_P(arr_out);
 }
@@ -32,6 +32,8 @@ void* kll_float_sketch_new(unsigned k);
 void kll_float_sketch_delete(void* sketchptr);
 
 void kll_float_sketch_update(void* sketchptr, float value);
+// little-endian 32-bit floats
+void kll_float_sketch_update_packed(void* sketchptr, const char* data, unsigned num_items);
 void kll_float_sketch_merge(void* sketchptr1, const void* sketchptr2);
 double kll_float_sketch_get_rank(const void* sketchptr, float value);
 float kll_float_sketch_get_quantile(const void* sketchptr, double rank);
@@ -39,11 +41,21 @@ unsigned long long kll_float_sketch_get_n(const void* sketchptr);
 float kll_float_sketch_get_max_item(const void* sketchptr);
 float kll_float_sketch_get_min_item(const void* sketchptr);
 char* kll_float_sketch_to_string(const void* sketchptr);
+// for sketches that outlive the current memory context and are queried repeatedly
+void kll_float_sketch_setup_sorted_view(const void* sketchptr);
 
 struct ptr_with_size kll_float_sketch_serialize(const void* sketchptr, unsigned header_size);
 void* kll_float_sketch_deserialize(const char* buffer, unsigned length);
 unsigned kll_float_sketch_get_serialized_size_bytes(const void* sketchptr);
 
+// enough for n
+static const unsigned KLL_FLOAT_SKETCH_N_SLICE_SIZE = 16;
+// enough for min and max items unless the sketch has unusually many levels
+static const unsigned KLL_FLOAT_SKETCH_MIN_MAX_SLICE_SIZE = 512;
+bool kll_float_sketch_peek_n(const char* buffer, unsigned length, unsigned long long* n);
+bool kll_float_sketch_peek_min_item(const char* buffer, unsigned length, float* item);
+bool kll_float_sketch_peek_max_item(const char* buffer, unsigned length, float* item);
+
 void** kll_float_sketch_get_pmf_or_cdf(const void* sketchptr, const float* split_points, unsigned num_split_points, bool is_cdf, bool scale);
 void** kll_float_sketch_get_quantiles(const void* sketchptr, const double* fractions, unsigned num_fractions);
 
@@ -0,0 +1,125 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <postgres.h>
+#include <fmgr.h>
+#include <utils/lsyscache.h>
+#include <utils/array.h>
+#include <catalog/pg_type.h>
+
+#include "quantiles_agg_state.h"
+
+struct quantiles_agg_state* quantiles_agg_state_new(unsigned k, bool hra) {
+  struct quantiles_agg_state* stateptr = palloc(sizeof(struct quantiles_agg_state));
+  stateptr->ptr = NULL;
+  stateptr->k = k;
+  stateptr->hra = hra;
+  stateptr->num_values = 0;
+  stateptr->capacity = 0;
+  stateptr->values = NULL;
+  stateptr->num_fractions = 0;
+  stateptr->fractions = NULL;
+  return stateptr;
+}
+
+void quantiles_agg_state_delete(struct quantiles_agg_state* stateptr) {
+  quantiles_agg_state_free_values(stateptr);
+  if (stateptr->fractions) pfree(stateptr->fractions);
+  pfree(stateptr);
+}
+
+bool quantiles_agg_state_add_value(struct quantiles_agg_state* stateptr, double value) {
+  if (stateptr->num_values == QUANTILES_AGG_STATE_MAX_VALUES) return false;
+  if (stateptr->num_values == stateptr->capacity) {
+    // start small, most groups in a hash aggregate have only a few rows
+    if (stateptr->capacity == 0) {
+      stateptr->capacity = 4;
+      stateptr->values = palloc(sizeof(double) * stateptr->capacity);
+    } else {
+      stateptr->capacity *= 2;
+      stateptr->values = repalloc(stateptr->values, sizeof(double) * stateptr->capacity);
+    }
+  }
+  stateptr->values[stateptr->num_values++] = value;
+  return true;
+}
+
+void quantiles_agg_state_free_values(struct quantiles_agg_state* stateptr) {
+  if (stateptr->values) pfree(stateptr->values);
+  stateptr->values = NULL;
+  stateptr->num_values = 0;
+  stateptr->capacity = 0;
+}
+
+void quantiles_agg_state_set_fractions(struct quantiles_agg_state* stateptr, FunctionCallInfo fcinfo, int argno) {
+  ArrayType* arr_in;
+  Oid elmtype_in;
+  int16 elmlen_in;
+  bool elmbyval_in;
+  char elmalign_in;
+  Datum* data_in;
+  bool* nulls_in;
+  int arr_len_in;
+  int i;
+
+  if (PG_ARGISNULL(argno)) {
+    elog(ERROR, "rank or ranks expected");
+  }
+  if (get_fn_expr_argtype(fcinfo->flinfo, argno) == FLOAT8OID) {
+    stateptr->num_fractions = 1;
+    stateptr->fractions = palloc(sizeof(double));
+    stateptr->fractions[0] = PG_GETARG_FLOAT8(argno);
+    return;
+  }
+
+  arr_in = PG_GETARG_ARRAYTYPE_P(argno);
+  elmtype_in = ARR_ELEMTYPE(arr_in);
+  get_typlenbyvalalign(elmtype_in, &elmlen_in, &elmbyval_in, &elmalign_in);
+  deconstruct_array(arr_in, elmtype_in, elmlen_in, elmbyval_in, elmalign_in, &data_in, &nulls_in, &arr_len_in);
+  stateptr->num_fractions = arr_len_in;
+  stateptr->fractions = palloc(sizeof(double) * arr_len_in);
+  for (i = 0; i < arr_len_in; i++) stateptr->fractions[i] = nulls_in[i] ? 0 : DatumGetFloat8(data_in[i]);
+  pfree(data_in);
+  pfree(nulls_in);
+}
+
+unsigned quantiles_agg_state_header_size(const struct quantiles_agg_state* stateptr) {
+  return sizeof(uint32) + sizeof(double) * stateptr->num_fractions;
+}
+
+void quantiles_agg_state_write_header(const struct quantiles_agg_state* stateptr, char* buffer) {
+  const uint32 num_fractions = stateptr->num_fractions;
+  memcpy(buffer, &num_fractions, sizeof(num_fractions));
+  memcpy(buffer + sizeof(num_fractions), stateptr->fractions, sizeof(double) * num_fractions);
+}
+
+unsigned quantiles_agg_state_read_header(struct quantiles_agg_state* stateptr, const char* buffer, unsigned length) {
+  uint32 num_fractions;
+  if (length < sizeof(num_fractions)) {
+    elog(ERROR, "quantiles aggregate state is too short");
+  }
+  memcpy(&num_fractions, buffer, sizeof(num_fractions));
+  if (length < sizeof(num_fractions) + sizeof(double) * (uint64) num_fractions) {
+    elog(ERROR, "quantiles aggregate state is too short");
+  }
+  stateptr->num_fractions = num_fractions;
+  stateptr->fractions = palloc(sizeof(double) * num_fractions);
+  memcpy(stateptr->fractions, buffer + sizeof(num_fractions), sizeof(double) * num_fractions);
+  return sizeof(num_fractions) + sizeof(double) * num_fractions;
+}
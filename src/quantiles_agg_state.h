@@ -0,0 +1,60 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef QUANTILES_AGG_STATE_H
+#define QUANTILES_AGG_STATE_H
+
+// state of the quantiles sketch aggregates (kll, req and classic quantiles)
+// the aggregates that return quantiles directly instead of a sketch (such as kll_float_approx_quantiles)
+// also keep the normalized ranks to query, taken from the first row
+
+// small groups are kept exactly: the values go into a small growable array,
+// which is promoted to a real sketch once it holds QUANTILES_AGG_STATE_MAX_VALUES values
+#define QUANTILES_AGG_STATE_MAX_VALUES 32
+
+struct quantiles_agg_state {
+  void* ptr; // sketch, null while the values are kept exactly
+  unsigned k; // sketch parameters used for promotion
+  bool hra; // req only
+  unsigned num_values;
+  unsigned capacity;
+  double* values;
+  unsigned num_fractions;
+  double* fractions;
+};
+
+struct quantiles_agg_state* quantiles_agg_state_new(unsigned k, bool hra);
+// frees the state together with the values and fractions, but not the sketch
+void quantiles_agg_state_delete(struct quantiles_agg_state* stateptr);
+
+// returns false if the array is full and the state must be promoted to a sketch first
+bool quantiles_agg_state_add_value(struct quantiles_agg_state* stateptr, double value);
+// called after the values were copied into a new sketch
+void quantiles_agg_state_free_values(struct quantiles_agg_state* stateptr);
+
+// copies a double precision or double precision[] argument into the state, nulls as zeros
+void quantiles_agg_state_set_fractions(struct quantiles_agg_state* stateptr, FunctionCallInfo fcinfo, int argno);
+
+// serialized state: number of fractions (4 bytes), fractions, then the serialized sketch
+unsigned quantiles_agg_state_header_size(const struct quantiles_agg_state* stateptr);
+void quantiles_agg_state_write_header(const struct quantiles_agg_state* stateptr, char* buffer);
+// returns the size of the header, the serialized sketch follows
+unsigned quantiles_agg_state_read_header(struct quantiles_agg_state* stateptr, const char* buffer, unsigned length);
+
+#endif
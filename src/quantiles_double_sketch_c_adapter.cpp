@@ -21,6 +21,7 @@
 #include "allocator.h"
 #include "postgres_h_substitute.h"
 
+#include <cstring>
 #include <quantiles_sketch.hpp>
 
 using quantiles_double_sketch = datasketches::quantiles_sketch<double, std::less<double>, palloc_allocator<double>>;
@@ -86,6 +87,16 @@ unsigned long long quantiles_double_sketch_get_n(const void* sketchptr) {
   pg_unreachable();
 }
 
+void quantiles_double_sketch_setup_sorted_view(const void* sketchptr) {
+  try {
+    // quantile queries build the sorted view on first use and keep it in the sketch
+    auto sketch = static_cast<const quantiles_double_sketch*>(sketchptr);
+    if (!sketch->is_empty()) sketch->get_quantile(0);
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+}
+
 char* quantiles_double_sketch_to_string(const void* sketchptr) {
   try {
     auto str = static_cast<const quantiles_double_sketch*>(sketchptr)->to_string();
@@ -165,3 +176,25 @@ Datum* quantiles_double_sketch_get_quantiles(const void* sketchptr, const double
   }
   pg_unreachable();
 }
+
+// accessor that reads only the serialized preamble
+// returns false if the bytes must be fully deserialized instead
+// layout: preamble longs, serial version, family, flags, k (2 bytes), unused (2 bytes),
+// then if not empty: n (8 bytes), min item, max item, ...
+
+static const uint8_t QUANTILES_FAMILY = 8;
+static const uint8_t QUANTILES_SERIAL_VERSION = 3;
+static const uint8_t QUANTILES_FLAG_EMPTY = 4;
+
+bool quantiles_double_sketch_peek_n(const char* buffer, unsigned length, unsigned long long* n) {
+  if (length < 8 || buffer[1] != QUANTILES_SERIAL_VERSION || buffer[2] != QUANTILES_FAMILY) return false;
+  if (buffer[3] & QUANTILES_FLAG_EMPTY) {
+    *n = 0;
+  } else {
+    uint64_t value;
+    if (length < 16) return false;
+    std::memcpy(&value, buffer + 8, sizeof(value));
+    *n = value;
+  }
+  return true;
+}
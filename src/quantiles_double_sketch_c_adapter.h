@@ -37,11 +37,17 @@ double quantiles_double_sketch_get_rank(const void* sketchptr, double value);
 double quantiles_double_sketch_get_quantile(const void* sketchptr, double rank);
 unsigned long long quantiles_double_sketch_get_n(const void* sketchptr);
 char* quantiles_double_sketch_to_string(const void* sketchptr);
+// for sketches that outlive the current memory context and are queried repeatedly
+void quantiles_double_sketch_setup_sorted_view(const void* sketchptr);
 
 struct ptr_with_size quantiles_double_sketch_serialize(const void* sketchptr, unsigned header_size);
 void* quantiles_double_sketch_deserialize(const char* buffer, unsigned length);
 unsigned quantiles_double_sketch_get_serialized_size_bytes(const void* sketchptr);
 
+// enough for n
+static const unsigned QUANTILES_DOUBLE_SKETCH_N_SLICE_SIZE = 16;
+bool quantiles_double_sketch_peek_n(const char* buffer, unsigned length, unsigned long long* n);
+
 void** quantiles_double_sketch_get_pmf_or_cdf(const void* sketchptr, const double* split_points, unsigned num_split_points, bool is_cdf, bool scale);
 void** quantiles_double_sketch_get_quantiles(const void* sketchptr, const double* fractions, unsigned num_fractions);
 
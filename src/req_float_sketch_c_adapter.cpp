@@ -21,6 +21,7 @@
 #include "allocator.h"
 #include "postgres_h_substitute.h"
 
+#include <cstring>
 #include <req_sketch.hpp>
 
 using req_float_sketch = datasketches::req_sketch<float, std::less<float>, palloc_allocator<float>>;
@@ -86,6 +87,16 @@ unsigned long long req_float_sketch_get_n(const void* sketchptr) {
   pg_unreachable();
 }
 
+void req_float_sketch_setup_sorted_view(const void* sketchptr) {
+  try {
+    // quantile queries build the sorted view on first use and keep it in the sketch
+    auto sketch = static_cast<const req_float_sketch*>(sketchptr);
+    if (!sketch->is_empty()) sketch->get_quantile(0);
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+}
+
 char* req_float_sketch_to_string(const void* sketchptr) {
   try {
     auto str = static_cast<const req_float_sketch*>(sketchptr)->to_string();
@@ -165,3 +176,32 @@ Datum* req_float_sketch_get_quantiles(const void* sketchptr, const double* fract
   }
   pg_unreachable();
 }
+
+// accessor that reads only the serialized preamble
+// returns false if the bytes must be fully deserialized instead
+// layout: preamble ints, serial version, family, flags, k (2 bytes), num levels, num raw items,
+// then in estimation mode (4 preamble ints): n (8 bytes), min item, max item, ...
+// otherwise n is stored explicitly only for raw items
+
+static const uint8_t REQ_FAMILY = 17;
+static const uint8_t REQ_PREAMBLE_INTS_ESTIMATION = 4;
+static const uint8_t REQ_FLAG_EMPTY = 4;
+static const uint8_t REQ_FLAG_RAW_ITEMS = 16;
+
+bool req_float_sketch_peek_n(const char* buffer, unsigned length, unsigned long long* n) {
+  if (length < 8 || buffer[2] != REQ_FAMILY) return false;
+  if (buffer[3] & REQ_FLAG_EMPTY) {
+    *n = 0;
+  } else if (buffer[3] & REQ_FLAG_RAW_ITEMS) {
+    *n = static_cast<uint8_t>(buffer[7]);
+  } else if (buffer[0] == REQ_PREAMBLE_INTS_ESTIMATION) {
+    uint64_t value;
+    if (length < 16) return false;
+    std::memcpy(&value, buffer + 8, sizeof(value));
+    *n = value;
+  } else {
+    // n is the sum of the level sizes
+    return false;
+  }
+  return true;
+}
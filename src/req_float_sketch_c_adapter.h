@@ -37,11 +37,17 @@ double req_float_sketch_get_rank(const void* sketchptr, float value, bool inclus
 float req_float_sketch_get_quantile(const void* sketchptr, double rank, bool inclusive);
 unsigned long long req_float_sketch_get_n(const void* sketchptr);
 char* req_float_sketch_to_string(const void* sketchptr);
+// for sketches that outlive the current memory context and are queried repeatedly
+void req_float_sketch_setup_sorted_view(const void* sketchptr);
 
 struct ptr_with_size req_float_sketch_serialize(const void* sketchptr, unsigned header_size);
 void* req_float_sketch_deserialize(const char* buffer, unsigned length);
 unsigned req_float_sketch_get_serialized_size_bytes(const void* sketchptr);
 
+// enough for n
+static const unsigned REQ_FLOAT_SKETCH_N_SLICE_SIZE = 16;
+bool req_float_sketch_peek_n(const char* buffer, unsigned length, unsigned long long* n);
+
 void** req_float_sketch_get_pmf_or_cdf(const void* sketchptr, const float* split_points, unsigned num_split_points, bool is_cdf, bool scale, bool inclusive);
 void** req_float_sketch_get_quantiles(const void* sketchptr, const double* fractions, unsigned num_fractions, bool inclusive);
 
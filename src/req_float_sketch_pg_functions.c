@@ -25,13 +25,23 @@
 #include <catalog/pg_type.h>
 
 #include "req_float_sketch_c_adapter.h"
+#include "fn_cache.h"
+#include "quantiles_agg_state.h"
+#include "agg_context.h"
 
 /* PG_FUNCTION_INFO_V1 macro to pass functions to postgres */
 PG_FUNCTION_INFO_V1(pg_req_float_sketch_build_agg);
 PG_FUNCTION_INFO_V1(pg_req_float_sketch_merge_agg);
 PG_FUNCTION_INFO_V1(pg_req_float_sketch_serialize);
+PG_FUNCTION_INFO_V1(pg_req_float_sketch_finalize);
 PG_FUNCTION_INFO_V1(pg_req_float_sketch_deserialize);
 PG_FUNCTION_INFO_V1(pg_req_float_sketch_combine);
+PG_FUNCTION_INFO_V1(pg_req_float_sketch_approx_agg);
+PG_FUNCTION_INFO_V1(pg_req_float_sketch_approx_serialize);
+PG_FUNCTION_INFO_V1(pg_req_float_sketch_approx_deserialize);
+PG_FUNCTION_INFO_V1(pg_req_float_sketch_approx_combine);
+PG_FUNCTION_INFO_V1(pg_req_float_sketch_approx_quantile);
+PG_FUNCTION_INFO_V1(pg_req_float_sketch_approx_quantiles);
 PG_FUNCTION_INFO_V1(pg_req_float_sketch_get_rank);
 PG_FUNCTION_INFO_V1(pg_req_float_sketch_get_quantile);
 PG_FUNCTION_INFO_V1(pg_req_float_sketch_get_n);
@@ -45,8 +55,15 @@ PG_FUNCTION_INFO_V1(pg_req_float_sketch_get_histogram);
 Datum pg_req_float_sketch_build_agg(PG_FUNCTION_ARGS);
 Datum pg_req_float_sketch_merge_agg(PG_FUNCTION_ARGS);
 Datum pg_req_float_sketch_serialize(PG_FUNCTION_ARGS);
+Datum pg_req_float_sketch_finalize(PG_FUNCTION_ARGS);
 Datum pg_req_float_sketch_deserialize(PG_FUNCTION_ARGS);
 Datum pg_req_float_sketch_combine(PG_FUNCTION_ARGS);
+Datum pg_req_float_sketch_approx_agg(PG_FUNCTION_ARGS);
+Datum pg_req_float_sketch_approx_serialize(PG_FUNCTION_ARGS);
+Datum pg_req_float_sketch_approx_deserialize(PG_FUNCTION_ARGS);
+Datum pg_req_float_sketch_approx_combine(PG_FUNCTION_ARGS);
+Datum pg_req_float_sketch_approx_quantile(PG_FUNCTION_ARGS);
+Datum pg_req_float_sketch_approx_quantiles(PG_FUNCTION_ARGS);
 Datum pg_req_float_sketch_get_rank(PG_FUNCTION_ARGS);
 Datum pg_req_float_sketch_get_quantile(PG_FUNCTION_ARGS);
 Datum pg_req_float_sketch_get_n(PG_FUNCTION_ARGS);
@@ -58,8 +75,35 @@ Datum pg_req_float_sketch_get_histogram(PG_FUNCTION_ARGS);
 
 static const unsigned DEFAULT_NUM_BINS = 10;
 
+static void req_float_agg_state_promote(struct quantiles_agg_state* stateptr) {
+  unsigned i;
+  if (stateptr->ptr) return;
+  stateptr->ptr = req_float_sketch_new(stateptr->k, stateptr->hra);
+  for (i = 0; i < stateptr->num_values; i++) req_float_sketch_update(stateptr->ptr, stateptr->values[i]);
+  quantiles_agg_state_free_values(stateptr);
+}
+
+static void req_float_agg_state_update(struct quantiles_agg_state* stateptr, float value) {
+  if (!stateptr->ptr && quantiles_agg_state_add_value(stateptr, value)) return;
+  req_float_agg_state_promote(stateptr);
+  req_float_sketch_update(stateptr->ptr, value);
+}
+
+// merges state2 into state1 and frees state2
+static void req_float_agg_state_merge(struct quantiles_agg_state* stateptr1, struct quantiles_agg_state* stateptr2) {
+  unsigned i;
+  if (stateptr2->ptr) {
+    req_float_agg_state_promote(stateptr1);
+    req_float_sketch_merge(stateptr1->ptr, stateptr2->ptr);
+    req_float_sketch_delete(stateptr2->ptr);
+  } else {
+    for (i = 0; i < stateptr2->num_values; i++) req_float_agg_state_update(stateptr1, stateptr2->values[i]);
+  }
+  quantiles_agg_state_delete(stateptr2);
+}
+
 Datum pg_req_float_sketch_build_agg(PG_FUNCTION_ARGS) {
-  void* sketchptr;
+  struct quantiles_agg_state* stateptr;
   float value;
   int k;
   bool hra;
@@ -76,28 +120,28 @@ Datum pg_req_float_sketch_build_agg(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "req_float_sketch_build_agg called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "req_float_sketch"));
 
   if (PG_ARGISNULL(0)) {
     k = PG_NARGS() > 2 ? PG_GETARG_INT32(2) : DEFAULT_K;
     hra = PG_NARGS() > 3 ? PG_GETARG_BOOL(3) : true;
-    sketchptr = req_float_sketch_new(k, hra);
+    stateptr = quantiles_agg_state_new(k, hra);
   } else {
-    sketchptr = PG_GETARG_POINTER(0);
+    stateptr = (struct quantiles_agg_state*) PG_GETARG_POINTER(0);
   }
 
   value = PG_GETARG_FLOAT4(1);
-  req_float_sketch_update(sketchptr, value);
+  req_float_agg_state_update(stateptr, value);
 
   MemoryContextSwitchTo(oldcontext);
 
-  PG_RETURN_POINTER(sketchptr);
+  PG_RETURN_POINTER(stateptr);
 }
 
 Datum pg_req_float_sketch_merge_agg(PG_FUNCTION_ARGS) {
-  void* sketchptr;
+  struct quantiles_agg_state* stateptr;
   bytea* sketch_bytes;
-  void* in_sketchptr;
+  void* sketchptr;
   int k;
   bool hra;
 
@@ -113,28 +157,29 @@ Datum pg_req_float_sketch_merge_agg(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "req_float_sketch_merge_agg called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "req_float_sketch"));
 
   if (PG_ARGISNULL(0)) {
     k = PG_NARGS() > 2 ? PG_GETARG_INT32(2) : DEFAULT_K;
     hra = PG_NARGS() > 3 ? PG_GETARG_BOOL(3) : true;
-    sketchptr = req_float_sketch_new(k ? k : DEFAULT_K, hra);
+    stateptr = quantiles_agg_state_new(k ? k : DEFAULT_K, hra);
   } else {
-    sketchptr = PG_GETARG_POINTER(0);
+    stateptr = (struct quantiles_agg_state*) PG_GETARG_POINTER(0);
   }
 
   sketch_bytes = PG_GETARG_BYTEA_P(1);
-  in_sketchptr = req_float_sketch_deserialize(VARDATA(sketch_bytes), VARSIZE(sketch_bytes) - VARHDRSZ);
-  req_float_sketch_merge(sketchptr, in_sketchptr);
-  req_float_sketch_delete(in_sketchptr);
+  sketchptr = req_float_sketch_deserialize(VARDATA(sketch_bytes), VARSIZE(sketch_bytes) - VARHDRSZ);
+  req_float_agg_state_promote(stateptr);
+  req_float_sketch_merge(stateptr->ptr, sketchptr);
+  req_float_sketch_delete(sketchptr);
 
   MemoryContextSwitchTo(oldcontext);
 
-  PG_RETURN_POINTER(sketchptr);
+  PG_RETURN_POINTER(stateptr);
 }
 
 Datum pg_req_float_sketch_serialize(PG_FUNCTION_ARGS) {
-  void* sketchptr;
+  struct quantiles_agg_state* stateptr;
   struct ptr_with_size bytes_out;
   MemoryContext aggcontext;
 
@@ -142,16 +187,44 @@ Datum pg_req_float_sketch_serialize(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "req_float_sketch_serialize called in non-aggregate context");
   }
-  sketchptr = PG_GETARG_POINTER(0);
-  bytes_out = req_float_sketch_serialize(sketchptr, VARHDRSZ);
-  req_float_sketch_delete(sketchptr);
+  stateptr = (struct quantiles_agg_state*) PG_GETARG_POINTER(0);
+  // exact values become a sketch only here, so the output is always a regular serialized sketch
+  req_float_agg_state_promote(stateptr);
+  bytes_out = req_float_sketch_serialize(stateptr->ptr, VARHDRSZ);
+  req_float_sketch_delete(stateptr->ptr);
+  quantiles_agg_state_delete(stateptr);
+  SET_VARSIZE(bytes_out.ptr, bytes_out.size);
+  PG_RETURN_BYTEA_P(bytes_out.ptr);
+}
+
+// unlike serialize, does not destroy the state, so that window aggregates can call it after every row
+Datum pg_req_float_sketch_finalize(PG_FUNCTION_ARGS) {
+  struct quantiles_agg_state* stateptr;
+  struct ptr_with_size bytes_out;
+
+  MemoryContext oldcontext;
+  MemoryContext aggcontext;
+
+  if (PG_ARGISNULL(0)) PG_RETURN_NULL();
+
+  if (!AggCheckCallContext(fcinfo, &aggcontext)) {
+    elog(ERROR, "req_float_sketch_finalize called in non-aggregate context");
+  }
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "req_float_sketch"));
+
+  stateptr = (struct quantiles_agg_state*) PG_GETARG_POINTER(0);
+  req_float_agg_state_promote(stateptr);
+
+  MemoryContextSwitchTo(oldcontext);
+
+  bytes_out = req_float_sketch_serialize(stateptr->ptr, VARHDRSZ);
   SET_VARSIZE(bytes_out.ptr, bytes_out.size);
   PG_RETURN_BYTEA_P(bytes_out.ptr);
 }
 
 Datum pg_req_float_sketch_deserialize(PG_FUNCTION_ARGS) {
   const bytea* bytes_in;
-  void* sketchptr;
+  struct quantiles_agg_state* stateptr;
 
   MemoryContext oldcontext;
   MemoryContext aggcontext;
@@ -161,20 +234,21 @@ Datum pg_req_float_sketch_deserialize(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "req_float_sketch_deserialize called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "req_float_sketch"));
 
   bytes_in = PG_GETARG_BYTEA_P(0);
-  sketchptr = req_float_sketch_deserialize(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ);
+  stateptr = quantiles_agg_state_new(0, true);
+  stateptr->ptr = req_float_sketch_deserialize(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ);
 
   MemoryContextSwitchTo(oldcontext);
 
-  PG_RETURN_POINTER(sketchptr);
+  PG_RETURN_POINTER(stateptr);
 }
 
 Datum pg_req_float_sketch_combine(PG_FUNCTION_ARGS) {
-  void* sketchptr1;
-  void* sketchptr2;
-  void* sketchptr;
+  struct quantiles_agg_state* stateptr1;
+  struct quantiles_agg_state* stateptr2;
+  struct quantiles_agg_state* stateptr;
 
   MemoryContext oldcontext;
   MemoryContext aggcontext;
@@ -184,64 +258,222 @@ Datum pg_req_float_sketch_combine(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "req_float_sketch_combine called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "req_float_sketch"));
 
-  sketchptr1 = PG_GETARG_POINTER(0);
-  sketchptr2 = PG_GETARG_POINTER(1);
+  stateptr1 = (struct quantiles_agg_state*) PG_GETARG_POINTER(0);
+  stateptr2 = (struct quantiles_agg_state*) PG_GETARG_POINTER(1);
 
-  if (sketchptr1) {
-    sketchptr = sketchptr1;
-    if (sketchptr2) {
-      req_float_sketch_merge(sketchptr, sketchptr2);
+  if (stateptr1) {
+    stateptr = stateptr1;
+    if (stateptr2) {
+      req_float_agg_state_merge(stateptr, stateptr2);
     }
-    req_float_sketch_delete(sketchptr2);
   } else {
-    sketchptr = sketchptr2;
+    stateptr = stateptr2;
   }
 
   MemoryContextSwitchTo(oldcontext);
 
-  PG_RETURN_POINTER(sketchptr);
+  PG_RETURN_POINTER(stateptr);
 }
 
-Datum pg_req_float_sketch_get_rank(PG_FUNCTION_ARGS) {
+Datum pg_req_float_sketch_approx_agg(PG_FUNCTION_ARGS) {
+  struct quantiles_agg_state* stateptr;
+  float value;
+  int k;
+
+  MemoryContext oldcontext;
+  MemoryContext aggcontext;
+
+  if (PG_ARGISNULL(0) && PG_ARGISNULL(1)) {
+    PG_RETURN_NULL();
+  } else if (PG_ARGISNULL(1)) {
+    PG_RETURN_POINTER(PG_GETARG_POINTER(0)); // no update value. return unmodified state
+  }
+
+  if (!AggCheckCallContext(fcinfo, &aggcontext)) {
+    elog(ERROR, "req_float_sketch_approx_agg called in non-aggregate context");
+  }
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "req_float_sketch"));
+
+  if (PG_ARGISNULL(0)) {
+    k = PG_NARGS() > 3 ? PG_GETARG_INT32(3) : DEFAULT_K;
+    stateptr = quantiles_agg_state_new(k, true);
+    quantiles_agg_state_set_fractions(stateptr, fcinfo, 2);
+  } else {
+    stateptr = (struct quantiles_agg_state*) PG_GETARG_POINTER(0);
+  }
+
+  value = PG_GETARG_FLOAT4(1);
+  req_float_agg_state_update(stateptr, value);
+
+  MemoryContextSwitchTo(oldcontext);
+
+  PG_RETURN_POINTER(stateptr);
+}
+
+Datum pg_req_float_sketch_approx_serialize(PG_FUNCTION_ARGS) {
+  struct quantiles_agg_state* stateptr;
+  struct ptr_with_size bytes_out;
+  unsigned header_size;
+  MemoryContext aggcontext;
+
+  if (PG_ARGISNULL(0)) PG_RETURN_NULL();
+  if (!AggCheckCallContext(fcinfo, &aggcontext)) {
+    elog(ERROR, "req_float_sketch_approx_serialize called in non-aggregate context");
+  }
+  stateptr = (struct quantiles_agg_state*) PG_GETARG_POINTER(0);
+  req_float_agg_state_promote(stateptr);
+  header_size = quantiles_agg_state_header_size(stateptr);
+  bytes_out = req_float_sketch_serialize(stateptr->ptr, VARHDRSZ + header_size);
+  quantiles_agg_state_write_header(stateptr, VARDATA(bytes_out.ptr));
+  req_float_sketch_delete(stateptr->ptr);
+  quantiles_agg_state_delete(stateptr);
+  SET_VARSIZE(bytes_out.ptr, bytes_out.size);
+  PG_RETURN_BYTEA_P(bytes_out.ptr);
+}
+
+Datum pg_req_float_sketch_approx_deserialize(PG_FUNCTION_ARGS) {
   const bytea* bytes_in;
+  struct quantiles_agg_state* stateptr;
+  unsigned header_size;
+
+  MemoryContext oldcontext;
+  MemoryContext aggcontext;
+
+  if (PG_ARGISNULL(0)) PG_RETURN_NULL();
+
+  if (!AggCheckCallContext(fcinfo, &aggcontext)) {
+    elog(ERROR, "req_float_sketch_approx_deserialize called in non-aggregate context");
+  }
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "req_float_sketch"));
+
+  bytes_in = PG_GETARG_BYTEA_P(0);
+  stateptr = quantiles_agg_state_new(0, true);
+  header_size = quantiles_agg_state_read_header(stateptr, VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ);
+  stateptr->ptr = req_float_sketch_deserialize(VARDATA(bytes_in) + header_size, VARSIZE(bytes_in) - VARHDRSZ - header_size);
+
+  MemoryContextSwitchTo(oldcontext);
+
+  PG_RETURN_POINTER(stateptr);
+}
+
+Datum pg_req_float_sketch_approx_combine(PG_FUNCTION_ARGS) {
+  struct quantiles_agg_state* stateptr1;
+  struct quantiles_agg_state* stateptr2;
+  struct quantiles_agg_state* stateptr;
+
+  MemoryContext oldcontext;
+  MemoryContext aggcontext;
+
+  if (PG_ARGISNULL(0) && PG_ARGISNULL(1)) PG_RETURN_NULL();
+
+  if (!AggCheckCallContext(fcinfo, &aggcontext)) {
+    elog(ERROR, "req_float_sketch_approx_combine called in non-aggregate context");
+  }
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "req_float_sketch"));
+
+  stateptr1 = (struct quantiles_agg_state*) PG_GETARG_POINTER(0);
+  stateptr2 = (struct quantiles_agg_state*) PG_GETARG_POINTER(1);
+
+  if (stateptr1) {
+    stateptr = stateptr1;
+    if (stateptr2) {
+      req_float_agg_state_merge(stateptr, stateptr2);
+    }
+  } else {
+    stateptr = stateptr2;
+  }
+
+  MemoryContextSwitchTo(oldcontext);
+
+  PG_RETURN_POINTER(stateptr);
+}
+
+// the sketch is queried in place, there is no serialized sketch in between
+Datum pg_req_float_sketch_approx_quantile(PG_FUNCTION_ARGS) {
+  struct quantiles_agg_state* stateptr;
+  float value;
+  MemoryContext oldcontext;
+  MemoryContext aggcontext;
+
+  if (PG_ARGISNULL(0)) PG_RETURN_NULL();
+  if (!AggCheckCallContext(fcinfo, &aggcontext)) {
+    elog(ERROR, "req_float_sketch_approx_quantile called in non-aggregate context");
+  }
+  stateptr = (struct quantiles_agg_state*) PG_GETARG_POINTER(0);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "req_float_sketch"));
+  req_float_agg_state_promote(stateptr);
+  MemoryContextSwitchTo(oldcontext);
+  value = req_float_sketch_get_quantile(stateptr->ptr, stateptr->fractions[0], false);
+  PG_RETURN_FLOAT4(value);
+}
+
+Datum pg_req_float_sketch_approx_quantiles(PG_FUNCTION_ARGS) {
+  struct quantiles_agg_state* stateptr;
+  MemoryContext oldcontext;
+  MemoryContext aggcontext;
+
+  // output array of quantiles
+  Datum* quantiles;
+  ArrayType* arr_out;
+  int16 elmlen_out;
+  bool elmbyval_out;
+  char elmalign_out;
+
+  if (PG_ARGISNULL(0)) PG_RETURN_NULL();
+  if (!AggCheckCallContext(fcinfo, &aggcontext)) {
+    elog(ERROR, "req_float_sketch_approx_quantiles called in non-aggregate context");
+  }
+  stateptr = (struct quantiles_agg_state*) PG_GETARG_POINTER(0);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "req_float_sketch"));
+  req_float_agg_state_promote(stateptr);
+  MemoryContextSwitchTo(oldcontext);
+  quantiles = (Datum*) req_float_sketch_get_quantiles(stateptr->ptr, stateptr->fractions, stateptr->num_fractions, false);
+
+  // construct output array of quantiles
+  get_typlenbyvalalign(FLOAT4OID, &elmlen_out, &elmbyval_out, &elmalign_out);
+  arr_out = construct_array(quantiles, stateptr->num_fractions, FLOAT4OID, elmlen_out, elmbyval_out, elmalign_out);
+
+  PG_RETURN_ARRAYTYPE_P(arr_out);
+}
+
+Datum pg_req_float_sketch_get_rank(PG_FUNCTION_ARGS) {
   void* sketchptr;
   float value;
   double rank;
   bool inclusive;
-  bytes_in = PG_GETARG_BYTEA_P(0);
-  sketchptr = req_float_sketch_deserialize(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ);
+  sketchptr = fn_cache_get_sketch(fcinfo, 0, req_float_sketch_deserialize, req_float_sketch_setup_sorted_view);
   value = PG_GETARG_FLOAT4(1);
   inclusive = PG_NARGS() > 2 ? PG_GETARG_BOOL(2) : false;
   rank = req_float_sketch_get_rank(sketchptr, value, inclusive);
-  req_float_sketch_delete(sketchptr);
   PG_RETURN_FLOAT8(rank);
 }
 
 Datum pg_req_float_sketch_get_quantile(PG_FUNCTION_ARGS) {
-  const bytea* bytes_in;
   void* sketchptr;
   float value;
   double rank;
   bool inclusive;
-  bytes_in = PG_GETARG_BYTEA_P(0);
-  sketchptr = req_float_sketch_deserialize(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ);
+  sketchptr = fn_cache_get_sketch(fcinfo, 0, req_float_sketch_deserialize, req_float_sketch_setup_sorted_view);
   rank = PG_GETARG_FLOAT8(1);
   inclusive = PG_NARGS() > 2 ? PG_GETARG_BOOL(2) : false;
   value = req_float_sketch_get_quantile(sketchptr, rank, inclusive);
-  req_float_sketch_delete(sketchptr);
   PG_RETURN_FLOAT4(value);
 }
 
 Datum pg_req_float_sketch_get_n(PG_FUNCTION_ARGS) {
   const bytea* bytes_in;
   void* sketchptr;
-  uint64 n;
-  bytes_in = PG_GETARG_BYTEA_P(0);
-  sketchptr = req_float_sketch_deserialize(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ);
-  n = req_float_sketch_get_n(sketchptr);
-  req_float_sketch_delete(sketchptr);
+  unsigned long long n;
+  // n is in the preamble, try to read just that
+  bytes_in = PG_GETARG_BYTEA_P_SLICE(0, 0, REQ_FLOAT_SKETCH_N_SLICE_SIZE);
+  if (!req_float_sketch_peek_n(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ, &n)) {
+    bytes_in = PG_GETARG_BYTEA_P(0);
+    sketchptr = req_float_sketch_deserialize(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ);
+    n = req_float_sketch_get_n(sketchptr);
+    req_float_sketch_delete(sketchptr);
+  }
   PG_RETURN_INT64(n);
 }
 
@@ -257,19 +489,11 @@ Datum pg_req_float_sketch_to_string(PG_FUNCTION_ARGS) {
 }
 
 Datum pg_req_float_sketch_get_pmf(PG_FUNCTION_ARGS) {
-  const bytea* bytes_in;
   void* sketchptr;
 
   // input array of split points
-  ArrayType* arr_in;
-  Oid elmtype_in;
-  int16 elmlen_in;
-  bool elmbyval_in;
-  char elmalign_in;
-  Datum* data_in;
-  bool* nulls_in;
   int arr_len_in;
-  float* split_points;
+  const float* split_points;
   bool inclusive;
 
   // output array of fractions
@@ -280,50 +504,28 @@ Datum pg_req_float_sketch_get_pmf(PG_FUNCTION_ARGS) {
   char elmalign_out;
   int arr_len_out;
 
-  int i;
+  sketchptr = fn_cache_get_sketch(fcinfo, 0, req_float_sketch_deserialize, req_float_sketch_setup_sorted_view);
 
-  bytes_in = PG_GETARG_BYTEA_P(0);
-  sketchptr = req_float_sketch_deserialize(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ);
-
-  arr_in = PG_GETARG_ARRAYTYPE_P(1);
-  elmtype_in = ARR_ELEMTYPE(arr_in);
-  get_typlenbyvalalign(elmtype_in, &elmlen_in, &elmbyval_in, &elmalign_in);
-  deconstruct_array(arr_in, elmtype_in, elmlen_in, elmbyval_in, elmalign_in, &data_in, &nulls_in, &arr_len_in);
-
-  split_points = palloc(sizeof(float) * arr_len_in);
-  for (i = 0; i < arr_len_in; i++) {
-    split_points[i] = DatumGetFloat4(data_in[i]);
-  }
+  split_points = fn_cache_get_float_array(fcinfo, 1, &arr_len_in);
 
   inclusive = PG_NARGS() > 2 ? PG_GETARG_BOOL(2) : false;
 
   result = (Datum*) req_float_sketch_get_pmf_or_cdf(sketchptr, split_points, arr_len_in, false, false, inclusive);
-  pfree(split_points);
 
   // construct output array of fractions
   arr_len_out = arr_len_in + 1; // N split points divide the number line into N+1 intervals
   get_typlenbyvalalign(FLOAT8OID, &elmlen_out, &elmbyval_out, &elmalign_out);
   arr_out = construct_array(result, arr_len_out, FLOAT8OID, elmlen_out, elmbyval_out, elmalign_out);
 
-  req_float_sketch_delete(sketchptr);
-
   PG_RETURN_ARRAYTYPE_P(arr_out);
 }
 
 Datum pg_req_float_sketch_get_cdf(PG_FUNCTION_ARGS) {
-  const bytea* bytes_in;
   void* sketchptr;
 
   // input array of split points
-  ArrayType* arr_in;
-  Oid elmtype_in;
-  int16 elmlen_in;
-  bool elmbyval_in;
-  char elmalign_in;
-  Datum* data_in;
-  bool* nulls_in;
   int arr_len_in;
-  float* split_points;
+  const float* split_points;
   bool inclusive;
 
   // output array of fractions
@@ -334,50 +536,28 @@ Datum pg_req_float_sketch_get_cdf(PG_FUNCTION_ARGS) {
   char elmalign_out;
   int arr_len_out;
 
-  int i;
+  sketchptr = fn_cache_get_sketch(fcinfo, 0, req_float_sketch_deserialize, req_float_sketch_setup_sorted_view);
 
-  bytes_in = PG_GETARG_BYTEA_P(0);
-  sketchptr = req_float_sketch_deserialize(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ);
-
-  arr_in = PG_GETARG_ARRAYTYPE_P(1);
-  elmtype_in = ARR_ELEMTYPE(arr_in);
-  get_typlenbyvalalign(elmtype_in, &elmlen_in, &elmbyval_in, &elmalign_in);
-  deconstruct_array(arr_in, elmtype_in, elmlen_in, elmbyval_in, elmalign_in, &data_in, &nulls_in, &arr_len_in);
-
-  split_points = palloc(sizeof(float) * arr_len_in);
-  for (i = 0; i < arr_len_in; i++) {
-    split_points[i] = DatumGetFloat4(data_in[i]);
-  }
+  split_points = fn_cache_get_float_array(fcinfo, 1, &arr_len_in);
 
   inclusive = PG_NARGS() > 2 ? PG_GETARG_BOOL(2) : false;
 
   result = (Datum*) req_float_sketch_get_pmf_or_cdf(sketchptr, split_points, arr_len_in, true, false, inclusive);
-  pfree(split_points);
 
   // construct output array of fractions
   arr_len_out = arr_len_in + 1; // N split points divide the number line into N+1 intervals
   get_typlenbyvalalign(FLOAT8OID, &elmlen_out, &elmbyval_out, &elmalign_out);
   arr_out = construct_array(result, arr_len_out, FLOAT8OID, elmlen_out, elmbyval_out, elmalign_out);
 
-  req_float_sketch_delete(sketchptr);
-
   PG_RETURN_ARRAYTYPE_P(arr_out);
 }
 
 Datum pg_req_float_sketch_get_quantiles(PG_FUNCTION_ARGS) {
-  const bytea* bytes_in;
   void* sketchptr;
 
   // input array of fractions
-  ArrayType* arr_in;
-  Oid elmtype_in;
-  int16 elmlen_in;
-  bool elmbyval_in;
-  char elmalign_in;
-  Datum* data_in;
-  bool* nulls_in;
   int arr_len;
-  double* fractions;
+  const double* fractions;
   bool inclusive;
 
   // output array of quantiles
@@ -387,37 +567,22 @@ Datum pg_req_float_sketch_get_quantiles(PG_FUNCTION_ARGS) {
   bool elmbyval_out;
   char elmalign_out;
 
-  int i;
-
-  bytes_in = PG_GETARG_BYTEA_P(0);
-  sketchptr = req_float_sketch_deserialize(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ);
-
-  arr_in = PG_GETARG_ARRAYTYPE_P(1);
-  elmtype_in = ARR_ELEMTYPE(arr_in);
-  get_typlenbyvalalign(elmtype_in, &elmlen_in, &elmbyval_in, &elmalign_in);
-  deconstruct_array(arr_in, elmtype_in, elmlen_in, elmbyval_in, elmalign_in, &data_in, &nulls_in, &arr_len);
+  sketchptr = fn_cache_get_sketch(fcinfo, 0, req_float_sketch_deserialize, req_float_sketch_setup_sorted_view);
 
-  fractions = palloc(sizeof(double) * arr_len);
-  for (i = 0; i < arr_len; i++) {
-    fractions[i] = DatumGetFloat8(data_in[i]);
-  }
+  fractions = fn_cache_get_double_array(fcinfo, 1, &arr_len);
 
   inclusive = PG_NARGS() > 2 ? PG_GETARG_BOOL(2) : false;
 
   quantiles = (Datum*) req_float_sketch_get_quantiles(sketchptr, fractions, arr_len, inclusive);
-  pfree(fractions);
 
   // construct output array of quantiles
   get_typlenbyvalalign(FLOAT4OID, &elmlen_out, &elmbyval_out, &elmalign_out);
   arr_out = construct_array(quantiles, arr_len, FLOAT4OID, elmlen_out, elmbyval_out, elmalign_out);
 
-  req_float_sketch_delete(sketchptr);
-
   PG_RETURN_ARRAYTYPE_P(arr_out);
 }
 
 Datum pg_req_float_sketch_get_histogram(PG_FUNCTION_ARGS) {
-  const bytea* bytes_in;
   void* sketchptr;
   int num_bins;
   bool inclusive;
@@ -437,8 +602,7 @@ Datum pg_req_float_sketch_get_histogram(PG_FUNCTION_ARGS) {
 
   int i;
 
-  bytes_in = PG_GETARG_BYTEA_P(0);
-  sketchptr = req_float_sketch_deserialize(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ);
+  sketchptr = fn_cache_get_sketch(fcinfo, 0, req_float_sketch_deserialize, req_float_sketch_setup_sorted_view);
 
   num_bins = PG_NARGS() > 1 ? PG_GETARG_INT32(1) : DEFAULT_NUM_BINS;
   if (num_bins < 2) {
@@ -462,7 +626,5 @@ Datum pg_req_float_sketch_get_histogram(PG_FUNCTION_ARGS) {
   get_typlenbyvalalign(FLOAT8OID, &elmlen_out, &elmbyval_out, &elmalign_out);
   arr_out = construct_array(result, arr_len_out, FLOAT8OID, elmlen_out, elmbyval_out, elmalign_out);
 
-  req_float_sketch_delete(sketchptr);
-
   PG_RETURN_ARRAYTYPE_P(arr_out);
 }
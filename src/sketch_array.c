@@ -0,0 +1,66 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#include <postgres.h>
+#include <utils/lsyscache.h>
+
+#include "sketch_array.h"
+
+// Since version 16 of PG, all functionality for variable-length
+// data was moved from postgres.h into the new file varatt.h
+#if PG_VERSION_NUM >= 160000
+#include "varatt.h"
+#endif
+
+void sketch_array_init(struct sketch_array* sketches, ArrayType* arr, bool keep_nulls) {
+  Oid elmtype;
+  int16 elmlen;
+  bool elmbyval;
+  char elmalign;
+  Datum* data;
+  bool* nulls;
+  int arr_len;
+  int i;
+  bytea* bytes;
+
+  elmtype = ARR_ELEMTYPE(arr);
+  get_typlenbyvalalign(elmtype, &elmlen, &elmbyval, &elmalign);
+  deconstruct_array(arr, elmtype, elmlen, elmbyval, elmalign, &data, &nulls, &arr_len);
+
+  sketches->num_sketches = 0;
+  sketches->buffers = palloc(sizeof(void*) * (arr_len + 1));
+  sketches->lengths = palloc(sizeof(unsigned) * (arr_len + 1));
+  for (i = 0; i < arr_len; i++) {
+    if (nulls[i]) {
+      if (keep_nulls) {
+        sketches->buffers[sketches->num_sketches] = NULL;
+        sketches->lengths[sketches->num_sketches] = 0;
+        sketches->num_sketches++;
+      }
+      continue;
+    }
+    bytes = DatumGetByteaPP(data[i]);
+    sketches->buffers[sketches->num_sketches] = VARDATA_ANY(bytes);
+    sketches->lengths[sketches->num_sketches] = VARSIZE_ANY_EXHDR(bytes);
+    sketches->num_sketches++;
+  }
+  pfree(data);
+  pfree(nulls);
+}
@@ -0,0 +1,36 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef SKETCH_ARRAY_H
+#define SKETCH_ARRAY_H
+
+#include <utils/array.h>
+
+// serialized sketches of an array argument such as theta_sketch[] for the functions that take all of them at once
+struct sketch_array {
+  unsigned num_sketches;
+  const void** buffers;
+  unsigned* lengths;
+};
+
+// the buffers point into the (detoasted) array, which must be kept
+// null elements are skipped, or kept as null buffers if keep_nulls is set (when positions matter)
+void sketch_array_init(struct sketch_array* sketches, ArrayType* arr, bool keep_nulls);
+
+#endif
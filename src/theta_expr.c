@@ -0,0 +1,150 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#include <postgres.h>
+#include <miscadmin.h>
+
+#include "theta_expr.h"
+
+struct theta_expr_parser {
+  const char* str;
+  unsigned length;
+  unsigned pos;
+  struct theta_expr* expr;
+  unsigned capacity;
+};
+
+static void theta_expr_parse_union(struct theta_expr_parser* parser);
+
+static void theta_expr_skip_spaces(struct theta_expr_parser* parser) {
+  while (parser->pos < parser->length && isspace((unsigned char) parser->str[parser->pos])) parser->pos++;
+}
+
+// consumes one of the given operator symbols
+static bool theta_expr_accept(struct theta_expr_parser* parser, const char* const* symbols) {
+  unsigned symbol_length;
+  theta_expr_skip_spaces(parser);
+  for (; *symbols; symbols++) {
+    symbol_length = strlen(*symbols);
+    if (parser->length - parser->pos >= symbol_length && memcmp(parser->str + parser->pos, *symbols, symbol_length) == 0) {
+      parser->pos += symbol_length;
+      return true;
+    }
+  }
+  return false;
+}
+
+static const char* const THETA_EXPR_UNION_SYMBOLS[] = { "|", "∪", NULL };
+static const char* const THETA_EXPR_INTERSECTION_SYMBOLS[] = { "&", "∩", NULL };
+static const char* const THETA_EXPR_A_NOT_B_SYMBOLS[] = { "-", "−", "∖", NULL };
+
+static void theta_expr_emit(struct theta_expr_parser* parser, enum theta_expr_op_type type, unsigned arg) {
+  struct theta_expr* expr = parser->expr;
+  if (expr->num_ops == parser->capacity) {
+    parser->capacity *= 2;
+    expr->ops = repalloc(expr->ops, sizeof(struct theta_expr_op) * parser->capacity);
+  }
+  expr->ops[expr->num_ops].type = type;
+  expr->ops[expr->num_ops].arg = arg;
+  expr->num_ops++;
+  if (type == THETA_EXPR_SKETCH && arg >= expr->num_sketches) expr->num_sketches = arg + 1;
+}
+
+static void theta_expr_error(const struct theta_expr_parser* parser, const char* message) {
+  elog(ERROR, "theta_sketch_eval: %s at position %u of \"%.*s\"", message, parser->pos + 1, (int) parser->length, parser->str);
+}
+
+// a sketch or an expression in parentheses
+static void theta_expr_parse_operand(struct theta_expr_parser* parser) {
+  unsigned long position;
+  char c;
+  theta_expr_skip_spaces(parser);
+  if (parser->pos == parser->length) theta_expr_error(parser, "operand expected");
+  c = parser->str[parser->pos];
+  if (c == '(') {
+    parser->pos++;
+    check_stack_depth(); // nesting depth is up to the user
+    theta_expr_parse_union(parser);
+    theta_expr_skip_spaces(parser);
+    if (parser->pos == parser->length || parser->str[parser->pos] != ')') theta_expr_error(parser, "')' expected");
+    parser->pos++;
+  } else if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z')) {
+    parser->pos++;
+    theta_expr_emit(parser, THETA_EXPR_SKETCH, (c >= 'a' ? c - 'a' : c - 'A'));
+  } else if (c == '$') {
+    parser->pos++;
+    position = 0;
+    if (parser->pos == parser->length || !isdigit((unsigned char) parser->str[parser->pos])) theta_expr_error(parser, "position expected");
+    while (parser->pos < parser->length && isdigit((unsigned char) parser->str[parser->pos])) {
+      position = position * 10 + (parser->str[parser->pos++] - '0');
+      if (position > PG_INT32_MAX) theta_expr_error(parser, "position out of range");
+    }
+    if (position == 0) theta_expr_error(parser, "positions start at 1");
+    theta_expr_emit(parser, THETA_EXPR_SKETCH, position - 1);
+  } else {
+    theta_expr_error(parser, "operand expected");
+  }
+}
+
+static void theta_expr_parse_intersection(struct theta_expr_parser* parser) {
+  unsigned num_operands = 1;
+  theta_expr_parse_operand(parser);
+  while (theta_expr_accept(parser, THETA_EXPR_INTERSECTION_SYMBOLS)) {
+    theta_expr_parse_operand(parser);
+    num_operands++;
+  }
+  if (num_operands > 1) theta_expr_emit(parser, THETA_EXPR_INTERSECTION, num_operands);
+}
+
+static void theta_expr_parse_union(struct theta_expr_parser* parser) {
+  unsigned num_operands = 1;
+  theta_expr_parse_intersection(parser);
+  for (;;) {
+    if (theta_expr_accept(parser, THETA_EXPR_UNION_SYMBOLS)) {
+      theta_expr_parse_intersection(parser);
+      num_operands++;
+    } else if (theta_expr_accept(parser, THETA_EXPR_A_NOT_B_SYMBOLS)) {
+      // the union so far is the first operand
+      if (num_operands > 1) theta_expr_emit(parser, THETA_EXPR_UNION, num_operands);
+      num_operands = 1;
+      theta_expr_parse_intersection(parser);
+      theta_expr_emit(parser, THETA_EXPR_A_NOT_B, 2);
+    } else {
+      break;
+    }
+  }
+  if (num_operands > 1) theta_expr_emit(parser, THETA_EXPR_UNION, num_operands);
+}
+
+struct theta_expr* theta_expr_parse(const char* str, unsigned length) {
+  struct theta_expr_parser parser;
+  parser.str = str;
+  parser.length = length;
+  parser.pos = 0;
+  parser.capacity = 8;
+  parser.expr = palloc(sizeof(struct theta_expr));
+  parser.expr->num_ops = 0;
+  parser.expr->num_sketches = 0;
+  parser.expr->ops = palloc(sizeof(struct theta_expr_op) * parser.capacity);
+  theta_expr_parse_union(&parser);
+  theta_expr_skip_spaces(&parser);
+  if (parser.pos < parser.length) theta_expr_error(&parser, "operator expected");
+  return parser.expr;
+}
@@ -0,0 +1,54 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef THETA_EXPR_H
+#define THETA_EXPR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// set expression over an array of theta sketches for theta_sketch_eval, such as (A | B) & C - D
+// operands: a letter for the position in the array (A or a is the first sketch) or $n (1-based)
+// operators: | or ∪ for union, & or ∩ for intersection, - or − or ∖ for difference (a not b)
+// intersection binds tighter than union and difference, which are evaluated from left to right
+
+enum theta_expr_op_type { THETA_EXPR_SKETCH, THETA_EXPR_UNION, THETA_EXPR_INTERSECTION, THETA_EXPR_A_NOT_B };
+
+// the expression in postfix order
+// a chain of unions or intersections is a single operation on all of its operands
+struct theta_expr_op {
+  enum theta_expr_op_type type;
+  unsigned arg; // the position of the sketch (0-based) or the number of operands
+};
+
+struct theta_expr {
+  unsigned num_ops;
+  unsigned num_sketches; // the highest position used plus one
+  struct theta_expr_op* ops;
+};
+
+// raises an error if the expression is not valid
+struct theta_expr* theta_expr_parse(const char* str, unsigned length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -20,11 +20,18 @@
 #include "theta_sketch_c_adapter.h"
 #include "allocator.h"
 #include "postgres_h_substitute.h"
+#include "batch_update.h"
 
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <array>
 #include <theta_sketch.hpp>
 #include <theta_union.hpp>
 #include <theta_intersection.hpp>
 #include <theta_a_not_b.hpp>
+#include <theta_jaccard_similarity.hpp>
+#include <binomial_bounds.hpp>
 
 using theta_sketch_pg = datasketches::theta_sketch_alloc<palloc_allocator<uint64_t>>;
 using update_theta_sketch_pg = datasketches::update_theta_sketch_alloc<palloc_allocator<uint64_t>>;
@@ -33,6 +40,29 @@ using theta_union_pg = datasketches::theta_union_alloc<palloc_allocator<uint64_t
 using theta_intersection_pg = datasketches::theta_intersection_alloc<palloc_allocator<uint64_t>>;
 using theta_a_not_b_pg = datasketches::theta_a_not_b_alloc<palloc_allocator<uint64_t>>;
 using wrapped_compact_theta_sketch_pg = datasketches::wrapped_compact_theta_sketch_alloc<palloc_allocator<uint64_t>>;
+using base_theta_sketch_pg = datasketches::base_theta_sketch_alloc<palloc_allocator<uint64_t>>;
+using theta_jaccard_similarity_pg = datasketches::theta_jaccard_similarity_alloc<palloc_allocator<uint64_t>>;
+
+// read-only access to serialized bytes without copying the entries
+// serial versions before 3 cannot be wrapped and are converted by deserialization
+template<typename Func>
+static void with_wrapped_sketch(const void* buffer, unsigned length, Func func) {
+  if (length > 1 && static_cast<const uint8_t*>(buffer)[1] < 3) {
+    func(compact_theta_sketch_pg::deserialize(buffer, length));
+  } else {
+    func(wrapped_compact_theta_sketch_pg::wrap(buffer, length));
+  }
+}
+
+// the same for passing a sketch to a union or intersection, which take the concrete sketch types
+template<typename SetOp>
+static void update_with_wrapped_sketch(SetOp& set_op, const void* buffer, unsigned length) {
+  if (length > 1 && static_cast<const uint8_t*>(buffer)[1] < 3) {
+    set_op.update(compact_theta_sketch_pg::deserialize(buffer, length));
+  } else {
+    set_op.update(wrapped_compact_theta_sketch_pg::wrap(buffer, length));
+  }
+}
 
 void* theta_sketch_new_default() {
   try {
@@ -78,6 +108,16 @@ void theta_sketch_update(void* sketchptr, const void* data, unsigned length) {
   }
 }
 
+// the hashes are passed as 8-byte items, as the build aggregates get bigint values
+void theta_sketch_update_packed(void* sketchptr, const char* data, unsigned num_items) {
+  try {
+    auto& sketch = *static_cast<update_theta_sketch_pg*>(sketchptr);
+    for (unsigned i = 0; i < num_items; ++i) sketch.update(load_little_endian_u64(data + (i << 3)));
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+}
+
 void* theta_sketch_compact(void* sketchptr) {
   try {
     auto newptr = new (palloc(sizeof(compact_theta_sketch_pg))) compact_theta_sketch_pg(static_cast<update_theta_sketch_pg*>(sketchptr)->compact());
@@ -90,6 +130,51 @@ void* theta_sketch_compact(void* sketchptr) {
   pg_unreachable();
 }
 
+// for intermediate aggregate states, skips sorting
+void* theta_sketch_compact_unordered(void* sketchptr) {
+  try {
+    auto newptr = new (palloc(sizeof(compact_theta_sketch_pg))) compact_theta_sketch_pg(static_cast<update_theta_sketch_pg*>(sketchptr)->compact(false));
+    static_cast<update_theta_sketch_pg*>(sketchptr)->~update_theta_sketch_pg();
+    pfree(sketchptr);
+    return newptr;
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+  pg_unreachable();
+}
+
+void* theta_sketch_compact_copy(const void* sketchptr) {
+  try {
+    return new (palloc(sizeof(compact_theta_sketch_pg))) compact_theta_sketch_pg(static_cast<const update_theta_sketch_pg*>(sketchptr)->compact());
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+  pg_unreachable();
+}
+
+void theta_sketch_reset(void* sketchptr) {
+  try {
+    static_cast<update_theta_sketch_pg*>(sketchptr)->reset();
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+}
+
+// intermediate states may be unordered, results of final functions are ordered
+void* compact_theta_sketch_ordered(void* sketchptr) {
+  try {
+    auto sketch = static_cast<compact_theta_sketch_pg*>(sketchptr);
+    if (sketch->is_ordered()) return sketchptr;
+    auto newptr = new (palloc(sizeof(compact_theta_sketch_pg))) compact_theta_sketch_pg(*sketch, true);
+    sketch->~compact_theta_sketch_pg();
+    pfree(sketchptr);
+    return newptr;
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+  pg_unreachable();
+}
+
 double theta_sketch_get_estimate(const void* sketchptr) {
   try {
     return static_cast<const theta_sketch_pg*>(sketchptr)->get_estimate();
@@ -125,6 +210,50 @@ char* theta_sketch_to_string(const void* sketchptr) {
   pg_unreachable();
 }
 
+double theta_sketch_get_estimate_from_bytes(const void* buffer, unsigned length) {
+  try {
+    double estimate;
+    with_wrapped_sketch(buffer, length, [&estimate](const base_theta_sketch_pg& sketch) {
+      estimate = sketch.get_estimate();
+    });
+    return estimate;
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+  pg_unreachable();
+}
+
+Datum* theta_sketch_get_estimate_and_bounds_from_bytes(const void* buffer, unsigned length, unsigned num_std_devs) {
+  try {
+    Datum* est_and_bounds = (Datum*) palloc(sizeof(Datum) * 3);
+    with_wrapped_sketch(buffer, length, [est_and_bounds, num_std_devs](const base_theta_sketch_pg& sketch) {
+      est_and_bounds[0] = pg_float8_get_datum(sketch.get_estimate());
+      est_and_bounds[1] = pg_float8_get_datum(sketch.get_lower_bound(num_std_devs));
+      est_and_bounds[2] = pg_float8_get_datum(sketch.get_upper_bound(num_std_devs));
+    });
+    return est_and_bounds;
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+  pg_unreachable();
+}
+
+char* theta_sketch_to_string_from_bytes(const void* buffer, unsigned length) {
+  try {
+    char* str;
+    with_wrapped_sketch(buffer, length, [&str](const base_theta_sketch_pg& sketch) {
+      auto s = sketch.to_string();
+      const size_t len = s.length() + 1;
+      str = (char*) palloc(len);
+      strncpy(str, s.c_str(), len);
+    });
+    return str;
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+  pg_unreachable();
+}
+
 ptr_with_size theta_sketch_serialize(const void* sketchptr, unsigned header_size) {
   try {
     ptr_with_size p;
@@ -204,6 +333,36 @@ void* theta_union_get_result(void* unionptr) {
   pg_unreachable();
 }
 
+// for intermediate aggregate states, skips sorting
+void* theta_union_get_result_unordered(void* unionptr) {
+  try {
+    auto sketchptr = new (palloc(sizeof(compact_theta_sketch_pg))) compact_theta_sketch_pg(static_cast<const theta_union_pg*>(unionptr)->get_result(false));
+    static_cast<theta_union_pg*>(unionptr)->~theta_union_pg();
+    pfree(unionptr);
+    return sketchptr;
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+  pg_unreachable();
+}
+
+void* theta_union_get_result_copy(const void* unionptr) {
+  try {
+    return new (palloc(sizeof(compact_theta_sketch_pg))) compact_theta_sketch_pg(static_cast<const theta_union_pg*>(unionptr)->get_result());
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+  pg_unreachable();
+}
+
+void theta_union_reset(void* unionptr) {
+  try {
+    static_cast<theta_union_pg*>(unionptr)->reset();
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+}
+
 void* theta_intersection_new_default() {
   try {
     return new (palloc(sizeof(theta_intersection_pg))) theta_intersection_pg;
@@ -250,6 +409,98 @@ void* theta_intersection_get_result(void* interptr) {
   pg_unreachable();
 }
 
+void* theta_intersection_get_result_copy(const void* interptr) {
+  try {
+    return new (palloc(sizeof(compact_theta_sketch_pg))) compact_theta_sketch_pg(static_cast<const theta_intersection_pg*>(interptr)->get_result());
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+  pg_unreachable();
+}
+
+// the hashes of ordered compact sketches come sorted, so their union is a k-way merge
+// that stops at the k smallest distinct hashes below the smallest theta, as the union would retain
+void* theta_union_of_bytes(const void* const* buffers, const unsigned* lengths, unsigned num_sketches, unsigned lg_k) {
+  try {
+    auto builder = theta_union_pg::builder();
+    if (lg_k) builder.set_lg_k(lg_k); // checks the range
+    bool is_mergeable = true;
+    for (unsigned i = 0; i < num_sketches && is_mergeable; ++i) {
+      // serial versions before 3 cannot be wrapped
+      is_mergeable = lengths[i] > 1 && static_cast<const uint8_t*>(buffers[i])[1] >= 3
+        && wrapped_compact_theta_sketch_pg::wrap(buffers[i], lengths[i]).is_ordered();
+    }
+    if (!is_mergeable) {
+      theta_union_pg u = builder.build();
+      for (unsigned i = 0; i < num_sketches; ++i) {
+        update_with_wrapped_sketch(u, buffers[i], lengths[i]);
+      }
+      return new (palloc(sizeof(compact_theta_sketch_pg))) compact_theta_sketch_pg(u.get_result());
+    }
+
+    using cursor = std::pair<wrapped_compact_theta_sketch_pg::const_iterator, wrapped_compact_theta_sketch_pg::const_iterator>;
+    const uint16_t seed_hash = datasketches::compute_seed_hash(datasketches::DEFAULT_SEED);
+    const size_t k = size_t(1) << (lg_k ? lg_k : datasketches::theta_constants::DEFAULT_LG_K);
+    uint64_t theta = datasketches::theta_constants::MAX_THETA;
+    bool is_empty = true;
+    std::vector<wrapped_compact_theta_sketch_pg, palloc_allocator<wrapped_compact_theta_sketch_pg>> sketches;
+    sketches.reserve(num_sketches); // the cursors point into the wrapped sketches
+    std::vector<cursor, palloc_allocator<cursor>> cursors;
+    for (unsigned i = 0; i < num_sketches; ++i) {
+      sketches.push_back(wrapped_compact_theta_sketch_pg::wrap(buffers[i], lengths[i]));
+      const auto& sketch = sketches.back();
+      if (sketch.is_empty()) continue;
+      if (sketch.get_seed_hash() != seed_hash) throw std::invalid_argument("seed hash mismatch");
+      is_empty = false;
+      theta = std::min(theta, sketch.get_theta64());
+      if (sketch.begin() != sketch.end()) cursors.emplace_back(sketch.begin(), sketch.end());
+    }
+
+    // min-heap on the next hash of each sketch
+    auto greater = [](const cursor& a, const cursor& b) { return *a.first > *b.first; };
+    std::make_heap(cursors.begin(), cursors.end(), greater);
+    std::vector<uint64_t, palloc_allocator<uint64_t>> entries;
+    while (!cursors.empty()) {
+      std::pop_heap(cursors.begin(), cursors.end(), greater);
+      auto& next = cursors.back();
+      const uint64_t hash = *next.first;
+      if (hash >= theta) break; // so are the rest of the hashes in all sketches
+      if (entries.empty() || entries.back() != hash) {
+        if (entries.size() == k) {
+          theta = hash; // the bottom-k cutoff
+          break;
+        }
+        entries.push_back(hash);
+      }
+      if (++next.first == next.second) {
+        cursors.pop_back();
+      } else {
+        std::push_heap(cursors.begin(), cursors.end(), greater);
+      }
+    }
+    return new (palloc(sizeof(compact_theta_sketch_pg))) compact_theta_sketch_pg(is_empty, true, seed_hash, theta, std::move(entries));
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+  pg_unreachable();
+}
+
+void* theta_intersection_of_bytes(const void* const* buffers, const unsigned* lengths, unsigned num_sketches) {
+  try {
+    theta_intersection_pg intersection;
+    bool is_empty = false;
+    for (unsigned i = 0; i < num_sketches && !is_empty; ++i) {
+      update_with_wrapped_sketch(intersection, buffers[i], lengths[i]);
+      // so is the intersection, the rest of the sketches cannot change it
+      with_wrapped_sketch(buffers[i], lengths[i], [&is_empty](const base_theta_sketch_pg& sketch) { is_empty = sketch.is_empty(); });
+    }
+    return new (palloc(sizeof(compact_theta_sketch_pg))) compact_theta_sketch_pg(intersection.get_result());
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+  pg_unreachable();
+}
+
 void* theta_a_not_b(const void* buffer1, unsigned length1, const void* buffer2, unsigned length2) {
   try {
     theta_a_not_b_pg a_not_b;
@@ -262,3 +513,412 @@ void* theta_a_not_b(const void* buffer1, unsigned length1, const void* buffer2,
   }
   pg_unreachable();
 }
+
+// read-only view of the hashes of an ordered sketch of serial version 3, which are stored uncompressed after the preamble
+struct theta_hash_span {
+  const uint8_t* entries;
+  uint32_t num_entries;
+  uint64_t theta;
+  bool is_empty;
+
+  uint64_t operator[](size_t i) const {
+    uint64_t hash;
+    std::memcpy(&hash, entries + (i << 3), sizeof(hash)); // the entries are not necessarily aligned
+    return hash;
+  }
+};
+
+// returns false if the hashes cannot be read in place and the sketch must go through the set operations instead
+static bool theta_hash_span_wrap(const void* buffer, unsigned length, theta_hash_span& span) {
+  static const uint16_t default_seed_hash = datasketches::compute_seed_hash(datasketches::DEFAULT_SEED);
+  const uint8_t* bytes = static_cast<const uint8_t*>(buffer);
+  if (length < 8 || bytes[1] != 3) return false;
+  const auto sketch = wrapped_compact_theta_sketch_pg::wrap(buffer, length); // checks the size
+  if (!sketch.is_ordered()) return false;
+  if (!sketch.is_empty() && sketch.get_seed_hash() != default_seed_hash) throw std::invalid_argument("seed hash mismatch");
+  span.entries = bytes + (bytes[0] << 3);
+  span.num_entries = sketch.get_num_retained();
+  span.theta = sketch.get_theta64();
+  span.is_empty = sketch.is_empty();
+  return true;
+}
+
+// first position in [pos, end) with a hash not less than the given one, or end
+// probes 1, 2, 4... positions ahead and searches within the last step, so skipping n hashes takes O(log n)
+static size_t theta_hash_span_seek(const theta_hash_span& span, size_t pos, size_t end, uint64_t hash) {
+  size_t lo = pos;
+  size_t hi = pos;
+  size_t step = 1;
+  while (hi < end && span[hi] < hash) {
+    lo = hi + 1;
+    hi += step;
+    step <<= 1;
+  }
+  if (hi > end) hi = end;
+  while (lo < hi) {
+    const size_t mid = lo + (hi - lo) / 2;
+    if (span[mid] < hash) lo = mid + 1; else hi = mid;
+  }
+  return lo;
+}
+
+// number of hashes in both [0, end1) of the first span and [0, end2) of the second
+// a linear merge, unless one side is so much smaller that seeking each of its hashes in the other is cheaper
+static uint32_t theta_hash_span_count_common(const theta_hash_span& span1, size_t end1, const theta_hash_span& span2, size_t end2) {
+  static const size_t SEEK_RATIO = 16;
+  const bool is_first_smaller = end1 <= end2;
+  const theta_hash_span& small = is_first_smaller ? span1 : span2;
+  const theta_hash_span& large = is_first_smaller ? span2 : span1;
+  const size_t small_end = is_first_smaller ? end1 : end2;
+  const size_t large_end = is_first_smaller ? end2 : end1;
+  uint32_t count = 0;
+  size_t i = 0;
+  size_t j = 0;
+  if (small_end * SEEK_RATIO < large_end) {
+    for (; i < small_end; ++i) {
+      const uint64_t hash = small[i];
+      j = theta_hash_span_seek(large, j, large_end, hash);
+      if (j == large_end) break;
+      if (large[j] == hash) {
+        ++count;
+        ++j;
+      }
+    }
+  } else {
+    while (i < small_end && j < large_end) {
+      const uint64_t hash1 = small[i];
+      const uint64_t hash2 = large[j];
+      if (hash1 < hash2) {
+        ++i;
+      } else if (hash2 < hash1) {
+        ++j;
+      } else {
+        ++count;
+        ++i;
+        ++j;
+      }
+    }
+  }
+  return count;
+}
+
+static double theta_estimate(uint64_t num_entries, uint64_t theta) {
+  return num_entries / (static_cast<double>(theta) / datasketches::theta_constants::MAX_THETA);
+}
+
+// the estimates below match those of the results of the set operations, but ordered sketches of serial version 3
+// (as serialized by this extension) are merged in place without building the result
+
+double theta_union_estimate(const void* buffer1, unsigned length1, const void* buffer2, unsigned length2, unsigned lg_k) {
+  try {
+    auto builder = theta_union_pg::builder();
+    if (lg_k) builder.set_lg_k(lg_k); // checks the range
+    theta_hash_span span1;
+    theta_hash_span span2;
+    if (!theta_hash_span_wrap(buffer1, length1, span1) || !theta_hash_span_wrap(buffer2, length2, span2)) {
+      theta_union_pg u = builder.build();
+      update_with_wrapped_sketch(u, buffer1, length1);
+      update_with_wrapped_sketch(u, buffer2, length2);
+      return u.get_result(false).get_estimate();
+    }
+    if (span1.is_empty && span2.is_empty) return 0;
+    // the theta of an empty sketch does not apply
+    uint64_t theta = std::min(span1.is_empty ? datasketches::theta_constants::MAX_THETA : span1.theta,
+      span2.is_empty ? datasketches::theta_constants::MAX_THETA : span2.theta);
+    const size_t end1 = theta_hash_span_seek(span1, 0, span1.num_entries, theta);
+    const size_t end2 = theta_hash_span_seek(span2, 0, span2.num_entries, theta);
+    uint64_t num_entries = end1 + end2 - theta_hash_span_count_common(span1, end1, span2, end2);
+    const size_t k = size_t(1) << (lg_k ? lg_k : datasketches::theta_constants::DEFAULT_LG_K);
+    if (num_entries > k) {
+      // the union would retain the k smallest hashes, the next one becomes theta
+      size_t i = 0;
+      size_t j = 0;
+      for (size_t n = 0; n < k; ++n) {
+        if (j == end2 || (i < end1 && span1[i] < span2[j])) {
+          ++i;
+        } else if (i == end1 || span2[j] < span1[i]) {
+          ++j;
+        } else {
+          ++i;
+          ++j;
+        }
+      }
+      theta = j == end2 || (i < end1 && span1[i] < span2[j]) ? span1[i] : span2[j];
+      num_entries = k;
+    }
+    return theta_estimate(num_entries, theta);
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+  pg_unreachable();
+}
+
+double theta_intersection_estimate(const void* buffer1, unsigned length1, const void* buffer2, unsigned length2) {
+  try {
+    theta_hash_span span1;
+    theta_hash_span span2;
+    if (!theta_hash_span_wrap(buffer1, length1, span1) || !theta_hash_span_wrap(buffer2, length2, span2)) {
+      theta_intersection_pg intersection;
+      update_with_wrapped_sketch(intersection, buffer1, length1);
+      update_with_wrapped_sketch(intersection, buffer2, length2);
+      return intersection.get_result(false).get_estimate();
+    }
+    if (span1.is_empty || span2.is_empty) return 0;
+    const uint64_t theta = std::min(span1.theta, span2.theta);
+    const size_t end1 = theta_hash_span_seek(span1, 0, span1.num_entries, theta);
+    const size_t end2 = theta_hash_span_seek(span2, 0, span2.num_entries, theta);
+    return theta_estimate(theta_hash_span_count_common(span1, end1, span2, end2), theta);
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+  pg_unreachable();
+}
+
+double theta_a_not_b_estimate(const void* buffer1, unsigned length1, const void* buffer2, unsigned length2) {
+  try {
+    theta_hash_span span1;
+    theta_hash_span span2;
+    if (!theta_hash_span_wrap(buffer1, length1, span1) || !theta_hash_span_wrap(buffer2, length2, span2)) {
+      // serial versions before 3 cannot be wrapped
+      theta_a_not_b_pg a_not_b;
+      return a_not_b.compute(
+        compact_theta_sketch_pg::deserialize(buffer1, length1),
+        compact_theta_sketch_pg::deserialize(buffer2, length2),
+        false
+      ).get_estimate();
+    }
+    if (span1.is_empty) return 0;
+    if (span2.is_empty) return theta_estimate(span1.num_entries, span1.theta);
+    const uint64_t theta = std::min(span1.theta, span2.theta);
+    const size_t end1 = theta_hash_span_seek(span1, 0, span1.num_entries, theta);
+    const size_t end2 = theta_hash_span_seek(span2, 0, span2.num_entries, theta);
+    return theta_estimate(end1 - theta_hash_span_count_common(span1, end1, span2, end2), theta);
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+  pg_unreachable();
+}
+
+Datum* theta_sketch_jaccard(const void* buffer1, unsigned length1, const void* buffer2, unsigned length2) {
+  try {
+    Datum* bounds_and_estimate = (Datum*) palloc(sizeof(Datum) * 3);
+    std::array<double, 3> jaccard;
+    // serial versions before 3 cannot be wrapped
+    if (length1 > 1 && static_cast<const uint8_t*>(buffer1)[1] >= 3 && length2 > 1 && static_cast<const uint8_t*>(buffer2)[1] >= 3) {
+      jaccard = theta_jaccard_similarity_pg::jaccard(
+        wrapped_compact_theta_sketch_pg::wrap(buffer1, length1),
+        wrapped_compact_theta_sketch_pg::wrap(buffer2, length2)
+      );
+    } else {
+      jaccard = theta_jaccard_similarity_pg::jaccard(
+        compact_theta_sketch_pg::deserialize(buffer1, length1),
+        compact_theta_sketch_pg::deserialize(buffer2, length2)
+      );
+    }
+    for (unsigned i = 0; i < 3; ++i) bounds_and_estimate[i] = pg_float8_get_datum(jaccard[i]);
+    return bounds_and_estimate;
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+  pg_unreachable();
+}
+
+// the pairs share the spans of the sketches, which are read in place or converted once
+// the estimate and bounds of each pair match those of the result of the intersection
+Datum* theta_sketch_overlap_matrix(const void* const* buffers, const unsigned* lengths, unsigned num_sketches, unsigned num_std_devs) {
+  try {
+    const size_t num_values = num_std_devs ? 3 : 1;
+    Datum* values = (Datum*) palloc(sizeof(Datum) * num_sketches * num_sketches * num_values);
+    std::vector<theta_hash_span, palloc_allocator<theta_hash_span>> spans(num_sketches);
+    std::vector<compact_theta_sketch_pg, palloc_allocator<compact_theta_sketch_pg>> converted;
+    converted.reserve(num_sketches); // the spans point into the converted sketches
+    for (unsigned i = 0; i < num_sketches; ++i) {
+      theta_hash_span& span = spans[i];
+      if (buffers[i] == nullptr) {
+        // a null is an empty sketch
+        span.entries = nullptr;
+        span.num_entries = 0;
+        span.theta = datasketches::theta_constants::MAX_THETA;
+        span.is_empty = true;
+      } else if (!theta_hash_span_wrap(buffers[i], lengths[i], span)) {
+        converted.emplace_back(compact_theta_sketch_pg::deserialize(buffers[i], lengths[i]), true);
+        const compact_theta_sketch_pg& sketch = converted.back();
+        span.entries = sketch.get_num_retained() ? reinterpret_cast<const uint8_t*>(&*sketch.begin()) : nullptr;
+        span.num_entries = sketch.get_num_retained();
+        span.theta = sketch.get_theta64();
+        span.is_empty = sketch.is_empty();
+      }
+    }
+    for (unsigned i = 0; i < num_sketches; ++i) {
+      for (unsigned j = i; j < num_sketches; ++j) {
+        const theta_hash_span& span1 = spans[i];
+        const theta_hash_span& span2 = spans[j];
+        const bool is_empty = span1.is_empty || span2.is_empty;
+        const uint64_t theta = is_empty ? datasketches::theta_constants::MAX_THETA : std::min(span1.theta, span2.theta);
+        uint32_t num_entries = 0;
+        if (!is_empty) {
+          const size_t end1 = theta_hash_span_seek(span1, 0, span1.num_entries, theta);
+          num_entries = i == j ? end1 : theta_hash_span_count_common(span1, end1, span2, theta_hash_span_seek(span2, 0, span2.num_entries, theta));
+        }
+        Datum* pair_values1 = values + (static_cast<size_t>(i) * num_sketches + j) * num_values;
+        Datum* pair_values2 = values + (static_cast<size_t>(j) * num_sketches + i) * num_values;
+        pair_values1[0] = pg_float8_get_datum(theta_estimate(num_entries, theta));
+        if (num_std_devs) {
+          if (is_empty || theta == datasketches::theta_constants::MAX_THETA) {
+            // exact
+            pair_values1[1] = pair_values1[0];
+            pair_values1[2] = pair_values1[0];
+          } else {
+            const double fraction = static_cast<double>(theta) / datasketches::theta_constants::MAX_THETA;
+            pair_values1[1] = pg_float8_get_datum(datasketches::binomial_bounds::get_lower_bound(num_entries, fraction, num_std_devs));
+            pair_values1[2] = pg_float8_get_datum(datasketches::binomial_bounds::get_upper_bound(num_entries, fraction, num_std_devs));
+          }
+        }
+        if (i != j) std::copy(pair_values1, pair_values1 + num_values, pair_values2);
+      }
+    }
+    return values;
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+  pg_unreachable();
+}
+
+// accessor that reads only the serialized preamble
+// returns false if the bytes must be fully deserialized instead
+// serial version 3: preamble longs, serial version, family, unused (2 bytes), flags, seed hash (2 bytes),
+// then if 2 or 3 preamble longs: num entries (4 bytes), unused (4 bytes), then if 3 preamble longs: theta (8 bytes)
+// serial version 4 (compressed): preamble longs, serial version, family, entry bits, num entries bytes, flags, seed hash (2 bytes),
+// then if 2 preamble longs: theta (8 bytes), then num entries (num entries bytes)
+
+static const uint8_t THETA_FAMILY = 3;
+static const uint8_t THETA_FLAG_EMPTY = 4;
+
+bool theta_sketch_peek_estimate(const char* buffer, unsigned length, double* estimate) {
+  try {
+    static const uint16_t default_seed_hash = datasketches::compute_seed_hash(datasketches::DEFAULT_SEED);
+    uint8_t preamble_longs;
+    uint16_t seed_hash;
+    uint32_t num_entries = 0;
+    uint64_t theta = datasketches::theta_constants::MAX_THETA;
+    if (length < 8 || buffer[2] != THETA_FAMILY) return false;
+    preamble_longs = buffer[0];
+    std::memcpy(&seed_hash, buffer + 6, sizeof(seed_hash));
+    // let deserialization report the mismatch
+    if (seed_hash != default_seed_hash) return false;
+    if (buffer[1] == 3) {
+      if (buffer[5] & THETA_FLAG_EMPTY) {
+        *estimate = 0;
+        return true;
+      }
+      if (preamble_longs == 1) {
+        // single item
+        *estimate = 1;
+        return true;
+      }
+      if (length < 8u * preamble_longs) return false;
+      std::memcpy(&num_entries, buffer + 8, sizeof(num_entries));
+      if (preamble_longs > 2) std::memcpy(&theta, buffer + 16, sizeof(theta));
+    } else if (buffer[1] == 4) {
+      const uint8_t num_entries_bytes = buffer[4];
+      if (num_entries_bytes > sizeof(num_entries) || length < 8u * preamble_longs + num_entries_bytes) return false;
+      if (preamble_longs > 1) std::memcpy(&theta, buffer + 8, sizeof(theta));
+      for (unsigned i = 0; i < num_entries_bytes; ++i) {
+        num_entries |= static_cast<uint32_t>(static_cast<uint8_t>(buffer[8 * preamble_longs + i])) << (i << 3);
+      }
+    } else {
+      return false;
+    }
+    *estimate = num_entries / (static_cast<double>(theta) / datasketches::theta_constants::MAX_THETA);
+    return true;
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+  pg_unreachable();
+}
+
+// operand of theta_expr_eval: a sketch of the array read in place, or a result (or converted input) held in memory
+struct theta_expr_operand {
+  const void* buffer;
+  unsigned length;
+  const compact_theta_sketch_pg* sketch; // null for sketches read in place
+};
+
+template<typename SetOp>
+static void update_with_operand(SetOp& set_op, const theta_expr_operand& operand) {
+  if (operand.sketch) {
+    set_op.update(*operand.sketch);
+  } else {
+    set_op.update(wrapped_compact_theta_sketch_pg::wrap(operand.buffer, operand.length));
+  }
+}
+
+template<typename Sketch>
+static compact_theta_sketch_pg a_not_b_with_operand(const Sketch& a, const theta_expr_operand& b) {
+  theta_a_not_b_pg a_not_b;
+  if (b.sketch) return a_not_b.compute(a, *b.sketch);
+  return a_not_b.compute(a, wrapped_compact_theta_sketch_pg::wrap(b.buffer, b.length));
+}
+
+static compact_theta_sketch_pg a_not_b_operands(const theta_expr_operand& a, const theta_expr_operand& b) {
+  if (a.sketch) return a_not_b_with_operand(*a.sketch, b);
+  return a_not_b_with_operand(wrapped_compact_theta_sketch_pg::wrap(a.buffer, a.length), b);
+}
+
+void* theta_expr_eval(const struct theta_expr* expr, const void* const* buffers, const unsigned* lengths, unsigned lg_k) {
+  try {
+    auto union_builder = theta_union_pg::builder();
+    if (lg_k) union_builder.set_lg_k(lg_k);
+    const compact_theta_sketch_pg empty_sketch(true, true, datasketches::compute_seed_hash(datasketches::DEFAULT_SEED),
+      datasketches::theta_constants::MAX_THETA, std::vector<uint64_t, palloc_allocator<uint64_t>>());
+
+    // every operation and every input that cannot be read in place adds at most one sketch
+    // reserved up front, so that the operands can point to them
+    std::vector<compact_theta_sketch_pg, palloc_allocator<compact_theta_sketch_pg>> results;
+    results.reserve(expr->num_ops);
+    std::vector<theta_expr_operand, palloc_allocator<theta_expr_operand>> stack;
+    for (unsigned i = 0; i < expr->num_ops; ++i) {
+      const theta_expr_op& op = expr->ops[i];
+      if (op.type == THETA_EXPR_SKETCH) {
+        const void* buffer = buffers[op.arg];
+        const unsigned length = lengths[op.arg];
+        if (buffer == nullptr) {
+          stack.push_back({nullptr, 0, &empty_sketch});
+        } else if (length > 1 && static_cast<const uint8_t*>(buffer)[1] < 3) {
+          // serial versions before 3 cannot be wrapped
+          results.push_back(compact_theta_sketch_pg::deserialize(buffer, length));
+          stack.push_back({nullptr, 0, &results.back()});
+        } else {
+          stack.push_back({buffer, length, nullptr});
+        }
+        continue;
+      }
+      const unsigned num_operands = op.type == THETA_EXPR_A_NOT_B ? 2 : op.arg;
+      const theta_expr_operand* operands = stack.data() + stack.size() - num_operands;
+      if (op.type == THETA_EXPR_UNION) {
+        theta_union_pg u = union_builder.build();
+        for (unsigned j = 0; j < num_operands; ++j) update_with_operand(u, operands[j]);
+        results.push_back(u.get_result());
+      } else if (op.type == THETA_EXPR_INTERSECTION) {
+        theta_intersection_pg intersection;
+        for (unsigned j = 0; j < num_operands; ++j) {
+          update_with_operand(intersection, operands[j]);
+          // the intersection stays empty
+          if (operands[j].sketch ? operands[j].sketch->is_empty() : wrapped_compact_theta_sketch_pg::wrap(operands[j].buffer, operands[j].length).is_empty()) break;
+        }
+        results.push_back(intersection.get_result());
+      } else {
+        results.push_back(a_not_b_operands(operands[0], operands[1]));
+      }
+      stack.resize(stack.size() - num_operands);
+      stack.push_back({nullptr, 0, &results.back()});
+    }
+
+    const theta_expr_operand& result = stack.back();
+    if (result.sketch) return new (palloc(sizeof(compact_theta_sketch_pg))) compact_theta_sketch_pg(*result.sketch);
+    return new (palloc(sizeof(compact_theta_sketch_pg))) compact_theta_sketch_pg(wrapped_compact_theta_sketch_pg::wrap(result.buffer, result.length), true);
+  } catch (std::exception& e) {
+    pg_error(e.what());
+  }
+  pg_unreachable();
+}
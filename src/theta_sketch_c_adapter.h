@@ -25,6 +25,7 @@ extern "C" {
 #endif
 
 #include "ptr_with_size.h"
+#include "theta_expr.h"
 
 void* theta_sketch_new_default();
 void* theta_sketch_new_lgk(unsigned lg_k);
@@ -32,30 +33,72 @@ void* theta_sketch_new_lgk_p(unsigned lg_k, float p);
 void theta_sketch_delete(void* sketchptr);
 
 void theta_sketch_update(void* sketchptr, const void* data, unsigned length);
+// little-endian 64-bit hashes, see datasketches_hash
+void theta_sketch_update_packed(void* sketchptr, const char* data, unsigned num_items);
 void* theta_sketch_compact(void* sketchptr);
+void* theta_sketch_compact_unordered(void* sketchptr);
+// the sketch is kept
+void* theta_sketch_compact_copy(const void* sketchptr);
+void theta_sketch_reset(void* sketchptr);
+void* compact_theta_sketch_ordered(void* sketchptr);
 void theta_sketch_union(void* sketchptr1, const void* sketchptr2);
 double theta_sketch_get_estimate(const void* sketchptr);
 void** theta_sketch_get_estimate_and_bounds(const void* sketchptr, unsigned num_std_devs);
 char* theta_sketch_to_string(const void* sketchptr);
 
+// read serialized bytes in place
+double theta_sketch_get_estimate_from_bytes(const void* buffer, unsigned length);
+void** theta_sketch_get_estimate_and_bounds_from_bytes(const void* buffer, unsigned length, unsigned num_std_devs);
+char* theta_sketch_to_string_from_bytes(const void* buffer, unsigned length);
+
 struct ptr_with_size theta_sketch_serialize(const void* sketchptr, unsigned header_size);
 void* theta_sketch_deserialize(const char* buffer, unsigned length);
 
+// enough for the estimate
+static const unsigned THETA_SKETCH_ESTIMATE_SLICE_SIZE = 24;
+bool theta_sketch_peek_estimate(const char* buffer, unsigned length, double* estimate);
+
 void* theta_union_new_default();
 void* theta_union_new(unsigned lg_k);
 void theta_union_delete(void* unionptr);
 void theta_union_update_with_sketch(void* unionptr, const void* sketchptr);
 void theta_union_update_with_bytes(void* unionptr, const void* buffer, unsigned length);
 void* theta_union_get_result(void* unionptr);
+void* theta_union_get_result_unordered(void* unionptr);
+// the union is kept
+void* theta_union_get_result_copy(const void* unionptr);
+void theta_union_reset(void* unionptr);
 
 void* theta_intersection_new_default();
 void theta_intersection_delete(void* interptr);
 void theta_intersection_update_with_sketch(void* interptr, const void* sketchptr);
 void theta_intersection_update_with_bytes(void* interptr, const void* buffer, unsigned length);
 void* theta_intersection_get_result(void* interptr);
+void* theta_intersection_get_result_copy(const void* interptr);
+
+// set operations on a number of serialized sketches at once, the result is a compact sketch
+// lg_k 0 means default
+void* theta_union_of_bytes(const void* const* buffers, const unsigned* lengths, unsigned num_sketches, unsigned lg_k);
+// at least one sketch is required
+void* theta_intersection_of_bytes(const void* const* buffers, const unsigned* lengths, unsigned num_sketches);
 
 void* theta_a_not_b(const void* buffer1, unsigned length1, const void* buffer2, unsigned length2);
 
+// estimates of the results of set operations on two serialized sketches without building the results
+// lg_k of the union, 0 means default
+double theta_union_estimate(const void* buffer1, unsigned length1, const void* buffer2, unsigned length2, unsigned lg_k);
+double theta_intersection_estimate(const void* buffer1, unsigned length1, const void* buffer2, unsigned length2);
+double theta_a_not_b_estimate(const void* buffer1, unsigned length1, const void* buffer2, unsigned length2);
+// lower bound, estimate and upper bound of the Jaccard similarity
+void** theta_sketch_jaccard(const void* buffer1, unsigned length1, const void* buffer2, unsigned length2);
+// row-major matrix of the intersection estimates of all pairs of serialized sketches (a null buffer is an empty sketch)
+// with num_std_devs > 0 each pair has the estimate, lower bound and upper bound
+void** theta_sketch_overlap_matrix(const void* const* buffers, const unsigned* lengths, unsigned num_sketches, unsigned num_std_devs);
+
+// evaluates the expression over serialized sketches by position (a null buffer is an empty sketch) into a compact sketch
+// lg_k of the unions, 0 means default
+void* theta_expr_eval(const struct theta_expr* expr, const void* const* buffers, const unsigned* lengths, unsigned lg_k);
+
 #ifdef __cplusplus
 }
 #endif
@@ -26,6 +26,14 @@
 
 #include "theta_sketch_c_adapter.h"
 #include "agg_state.h"
+#include "fn_cache.h"
+#include "agg_context.h"
+#include "window_queue.h"
+#include "expanded_sketch.h"
+#include "sketch_array.h"
+
+const unsigned THETA_DEFAULT_LG_K = 12;
+const unsigned THETA_MIN_LG_K = 5;
 
 /* PG_FUNCTION_INFO_V1 macro to pass functions to postgres */
 PG_FUNCTION_INFO_V1(pg_theta_sketch_build_agg);
@@ -43,6 +51,19 @@ PG_FUNCTION_INFO_V1(pg_theta_sketch_to_string);
 PG_FUNCTION_INFO_V1(pg_theta_sketch_union);
 PG_FUNCTION_INFO_V1(pg_theta_sketch_intersection);
 PG_FUNCTION_INFO_V1(pg_theta_sketch_a_not_b);
+PG_FUNCTION_INFO_V1(pg_theta_sketch_union_moving_agg);
+PG_FUNCTION_INFO_V1(pg_theta_sketch_union_moving_inv);
+PG_FUNCTION_INFO_V1(pg_theta_sketch_union_moving_final);
+PG_FUNCTION_INFO_V1(pg_theta_sketch_union_array);
+PG_FUNCTION_INFO_V1(pg_theta_sketch_intersection_array);
+PG_FUNCTION_INFO_V1(pg_theta_sketch_eval);
+PG_FUNCTION_INFO_V1(pg_theta_sketch_eval_estimate);
+PG_FUNCTION_INFO_V1(pg_theta_sketch_union_estimate);
+PG_FUNCTION_INFO_V1(pg_theta_sketch_intersection_estimate);
+PG_FUNCTION_INFO_V1(pg_theta_sketch_a_not_b_estimate);
+PG_FUNCTION_INFO_V1(pg_theta_sketch_jaccard);
+PG_FUNCTION_INFO_V1(pg_theta_sketch_overlap_matrix);
+PG_FUNCTION_INFO_V1(pg_theta_sketch_update_packed);
 
 /* function declarations */
 Datum pg_theta_sketch_build_agg(PG_FUNCTION_ARGS);
@@ -60,17 +81,64 @@ Datum pg_theta_sketch_to_string(PG_FUNCTION_ARGS);
 Datum pg_theta_sketch_union(PG_FUNCTION_ARGS);
 Datum pg_theta_sketch_intersection(PG_FUNCTION_ARGS);
 Datum pg_theta_sketch_a_not_b(PG_FUNCTION_ARGS);
+Datum pg_theta_sketch_union_moving_agg(PG_FUNCTION_ARGS);
+Datum pg_theta_sketch_union_moving_inv(PG_FUNCTION_ARGS);
+Datum pg_theta_sketch_union_moving_final(PG_FUNCTION_ARGS);
+Datum pg_theta_sketch_union_array(PG_FUNCTION_ARGS);
+Datum pg_theta_sketch_intersection_array(PG_FUNCTION_ARGS);
+Datum pg_theta_sketch_eval(PG_FUNCTION_ARGS);
+Datum pg_theta_sketch_eval_estimate(PG_FUNCTION_ARGS);
+Datum pg_theta_sketch_union_estimate(PG_FUNCTION_ARGS);
+Datum pg_theta_sketch_intersection_estimate(PG_FUNCTION_ARGS);
+Datum pg_theta_sketch_a_not_b_estimate(PG_FUNCTION_ARGS);
+Datum pg_theta_sketch_jaccard(PG_FUNCTION_ARGS);
+Datum pg_theta_sketch_overlap_matrix(PG_FUNCTION_ARGS);
+Datum pg_theta_sketch_update_packed(PG_FUNCTION_ARGS);
+
+// context for the allocations of the sketch or union of the state
+static MemoryContext theta_agg_state_object_context(const struct agg_state* stateptr) {
+  return stateptr->pool ? object_pool_context(stateptr->pool) : CurrentMemoryContext;
+}
+
+// resets the pooled sketch or union of the state and hands it over to the next group
+static void theta_agg_state_release(struct agg_state* stateptr) {
+  const bool is_union = stateptr->type == UNION;
+  MemoryContext oldcontext = MemoryContextSwitchTo(object_pool_context(stateptr->pool));
+  if (is_union) {
+    theta_union_reset(stateptr->ptr);
+  } else {
+    theta_sketch_reset(stateptr->ptr);
+  }
+  if (!object_pool_release(stateptr->pool, is_union ? POOLED_THETA_UNION : POOLED_THETA_SKETCH, stateptr->lg_k, stateptr->ptr)) {
+    if (is_union) {
+      theta_union_delete(stateptr->ptr);
+    } else {
+      theta_sketch_delete(stateptr->ptr);
+    }
+  }
+  MemoryContextSwitchTo(oldcontext);
+  stateptr->ptr = NULL;
+  stateptr->pool = NULL;
+}
+
+// replaces the pooled sketch or union of the state with a compact copy of the result and returns it to the pool
+// a pooled object is only used by sorted aggregation, where the group gets no more updates after the final function
+static void theta_agg_state_release_to_result(struct agg_state* stateptr) {
+  void* sketchptr;
+  if (stateptr->pool == NULL) return;
+  sketchptr = stateptr->type == UNION ? theta_union_get_result_copy(stateptr->ptr) : theta_sketch_compact_copy(stateptr->ptr);
+  theta_agg_state_release(stateptr);
+  stateptr->type = IMMUTABLE_SKETCH;
+  stateptr->ptr = sketchptr;
+}
 
 Datum pg_theta_sketch_build_agg(PG_FUNCTION_ARGS) {
   struct agg_state* stateptr;
   float p;
 
   // anyelement
-  Oid   element_type;
-  Datum element;
-  int16 typlen;
-  bool  typbyval;
-  char  typalign;
+  const void* element;
+  unsigned length;
 
   MemoryContext oldcontext;
   MemoryContext aggcontext;
@@ -84,35 +152,35 @@ Datum pg_theta_sketch_build_agg(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "theta_sketch_build_agg called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "theta_sketch"));
 
+  p = PG_NARGS() > 3 ? PG_GETARG_FLOAT4(3) : 0;
   if (PG_ARGISNULL(0)) {
     stateptr = palloc(sizeof(struct agg_state));
     stateptr->type = MUTABLE_SKETCH;
     stateptr->lg_k = PG_NARGS() > 2 ? PG_GETARG_INT32(2) : 0;
-    p = PG_NARGS() > 3 ? PG_GETARG_FLOAT4(3) : 0;
+    // the pool tells sketches apart by lg_k only
+    stateptr->pool = p ? NULL : fn_cache_get_object_pool(fcinfo);
+    if (sketch_agg_memory_budget > 0) {
+      stateptr->lg_k = sketch_agg_lg_k(CurrentMemoryContext, stateptr->pool ? object_pool_context(stateptr->pool) : NULL,
+        stateptr->lg_k ? stateptr->lg_k : THETA_DEFAULT_LG_K, THETA_MIN_LG_K);
+    }
+    stateptr->ptr = stateptr->pool ? object_pool_acquire(stateptr->pool, POOLED_THETA_SKETCH, stateptr->lg_k) : NULL;
+  } else {
+    stateptr = (struct agg_state*) PG_GETARG_POINTER(0);
+  }
+
+  MemoryContextSwitchTo(theta_agg_state_object_context(stateptr));
+  if (stateptr->ptr == NULL) {
     if (stateptr->lg_k) {
       stateptr->ptr = p ? theta_sketch_new_lgk_p(stateptr->lg_k, p) : theta_sketch_new_lgk(stateptr->lg_k);
     } else {
       stateptr->ptr = theta_sketch_new_default();
     }
-  } else {
-    stateptr = (struct agg_state*) PG_GETARG_POINTER(0);
   }
 
-  element_type = get_fn_expr_argtype(fcinfo->flinfo, 1);
-  element = PG_GETARG_DATUM(1);
-  get_typlenbyvalalign(element_type, &typlen, &typbyval, &typalign);
-  if (typlen == -1) {
-    // varlena
-    theta_sketch_update(stateptr->ptr, VARDATA_ANY(element), VARSIZE_ANY_EXHDR(element));
-  } else if (typbyval) {
-    // fixed-length passed by value
-    theta_sketch_update(stateptr->ptr, &element, typlen);
-  } else {
-    // fixed-length passed by reference
-    theta_sketch_update(stateptr->ptr, (void*)element, typlen);
-  }
+  element = fn_cache_get_element(fcinfo, 1, &length);
+  theta_sketch_update(stateptr->ptr, element, length);
 
   MemoryContextSwitchTo(oldcontext);
 
@@ -135,18 +203,23 @@ Datum pg_theta_sketch_union_agg(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "theta_sketch_union_agg called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "theta_sketch"));
 
   if (PG_ARGISNULL(0)) {
     stateptr = palloc(sizeof(struct agg_state));
     stateptr->type = UNION;
+    stateptr->pool = fn_cache_get_object_pool(fcinfo);
     stateptr->lg_k = PG_NARGS() > 2 ? PG_GETARG_INT32(2) : 0;
-    stateptr->ptr = stateptr->lg_k ? theta_union_new(stateptr->lg_k) : theta_union_new_default();
+    stateptr->ptr = stateptr->pool ? object_pool_acquire(stateptr->pool, POOLED_THETA_UNION, stateptr->lg_k) : NULL;
   } else {
     stateptr = (struct agg_state*) PG_GETARG_POINTER(0);
   }
 
   sketch_bytes = PG_GETARG_BYTEA_P(1);
+  MemoryContextSwitchTo(theta_agg_state_object_context(stateptr));
+  if (stateptr->ptr == NULL) {
+    stateptr->ptr = stateptr->lg_k ? theta_union_new(stateptr->lg_k) : theta_union_new_default();
+  }
   theta_union_update_with_bytes(stateptr->ptr, VARDATA(sketch_bytes), VARSIZE(sketch_bytes) - VARHDRSZ);
 
   MemoryContextSwitchTo(oldcontext);
@@ -170,11 +243,12 @@ Datum pg_theta_sketch_intersection_agg(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "theta_sketch_intersection_agg called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "theta_sketch"));
 
   if (PG_ARGISNULL(0)) {
     stateptr = palloc(sizeof(struct agg_state));
     stateptr->type = INTERSECTION;
+    stateptr->pool = NULL;
     stateptr->ptr = theta_intersection_new_default();
   } else {
     stateptr = (struct agg_state*) PG_GETARG_POINTER(0);
@@ -188,9 +262,11 @@ Datum pg_theta_sketch_intersection_agg(PG_FUNCTION_ARGS) {
   PG_RETURN_POINTER(stateptr);
 }
 
+// does not destroy the state, so that window aggregates can call it after every row
 Datum pg_theta_sketch_from_internal(PG_FUNCTION_ARGS) {
   struct agg_state* stateptr;
   struct ptr_with_size bytes_out;
+  void* sketchptr;
 
   MemoryContext oldcontext;
   MemoryContext aggcontext;
@@ -200,29 +276,36 @@ Datum pg_theta_sketch_from_internal(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "theta_sketch_from_internal called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "theta_sketch"));
 
   stateptr = (struct agg_state*) PG_GETARG_POINTER(0);
+  theta_agg_state_release_to_result(stateptr);
+  if (stateptr->type == IMMUTABLE_SKETCH) {
+    stateptr->ptr = compact_theta_sketch_ordered(stateptr->ptr);
+  }
+
+  MemoryContextSwitchTo(oldcontext);
+
   if (stateptr->type == MUTABLE_SKETCH) {
-    stateptr->ptr = theta_sketch_compact(stateptr->ptr);
+    sketchptr = theta_sketch_compact_copy(stateptr->ptr);
   } else if (stateptr->type == UNION) {
-    stateptr->ptr = theta_union_get_result(stateptr->ptr);
+    sketchptr = theta_union_get_result_copy(stateptr->ptr);
   } else if (stateptr->type == INTERSECTION) {
-    stateptr->ptr = theta_intersection_get_result(stateptr->ptr);
+    sketchptr = theta_intersection_get_result_copy(stateptr->ptr);
+  } else {
+    sketchptr = stateptr->ptr;
   }
-  bytes_out = theta_sketch_serialize(stateptr->ptr, VARHDRSZ);
-  theta_sketch_delete(stateptr->ptr);
-  pfree(stateptr);
+  bytes_out = theta_sketch_serialize(sketchptr, VARHDRSZ);
+  if (sketchptr != stateptr->ptr) theta_sketch_delete(sketchptr);
   SET_VARSIZE(bytes_out.ptr, bytes_out.size);
 
-  MemoryContextSwitchTo(oldcontext);
-
   PG_RETURN_BYTEA_P(bytes_out.ptr);
 }
 
 Datum pg_theta_sketch_get_estimate_from_internal(PG_FUNCTION_ARGS) {
   struct agg_state* stateptr;
   double estimate;
+  void* sketchptr;
 
   MemoryContext oldcontext;
   MemoryContext aggcontext;
@@ -232,22 +315,39 @@ Datum pg_theta_sketch_get_estimate_from_internal(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "theta_sketch_get_estimate_from_internal called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "theta_sketch"));
 
   stateptr = (struct agg_state*) PG_GETARG_POINTER(0);
-  estimate = theta_sketch_get_estimate(stateptr->ptr);
-  theta_sketch_delete(stateptr->ptr);
-  pfree(stateptr);
+  theta_agg_state_release_to_result(stateptr);
 
   MemoryContextSwitchTo(oldcontext);
 
+  // the estimate without serializing the result
+  if (stateptr->type == UNION || stateptr->type == INTERSECTION) {
+    sketchptr = stateptr->type == UNION ? theta_union_get_result_copy(stateptr->ptr) : theta_intersection_get_result_copy(stateptr->ptr);
+    estimate = theta_sketch_get_estimate(sketchptr);
+    theta_sketch_delete(sketchptr);
+  } else {
+    estimate = theta_sketch_get_estimate(stateptr->ptr);
+  }
+
   PG_RETURN_FLOAT8(estimate);
 }
 
+// updates the union with the sketch or union of the state, which is consumed
+static void theta_union_update_with_state(void* unionptr, struct agg_state* stateptr) {
+  if (stateptr->type == UNION) {
+    stateptr->ptr = theta_union_get_result_unordered(stateptr->ptr);
+  }
+  theta_union_update_with_sketch(unionptr, stateptr->ptr);
+  theta_sketch_delete(stateptr->ptr);
+}
+
 Datum pg_theta_sketch_union_combine(PG_FUNCTION_ARGS) {
   struct agg_state* stateptr1;
   struct agg_state* stateptr2;
   struct agg_state* stateptr;
+  void* unionptr;
 
   MemoryContext oldcontext;
   MemoryContext aggcontext;
@@ -257,32 +357,28 @@ Datum pg_theta_sketch_union_combine(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "theta_sketch_union_combine called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "theta_sketch"));
 
   stateptr1 = (struct agg_state*) PG_GETARG_POINTER(0);
   stateptr2 = (struct agg_state*) PG_GETARG_POINTER(1);
 
-  stateptr = palloc(sizeof(struct agg_state));
-  stateptr->type = IMMUTABLE_SKETCH;
-  stateptr->lg_k = stateptr1 ? stateptr1->lg_k : stateptr2->lg_k;
-  stateptr->ptr = stateptr->lg_k ? theta_union_new(stateptr->lg_k) : theta_union_new_default();
-  if (stateptr1) {
-    if (stateptr1->type == UNION) {
-      stateptr1->ptr = theta_union_get_result(stateptr1->ptr);
-    }
-    theta_union_update_with_sketch(stateptr->ptr, stateptr1->ptr);
-    theta_sketch_delete(stateptr1->ptr);
-    pfree(stateptr1);
-  }
-  if (stateptr2) {
-    if (stateptr2->type == UNION) {
-      stateptr2->ptr = theta_union_get_result(stateptr2->ptr);
+  // the second state is merged into the first one, which becomes a union if it is not one yet
+  // the result is left as a union and compacted (ordered) only by the final function
+  if (stateptr1 == NULL) {
+    stateptr = stateptr2;
+  } else {
+    stateptr = stateptr1;
+    if (stateptr2) {
+      if (stateptr->type != UNION) {
+        unionptr = stateptr->lg_k ? theta_union_new(stateptr->lg_k) : theta_union_new_default();
+        theta_union_update_with_state(unionptr, stateptr);
+        stateptr->type = UNION;
+        stateptr->ptr = unionptr;
+      }
+      theta_union_update_with_state(stateptr->ptr, stateptr2);
+      pfree(stateptr2);
     }
-    theta_union_update_with_sketch(stateptr->ptr, stateptr2->ptr);
-    theta_sketch_delete(stateptr2->ptr);
-    pfree(stateptr2);
   }
-  stateptr->ptr = theta_union_get_result(stateptr->ptr);
 
   MemoryContextSwitchTo(oldcontext);
 
@@ -302,13 +398,14 @@ Datum pg_theta_sketch_intersection_combine(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "theta_sketch_intersection_combine called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "theta_sketch"));
 
   stateptr1 = (struct agg_state*) PG_GETARG_POINTER(0);
   stateptr2 = (struct agg_state*) PG_GETARG_POINTER(1);
 
   stateptr = palloc(sizeof(struct agg_state));
   stateptr->type = IMMUTABLE_SKETCH;
+  stateptr->pool = NULL;
   stateptr->ptr = theta_intersection_new_default();
   if (stateptr1) {
     if (stateptr1->type == INTERSECTION) {
@@ -345,13 +442,14 @@ Datum pg_theta_sketch_serialize_state(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "theta_sketch_serialize_state called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "theta_sketch"));
 
   stateptr = (struct agg_state*) PG_GETARG_POINTER(0);
+  // intermediate state, ordering is left to the final function
   if (stateptr->type == MUTABLE_SKETCH) {
-    stateptr->ptr = theta_sketch_compact(stateptr->ptr);
+    stateptr->ptr = theta_sketch_compact_unordered(stateptr->ptr);
   } else if (stateptr->type == UNION) {
-    stateptr->ptr = theta_union_get_result(stateptr->ptr);
+    stateptr->ptr = theta_union_get_result_unordered(stateptr->ptr);
   } else if (stateptr->type == INTERSECTION) {
     stateptr->ptr = theta_intersection_get_result(stateptr->ptr);
   }
@@ -378,11 +476,12 @@ Datum pg_theta_sketch_deserialize_state(PG_FUNCTION_ARGS) {
   if (!AggCheckCallContext(fcinfo, &aggcontext)) {
     elog(ERROR, "theta_sketch_deserialize_state called in non-aggregate context");
   }
-  oldcontext = MemoryContextSwitchTo(aggcontext);
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "theta_sketch"));
 
   bytes_in = PG_GETARG_BYTEA_P(0);
   stateptr = palloc(sizeof(struct agg_state));
   stateptr->type = IMMUTABLE_SKETCH;
+  stateptr->pool = NULL;
   stateptr->lg_k = *VARDATA(bytes_in);
   stateptr->ptr = theta_sketch_deserialize(VARDATA(bytes_in) + 1, VARSIZE(bytes_in) - VARHDRSZ - 1);
 
@@ -393,18 +492,18 @@ Datum pg_theta_sketch_deserialize_state(PG_FUNCTION_ARGS) {
 
 Datum pg_theta_sketch_get_estimate(PG_FUNCTION_ARGS) {
   const bytea* bytes_in;
-  void* sketchptr;
   double estimate;
-  bytes_in = PG_GETARG_BYTEA_P(0);
-  sketchptr = theta_sketch_deserialize(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ);
-  estimate = theta_sketch_get_estimate(sketchptr);
-  theta_sketch_delete(sketchptr);
+  // num entries and theta are in the preamble, try to read just that
+  bytes_in = PG_GETARG_BYTEA_P_SLICE(0, 0, THETA_SKETCH_ESTIMATE_SLICE_SIZE);
+  if (!theta_sketch_peek_estimate(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ, &estimate)) {
+    bytes_in = PG_GETARG_BYTEA_PP(0);
+    estimate = theta_sketch_get_estimate_from_bytes(VARDATA_ANY(bytes_in), VARSIZE_ANY_EXHDR(bytes_in));
+  }
   PG_RETURN_FLOAT8(estimate);
 }
 
 Datum pg_theta_sketch_get_estimate_and_bounds(PG_FUNCTION_ARGS) {
   const bytea* bytes_in;
-  void* sketchptr;
   int num_std_devs;
 
   // output array
@@ -414,11 +513,9 @@ Datum pg_theta_sketch_get_estimate_and_bounds(PG_FUNCTION_ARGS) {
   bool elmbyval_out;
   char elmalign_out;
 
-  bytes_in = PG_GETARG_BYTEA_P(0);
-  sketchptr = theta_sketch_deserialize(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ);
+  bytes_in = PG_GETARG_BYTEA_PP(0);
   num_std_devs = PG_NARGS() > 1 ? PG_GETARG_INT32(1) : 1;
-  est_and_bounds = (Datum*) theta_sketch_get_estimate_and_bounds(sketchptr, num_std_devs);
-  theta_sketch_delete(sketchptr);
+  est_and_bounds = (Datum*) theta_sketch_get_estimate_and_bounds_from_bytes(VARDATA_ANY(bytes_in), VARSIZE_ANY_EXHDR(bytes_in), num_std_devs);
 
   // construct output array
   get_typlenbyvalalign(FLOAT8OID, &elmlen_out, &elmbyval_out, &elmalign_out);
@@ -428,38 +525,38 @@ Datum pg_theta_sketch_get_estimate_and_bounds(PG_FUNCTION_ARGS) {
 
 Datum pg_theta_sketch_to_string(PG_FUNCTION_ARGS) {
   const bytea* bytes_in;
-  void* sketchptr;
   char* str;
-  bytes_in = PG_GETARG_BYTEA_P(0);
-  sketchptr = theta_sketch_deserialize(VARDATA(bytes_in), VARSIZE(bytes_in) - VARHDRSZ);
-  str = theta_sketch_to_string(sketchptr);
-  theta_sketch_delete(sketchptr);
+  bytes_in = PG_GETARG_BYTEA_PP(0);
+  str = theta_sketch_to_string_from_bytes(VARDATA_ANY(bytes_in), VARSIZE_ANY_EXHDR(bytes_in));
   PG_RETURN_TEXT_P(cstring_to_text(str));
 }
 
-Datum pg_theta_sketch_union(PG_FUNCTION_ARGS) {
-  const bytea* bytes_in1;
-  const bytea* bytes_in2;
-  void* unionptr;
-  void* sketchptr;
-  struct ptr_with_size bytes_out;
-  unsigned lg_k;
+static void* theta_union_ops_new(unsigned lg_k) {
+  return lg_k ? theta_union_new(lg_k) : theta_union_new_default();
+}
 
-  lg_k = PG_NARGS() > 2 ? PG_GETARG_INT32(2) : 0;
-  unionptr = lg_k ? theta_union_new(lg_k) : theta_union_new_default();
-  if (!PG_ARGISNULL(0)) {
-    bytes_in1 = PG_GETARG_BYTEA_P(0);
-    theta_union_update_with_bytes(unionptr, VARDATA(bytes_in1), VARSIZE(bytes_in1) - VARHDRSZ);
-  }
-  if (!PG_ARGISNULL(1)) {
-    bytes_in2 = PG_GETARG_BYTEA_P(1);
-    theta_union_update_with_bytes(unionptr, VARDATA(bytes_in2), VARSIZE(bytes_in2) - VARHDRSZ);
-  }
-  sketchptr = theta_union_get_result(unionptr);
-  bytes_out = theta_sketch_serialize(sketchptr, VARHDRSZ);
+static void theta_union_ops_update(void* unionptr, const char* buffer, unsigned length) {
+  theta_union_update_with_bytes(unionptr, buffer, length);
+}
+
+static struct ptr_with_size theta_union_ops_serialize(void* unionptr, unsigned result_param, unsigned header_size) {
+  struct ptr_with_size bytes_out;
+  void* sketchptr = theta_union_get_result_copy(unionptr);
+  bytes_out = theta_sketch_serialize(sketchptr, header_size);
   theta_sketch_delete(sketchptr);
-  SET_VARSIZE(bytes_out.ptr, bytes_out.size);
-  PG_RETURN_BYTEA_P(bytes_out.ptr);
+  return bytes_out;
+}
+
+static const struct sketch_union_ops theta_union_ops = {
+  theta_union_ops_new,
+  theta_union_ops_update,
+  theta_union_ops_serialize,
+  theta_union_delete
+};
+
+Datum pg_theta_sketch_union(PG_FUNCTION_ARGS) {
+  const unsigned lg_k = PG_NARGS() > 2 ? PG_GETARG_INT32(2) : 0;
+  PG_RETURN_DATUM(expanded_sketch_union(fcinfo, &theta_union_ops, lg_k, 0));
 }
 
 Datum pg_theta_sketch_intersection(PG_FUNCTION_ARGS) {
@@ -503,3 +600,252 @@ Datum pg_theta_sketch_a_not_b(PG_FUNCTION_ARGS) {
   SET_VARSIZE(bytes_out.ptr, bytes_out.size);
   PG_RETURN_BYTEA_P(bytes_out.ptr);
 }
+
+// moving-aggregate mode of theta_sketch_union over sliding window frames, see window_queue.h
+Datum pg_theta_sketch_union_moving_agg(PG_FUNCTION_ARGS) {
+  struct window_queue* queue;
+  bytea* sketch_bytes;
+
+  MemoryContext oldcontext;
+  MemoryContext aggcontext;
+
+  if (!AggCheckCallContext(fcinfo, &aggcontext)) {
+    elog(ERROR, "theta_sketch_union_moving_agg called in non-aggregate context");
+  }
+  oldcontext = MemoryContextSwitchTo(sketch_agg_context(aggcontext, "theta_sketch"));
+
+  if (PG_ARGISNULL(0)) {
+    queue = window_queue_new(&theta_union_ops, PG_NARGS() > 2 ? PG_GETARG_INT32(2) : 0, 0);
+  } else {
+    queue = (struct window_queue*) PG_GETARG_POINTER(0);
+  }
+
+  // the inverse function skips null values too
+  if (!PG_ARGISNULL(1)) {
+    sketch_bytes = PG_GETARG_BYTEA_PP(1);
+    window_queue_push(queue, VARDATA_ANY(sketch_bytes), VARSIZE_ANY_EXHDR(sketch_bytes));
+  }
+
+  MemoryContextSwitchTo(oldcontext);
+
+  PG_RETURN_POINTER(queue);
+}
+
+Datum pg_theta_sketch_union_moving_inv(PG_FUNCTION_ARGS) {
+  struct window_queue* queue;
+
+  if (!AggCheckCallContext(fcinfo, NULL)) {
+    elog(ERROR, "theta_sketch_union_moving_inv called in non-aggregate context");
+  }
+
+  queue = (struct window_queue*) PG_GETARG_POINTER(0);
+  if (!PG_ARGISNULL(1)) window_queue_pop(queue);
+
+  PG_RETURN_POINTER(queue);
+}
+
+Datum pg_theta_sketch_union_moving_final(PG_FUNCTION_ARGS) {
+  bytea* bytes_out;
+
+  if (PG_ARGISNULL(0)) PG_RETURN_NULL();
+
+  if (!AggCheckCallContext(fcinfo, NULL)) {
+    elog(ERROR, "theta_sketch_union_moving_final called in non-aggregate context");
+  }
+
+  bytes_out = window_queue_get_result((struct window_queue*) PG_GETARG_POINTER(0));
+  if (bytes_out == NULL) PG_RETURN_NULL();
+  PG_RETURN_BYTEA_P(bytes_out);
+}
+
+// the whole array in one call, without serializing intermediate results
+Datum pg_theta_sketch_union_array(PG_FUNCTION_ARGS) {
+  struct sketch_array sketches;
+  void* sketchptr;
+  struct ptr_with_size bytes_out;
+  unsigned lg_k;
+
+  sketch_array_init(&sketches, PG_GETARG_ARRAYTYPE_P(0), false);
+  lg_k = PG_NARGS() > 1 ? PG_GETARG_INT32(1) : 0;
+  sketchptr = theta_union_of_bytes(sketches.buffers, sketches.lengths, sketches.num_sketches, lg_k);
+  bytes_out = theta_sketch_serialize(sketchptr, VARHDRSZ);
+  theta_sketch_delete(sketchptr);
+  SET_VARSIZE(bytes_out.ptr, bytes_out.size);
+  PG_RETURN_BYTEA_P(bytes_out.ptr);
+}
+
+Datum pg_theta_sketch_intersection_array(PG_FUNCTION_ARGS) {
+  struct sketch_array sketches;
+  void* sketchptr;
+  struct ptr_with_size bytes_out;
+
+  sketch_array_init(&sketches, PG_GETARG_ARRAYTYPE_P(0), false);
+  if (sketches.num_sketches == 0) PG_RETURN_NULL(); // the intersection of nothing is undefined
+  sketchptr = theta_intersection_of_bytes(sketches.buffers, sketches.lengths, sketches.num_sketches);
+  bytes_out = theta_sketch_serialize(sketchptr, VARHDRSZ);
+  theta_sketch_delete(sketchptr);
+  SET_VARSIZE(bytes_out.ptr, bytes_out.size);
+  PG_RETURN_BYTEA_P(bytes_out.ptr);
+}
+
+static void* theta_expr_parse_text(const char* str, unsigned length) {
+  return theta_expr_parse(str, length);
+}
+
+// the result of theta_sketch_eval(expr, sketches [, lg_k]) as a compact sketch
+// the parsed expression is cached for the following rows, see theta_expr.h
+static void* theta_sketch_eval_internal(FunctionCallInfo fcinfo) {
+  const struct theta_expr* expr;
+  struct sketch_array sketches;
+  unsigned lg_k;
+
+  expr = fn_cache_get_parsed_text(fcinfo, 0, theta_expr_parse_text);
+  sketch_array_init(&sketches, PG_GETARG_ARRAYTYPE_P(1), true);
+  if (expr->num_sketches > sketches.num_sketches) {
+    elog(ERROR, "theta_sketch_eval: the expression refers to sketch %u, the array has %u", expr->num_sketches, sketches.num_sketches);
+  }
+  lg_k = PG_NARGS() > 2 ? PG_GETARG_INT32(2) : 0;
+  return theta_expr_eval(expr, sketches.buffers, sketches.lengths, lg_k);
+}
+
+Datum pg_theta_sketch_eval(PG_FUNCTION_ARGS) {
+  void* sketchptr;
+  struct ptr_with_size bytes_out;
+
+  sketchptr = theta_sketch_eval_internal(fcinfo);
+  bytes_out = theta_sketch_serialize(sketchptr, VARHDRSZ);
+  theta_sketch_delete(sketchptr);
+  SET_VARSIZE(bytes_out.ptr, bytes_out.size);
+  PG_RETURN_BYTEA_P(bytes_out.ptr);
+}
+
+Datum pg_theta_sketch_eval_estimate(PG_FUNCTION_ARGS) {
+  void* sketchptr;
+  double estimate;
+
+  sketchptr = theta_sketch_eval_internal(fcinfo);
+  estimate = theta_sketch_get_estimate(sketchptr);
+  theta_sketch_delete(sketchptr);
+  PG_RETURN_FLOAT8(estimate);
+}
+
+// estimates of set operations on two sketches, the results are not built
+Datum pg_theta_sketch_union_estimate(PG_FUNCTION_ARGS) {
+  const bytea* bytes_in1;
+  const bytea* bytes_in2;
+  unsigned lg_k;
+
+  bytes_in1 = PG_GETARG_BYTEA_PP(0);
+  bytes_in2 = PG_GETARG_BYTEA_PP(1);
+  lg_k = PG_NARGS() > 2 ? PG_GETARG_INT32(2) : 0;
+  PG_RETURN_FLOAT8(theta_union_estimate(VARDATA_ANY(bytes_in1), VARSIZE_ANY_EXHDR(bytes_in1), VARDATA_ANY(bytes_in2), VARSIZE_ANY_EXHDR(bytes_in2), lg_k));
+}
+
+Datum pg_theta_sketch_intersection_estimate(PG_FUNCTION_ARGS) {
+  const bytea* bytes_in1;
+  const bytea* bytes_in2;
+
+  bytes_in1 = PG_GETARG_BYTEA_PP(0);
+  bytes_in2 = PG_GETARG_BYTEA_PP(1);
+  PG_RETURN_FLOAT8(theta_intersection_estimate(VARDATA_ANY(bytes_in1), VARSIZE_ANY_EXHDR(bytes_in1), VARDATA_ANY(bytes_in2), VARSIZE_ANY_EXHDR(bytes_in2)));
+}
+
+Datum pg_theta_sketch_a_not_b_estimate(PG_FUNCTION_ARGS) {
+  const bytea* bytes_in1;
+  const bytea* bytes_in2;
+
+  bytes_in1 = PG_GETARG_BYTEA_PP(0);
+  bytes_in2 = PG_GETARG_BYTEA_PP(1);
+  PG_RETURN_FLOAT8(theta_a_not_b_estimate(VARDATA_ANY(bytes_in1), VARSIZE_ANY_EXHDR(bytes_in1), VARDATA_ANY(bytes_in2), VARSIZE_ANY_EXHDR(bytes_in2)));
+}
+
+Datum pg_theta_sketch_jaccard(PG_FUNCTION_ARGS) {
+  const bytea* bytes_in1;
+  const bytea* bytes_in2;
+
+  // output array
+  Datum* bounds_and_estimate;
+  ArrayType* arr_out;
+  int16 elmlen_out;
+  bool elmbyval_out;
+  char elmalign_out;
+
+  bytes_in1 = PG_GETARG_BYTEA_PP(0);
+  bytes_in2 = PG_GETARG_BYTEA_PP(1);
+  bounds_and_estimate = (Datum*) theta_sketch_jaccard(VARDATA_ANY(bytes_in1), VARSIZE_ANY_EXHDR(bytes_in1), VARDATA_ANY(bytes_in2), VARSIZE_ANY_EXHDR(bytes_in2));
+
+  // construct output array
+  get_typlenbyvalalign(FLOAT8OID, &elmlen_out, &elmbyval_out, &elmalign_out);
+  arr_out = construct_array(bounds_and_estimate, 3, FLOAT8OID, elmlen_out, elmbyval_out, elmalign_out);
+  PG_RETURN_ARRAYTYPE_P(arr_out);
+}
+
+// intersection estimates of all pairs of sketches of the array as an N x N array, or N x N x 3 with the bounds
+// nulls are empty sketches
+Datum pg_theta_sketch_overlap_matrix(PG_FUNCTION_ARGS) {
+  struct sketch_array sketches;
+  int num_std_devs;
+
+  // output array
+  Datum* values;
+  ArrayType* arr_out;
+  int dims[3];
+  int lbs[3] = { 1, 1, 1 };
+  int16 elmlen_out;
+  bool elmbyval_out;
+  char elmalign_out;
+
+  sketch_array_init(&sketches, PG_GETARG_ARRAYTYPE_P(0), true);
+  if (sketches.num_sketches == 0) PG_RETURN_ARRAYTYPE_P(construct_empty_array(FLOAT8OID));
+  num_std_devs = PG_NARGS() > 1 ? PG_GETARG_INT32(1) : 0;
+  if (PG_NARGS() > 1 && (num_std_devs < 1 || num_std_devs > 3)) {
+    elog(ERROR, "theta_sketch_overlap_matrix: num_std_devs must be 1, 2 or 3");
+  }
+  values = (Datum*) theta_sketch_overlap_matrix(sketches.buffers, sketches.lengths, sketches.num_sketches, num_std_devs);
+
+  // construct output array
+  dims[0] = sketches.num_sketches;
+  dims[1] = sketches.num_sketches;
+  dims[2] = 3;
+  get_typlenbyvalalign(FLOAT8OID, &elmlen_out, &elmbyval_out, &elmalign_out);
+  arr_out = construct_md_array(values, NULL, num_std_devs ? 3 : 2, dims, lbs, FLOAT8OID, elmlen_out, elmbyval_out, elmalign_out);
+  PG_RETURN_ARRAYTYPE_P(arr_out);
+}
+
+// adds a batch of hashes packed by the client to the sketch, a null sketch is empty
+// the batch goes into a new sketch, which is merged with the given one by a union with the given lg_k
+Datum pg_theta_sketch_update_packed(PG_FUNCTION_ARGS) {
+  const bytea* bytes_in;
+  const bytea* packed;
+  void* sketchptr;
+  void* unionptr;
+  struct ptr_with_size bytes_out;
+  unsigned lg_k;
+
+  if (PG_ARGISNULL(1)) {
+    if (PG_ARGISNULL(0)) PG_RETURN_NULL();
+    PG_RETURN_DATUM(PG_GETARG_DATUM(0));
+  }
+  packed = PG_GETARG_BYTEA_PP(1);
+  if (VARSIZE_ANY_EXHDR(packed) % 8) {
+    elog(ERROR, "theta_sketch_update_packed expects packed 64-bit hashes, got %u bytes", (unsigned) VARSIZE_ANY_EXHDR(packed));
+  }
+  lg_k = PG_NARGS() > 2 && !PG_ARGISNULL(2) ? PG_GETARG_INT32(2) : 0;
+
+  sketchptr = lg_k ? theta_sketch_new_lgk(lg_k) : theta_sketch_new_default();
+  theta_sketch_update_packed(sketchptr, VARDATA_ANY(packed), VARSIZE_ANY_EXHDR(packed) / 8);
+  if (PG_ARGISNULL(0)) {
+    sketchptr = theta_sketch_compact(sketchptr);
+  } else {
+    bytes_in = PG_GETARG_BYTEA_PP(0);
+    unionptr = lg_k ? theta_union_new(lg_k) : theta_union_new_default();
+    theta_union_update_with_bytes(unionptr, VARDATA_ANY(bytes_in), VARSIZE_ANY_EXHDR(bytes_in));
+    theta_union_update_with_sketch(unionptr, sketchptr);
+    theta_sketch_delete(sketchptr);
+    sketchptr = theta_union_get_result(unionptr);
+  }
+  bytes_out = theta_sketch_serialize(sketchptr, VARHDRSZ);
+  theta_sketch_delete(sketchptr);
+  SET_VARSIZE(bytes_out.ptr, bytes_out.size);
+  PG_RETURN_BYTEA_P(bytes_out.ptr);
+}
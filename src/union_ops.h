@@ -0,0 +1,34 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef UNION_OPS_H
+#define UNION_OPS_H
+
+#include "ptr_with_size.h"
+
+// union operations of a sketch family, for code that merges serialized sketches regardless of the family
+struct sketch_union_ops {
+  void* (*union_new)(unsigned param); // param such as lg_k
+  void (*union_update)(void* unionptr, const char* buffer, unsigned length);
+  // keeps the content of the union (which may be reorganized), result_param selects the form of the final result (0 for intermediate results)
+  struct ptr_with_size (*union_serialize)(void* unionptr, unsigned result_param, unsigned header_size);
+  void (*union_delete)(void* unionptr);
+};
+
+#endif
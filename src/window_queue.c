@@ -0,0 +1,117 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <postgres.h>
+
+#include "window_queue.h"
+
+// Since version 16 of PG, all functionality for variable-length
+// data was moved from postgres.h into the new file varatt.h
+#if PG_VERSION_NUM >= 160000
+#include "varatt.h"
+#endif
+
+static bytea* window_queue_serialize(struct window_queue* queue, void* unionptr, unsigned result_param) {
+  struct ptr_with_size bytes_out = queue->ops->union_serialize(unionptr, result_param, VARHDRSZ);
+  SET_VARSIZE(bytes_out.ptr, bytes_out.size);
+  return (bytea*) bytes_out.ptr;
+}
+
+struct window_queue* window_queue_new(const struct sketch_union_ops* ops, unsigned param, unsigned result_param) {
+  struct window_queue* queue = palloc0(sizeof(struct window_queue));
+  queue->ops = ops;
+  queue->param = param;
+  queue->result_param = result_param;
+  queue->context = CurrentMemoryContext;
+  return queue;
+}
+
+void window_queue_push(struct window_queue* queue, const char* buffer, unsigned length) {
+  bytea* bytes;
+  MemoryContext oldcontext = MemoryContextSwitchTo(queue->context);
+  if (queue->back_size == queue->back_capacity) {
+    queue->back_capacity = queue->back_capacity ? queue->back_capacity * 2 : 16;
+    queue->back = queue->back ? repalloc(queue->back, sizeof(bytea*) * queue->back_capacity) : palloc(sizeof(bytea*) * queue->back_capacity);
+  }
+  bytes = palloc(VARHDRSZ + length);
+  SET_VARSIZE(bytes, VARHDRSZ + length);
+  memcpy(VARDATA(bytes), buffer, length);
+  queue->back[queue->back_size++] = bytes;
+  if (queue->back_union == NULL) queue->back_union = queue->ops->union_new(queue->param);
+  queue->ops->union_update(queue->back_union, buffer, length);
+  MemoryContextSwitchTo(oldcontext);
+}
+
+// moves the back stack over to the front, the newest sketch goes to the bottom
+static void window_queue_flip(struct window_queue* queue) {
+  void* unionptr;
+  unsigned i;
+  if (queue->front) pfree(queue->front);
+  queue->front = palloc(sizeof(bytea*) * queue->back_size);
+  unionptr = queue->ops->union_new(queue->param);
+  for (i = queue->back_size; i > 0; i--) {
+    queue->ops->union_update(unionptr, VARDATA(queue->back[i - 1]), VARSIZE(queue->back[i - 1]) - VARHDRSZ);
+    if (i == queue->back_size) {
+      queue->front[i - 1] = queue->back[i - 1]; // the union of just one sketch
+    } else {
+      queue->front[i - 1] = window_queue_serialize(queue, unionptr, 0);
+      pfree(queue->back[i - 1]);
+    }
+  }
+  queue->ops->union_delete(unionptr);
+  queue->ops->union_delete(queue->back_union);
+  queue->back_union = NULL;
+  queue->front_head = 0;
+  queue->front_size = queue->back_size;
+  queue->back_size = 0;
+}
+
+void window_queue_pop(struct window_queue* queue) {
+  MemoryContext oldcontext = MemoryContextSwitchTo(queue->context);
+  if (queue->front_head == queue->front_size) {
+    if (queue->back_size == 0) elog(ERROR, "window_queue_pop: the frame is empty");
+    window_queue_flip(queue);
+  }
+  pfree(queue->front[queue->front_head++]);
+  MemoryContextSwitchTo(oldcontext);
+}
+
+bytea* window_queue_get_result(struct window_queue* queue) {
+  void* unionptr;
+  bytea* bytes;
+  MemoryContext oldcontext;
+  const bool has_front = queue->front_head < queue->front_size;
+  if (!has_front && queue->back_union == NULL) return NULL;
+  unionptr = queue->ops->union_new(queue->param);
+  if (has_front) {
+    bytes = queue->front[queue->front_head];
+    queue->ops->union_update(unionptr, VARDATA(bytes), VARSIZE(bytes) - VARHDRSZ);
+  }
+  if (queue->back_union) {
+    // getting the result may reorganize the union
+    oldcontext = MemoryContextSwitchTo(queue->context);
+    bytes = window_queue_serialize(queue, queue->back_union, 0);
+    MemoryContextSwitchTo(oldcontext);
+    queue->ops->union_update(unionptr, VARDATA(bytes), VARSIZE(bytes) - VARHDRSZ);
+    pfree(bytes);
+  }
+  bytes = window_queue_serialize(queue, unionptr, queue->result_param);
+  queue->ops->union_delete(unionptr);
+  return bytes;
+}
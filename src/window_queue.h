@@ -0,0 +1,59 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef WINDOW_QUEUE_H
+#define WINDOW_QUEUE_H
+
+#include "union_ops.h"
+
+// state of the moving-aggregate mode of union and merge aggregates over sliding window frames
+// sketches cannot be subtracted, so the frame is kept as a queue of two stacks:
+// the back stack holds the sketches added since the last flip together with their union,
+// the front stack holds, for each of the older sketches, the union of it and all the sketches after it in the stack
+// when the front stack runs out, the back stack is flipped over to it
+// so that each row costs a constant number of merges (amortized) instead of merging the whole frame
+
+struct window_queue {
+  const struct sketch_union_ops* ops;
+  unsigned param; // such as lg_k
+  unsigned result_param;
+  MemoryContext context; // of the queue and everything it holds
+  bytea** back;
+  unsigned back_size;
+  unsigned back_capacity;
+  void* back_union; // null if the back stack is empty
+  bytea** front;
+  unsigned front_head; // the oldest sketch still in the frame
+  unsigned front_size;
+};
+
+// the queue lives in the current memory context
+struct window_queue* window_queue_new(const struct sketch_union_ops* ops, unsigned param, unsigned result_param);
+
+// push and pop can be called in any memory context
+// the sketch entering the frame, the bytes are copied
+void window_queue_push(struct window_queue* queue, const char* buffer, unsigned length);
+
+// the oldest sketch leaving the frame
+void window_queue_pop(struct window_queue* queue);
+
+// serialized union of the frame (allocated in the current memory context), null if the frame is empty
+bytea* window_queue_get_result(struct window_queue* queue);
+
+#endif
@@ -21,8 +21,12 @@ select cpc_sketch_get_estimate(sketch) from cpc_sketch_test;
 
 -- default lgk and type
 select cpc_sketch_get_estimate(cpc_sketch_union(sketch)) from cpc_sketch_test;
+select cpc_sketch_union_distinct(sketch) from cpc_sketch_test;
 -- lgk = 8
 select cpc_sketch_get_estimate(cpc_sketch_union(sketch, 8)) from cpc_sketch_test;
 
+-- build from hashes computed once per item
+select cpc_sketch_get_estimate(cpc_sketch_build_from_hash(datasketches_hash(value))) from generate_series(1, 100) as value;
+
 drop table cpc_sketch_test;
 drop extension datasketches;
@@ -21,8 +21,41 @@ select hll_sketch_get_estimate(sketch) from hll_sketch_test;
 
 -- default lgk and type
 select hll_sketch_get_estimate(hll_sketch_union(sketch)) from hll_sketch_test;
+select hll_sketch_union_distinct(sketch) from hll_sketch_test;
 -- lgk = 8 and type = HLL_6
 select hll_sketch_get_estimate(hll_sketch_union(sketch, 8, 6)) from hll_sketch_test;
 
+-- sketches in HLL mode with lgk >= union lgk (HLL_4 and HLL_8)
+select hll_sketch_get_estimate(hll_sketch_union(sketch, 10)) from (
+  select hll_sketch_build(value, 10, 4) as sketch from generate_series(1, 5000) as value
+  union all
+  select hll_sketch_build(value, 12, 8) as sketch from generate_series(2501, 7500) as value
+) as t;
+
+-- running distinct count, the final function leaves the state for the next row
+select value, hll_sketch_distinct(value % 4) over (order by value) as running_distinct
+from generate_series(1, 8) as value;
+
+-- distinct count over a sliding frame, the sketches leaving the frame are removed from the state
+select value, hll_sketch_get_estimate(hll_sketch_union(sketch) over (order by value rows between 2 preceding and current row)) as distinct_last_3
+from (select value, hll_sketch_build(item) as sketch from generate_series(1, 8) as value, generate_series(value, value + 9) as item group by value) as t;
+
+-- nested unions pass the union along without serializing the intermediate results
+select hll_sketch_get_estimate(hll_sketch_union(hll_sketch_union(hll_sketch_build(1), hll_sketch_build(2)), hll_sketch_union(hll_sketch_build(2), hll_sketch_build(3))));
+
+-- union of an array of sketches
+select hll_sketch_get_estimate(hll_sketch_union(array[hll_sketch_build(1), hll_sketch_build(2), null, hll_sketch_build(2)]));
+
+-- build from hashes computed once per item
+select hll_sketch_get_estimate(hll_sketch_build_from_hash(datasketches_hash(value))) from generate_series(1, 100) as value;
+
+-- batches of little-endian hashes
+select hll_sketch_get_estimate(hll_sketch_update_packed(hll_sketch_update_packed(null, '\x01000000000000000200000000000000'::bytea, 10), '\x0200000000000000'::bytea));
+
+-- a union of one sketch in HLL mode gives the estimate of the sketch as the union computes it, the union of two the merged one
+select hll_sketch_get_estimate(s), hll_sketch_get_estimate(hll_sketch_union(s, null)), hll_sketch_get_estimate(hll_sketch_union(s, s))
+from (select hll_sketch_build(value) as s from generate_series(1, 10000) as value) as t;
+select hll_sketch_get_estimate(hll_sketch_union(s)) from (select hll_sketch_build(value) as s from generate_series(1, 10000) as value) as t;
+
 drop table hll_sketch_test;
 drop extension datasketches;
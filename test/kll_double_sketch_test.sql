@@ -31,5 +31,9 @@ select kll_double_sketch_get_pmf(kll_double_sketch_merge(sketch, 20), array[2, 5
 select kll_double_sketch_get_cdf(kll_double_sketch_merge(sketch, 20), array[2, 5, 7]) as cdf from kll_sketch_test;
 select kll_double_sketch_get_histogram(kll_double_sketch_merge(sketch, 20), 5) as histogram from kll_sketch_test;
 
+-- quantiles straight from the aggregate state
+select kll_double_approx_quantile(value, 0.5) as median, kll_double_approx_quantiles(value, array[0, 0.5, 1]) as min_median_max
+  from generate_series(1, 100) as t(value);
+
 drop table kll_sketch_test;
 drop extension datasketches;
@@ -31,5 +31,32 @@ select kll_float_sketch_get_pmf(kll_float_sketch_merge(sketch, 20), array[2, 5,
 select kll_float_sketch_get_cdf(kll_float_sketch_merge(sketch, 20), array[2, 5, 7]) as cdf from kll_sketch_test;
 select kll_float_sketch_get_histogram(kll_float_sketch_merge(sketch, 20), 5) as histogram from kll_sketch_test;
 
+-- the same sketch against many rows, deserialized once per call site
+select value, kll_float_sketch_get_rank(r.sketch, value) as rank
+  from (select kll_float_sketch_merge(sketch) as sketch from kll_sketch_test) r
+  cross join generate_series(1, 10) as t(value);
+
+-- quantiles straight from the aggregate state
+select kll_float_approx_quantile(value::real, 0.5) as median, kll_float_approx_quantiles(value::real, array[0, 0.5, 1], 20) as min_median_max
+  from generate_series(1, 100) as t(value);
+
+-- small groups are kept exactly and grow into sketches past a threshold
+select g, kll_float_sketch_get_n(kll_float_sketch_build(value::real)) as n, kll_float_approx_quantile(value::real, 0.5) as median
+  from generate_series(1, 100) as t(value) cross join (values (1), (10), (100)) as l(g)
+  where value <= g
+  group by g order by g;
+
+-- running median, the final function leaves the state for the next row
+select value, kll_float_approx_quantile(value::real, 0.5) over (order by value) as running_median,
+  kll_float_sketch_get_n(kll_float_sketch_build(value::real) over (order by value)) as running_n
+from generate_series(1, 8) as value;
+
+-- count over a sliding frame, the sketches leaving the frame are removed from the state
+select value, kll_float_sketch_get_n(kll_float_sketch_merge(sketch) over (order by value rows between 2 preceding and current row)) as n_last_3
+from (select value, kll_float_sketch_build(item::real) as sketch from generate_series(1, 8) as value, generate_series(1, value) as item group by value) as t;
+
+-- batches of little-endian floats 1, 2 and 3
+select kll_float_sketch_get_n(s), kll_float_sketch_get_quantile(s, 0.5) from (select kll_float_sketch_update_packed(null, '\x0000803f0000004000004040'::bytea) as s) as t;
+
 drop table kll_sketch_test;
 drop extension datasketches;
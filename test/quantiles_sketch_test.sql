@@ -29,5 +29,9 @@ select quantiles_double_sketch_get_pmf(quantiles_double_sketch_merge(sketch, 32)
 select quantiles_double_sketch_get_cdf(quantiles_double_sketch_merge(sketch, 32), array[2, 5, 7]) as cdf from quantiles_sketch_test;
 select quantiles_double_sketch_get_histogram(quantiles_double_sketch_merge(sketch, 32), 5) as histogram from quantiles_sketch_test;
 
+-- quantiles straight from the aggregate state
+select quantiles_double_approx_quantile(value, 0.5) as median, quantiles_double_approx_quantiles(value, array[0, 0.5, 1]) as min_median_max
+  from generate_series(1, 100) as t(value);
+
 drop table quantiles_sketch_test;
 drop extension datasketches;
@@ -25,5 +25,9 @@ select req_float_sketch_get_quantile(req_float_sketch_merge(sketch), 0.5) as med
 -- k = 20, rank of value 6
 select req_float_sketch_get_rank(req_float_sketch_merge(sketch, 20), 6) as rank from req_sketch_test;
 
+-- quantiles straight from the aggregate state
+select req_float_approx_quantile(value::real, 0.5) as median, req_float_approx_quantiles(value::real, array[0, 0.5, 1]) as min_median_max
+  from generate_series(1, 100) as t(value);
+
 drop table req_sketch_test;
 drop extension datasketches;
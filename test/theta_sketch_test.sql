@@ -21,13 +21,73 @@ select theta_sketch_get_estimate(sketch) from theta_sketch_test;
 
 -- default lgk
 select theta_sketch_get_estimate(theta_sketch_union(sketch)) from theta_sketch_test;
+select theta_sketch_union_distinct(sketch) from theta_sketch_test;
 -- lgk = 16
 select theta_sketch_get_estimate(theta_sketch_union(sketch, 16)) from theta_sketch_test;
 
 select theta_sketch_get_estimate(theta_sketch_intersection(sketch)) from theta_sketch_test;
 
+-- sort-based grouping, sketches and unions are reused across groups
+set enable_hashagg = off;
+select value % 3, theta_sketch_distinct(value) from generate_series(1, 30) as value group by value % 3 order by 1;
+select grp, theta_sketch_get_estimate(theta_sketch_union(sketch)) from (
+  select value % 3 as grp, theta_sketch_build(value) as sketch from generate_series(1, 30) as value group by value
+) as t group by grp order by grp;
+reset enable_hashagg;
+
+-- past the memory budget new groups get smaller sketches, small groups stay exact
+set datasketches.agg_memory_budget = '64kB';
+select count(*), sum(estimate) from (
+  select theta_sketch_get_estimate(theta_sketch_build(value, 16)) as estimate
+  from generate_series(1, 20000) as value group by value % 2000
+) as t;
+reset datasketches.agg_memory_budget;
+
 select theta_sketch_get_estimate(theta_sketch_a_not_b(theta_sketch_build(value1), theta_sketch_build(value2)))
 from (values (1, 2), (2, 3), (3, 4)) as t(value1, value2);
 
+-- running distinct count, the final function leaves the state for the next row
+select value, theta_sketch_distinct(value % 4) over (order by value) as running_distinct,
+  theta_sketch_get_estimate(theta_sketch_build(value % 4) over (order by value)) as running_estimate
+from generate_series(1, 8) as value;
+
+-- distinct count over a sliding frame, the sketches leaving the frame are removed from the state
+select value, theta_sketch_get_estimate(theta_sketch_union(sketch) over (order by value rows between 2 preceding and current row)) as distinct_last_3
+from (select value, theta_sketch_build(item) as sketch from generate_series(1, 8) as value, generate_series(value, value + 9) as item group by value) as t;
+
+-- nested unions pass the union along without serializing the intermediate results
+select theta_sketch_get_estimate(theta_sketch_union(theta_sketch_union(theta_sketch_build(1), theta_sketch_build(2)), theta_sketch_union(theta_sketch_build(2), theta_sketch_build(3))));
+
+-- set operations on arrays of sketches
+select theta_sketch_get_estimate(theta_sketch_union(array[theta_sketch_build(1), theta_sketch_build(2), null, theta_sketch_build(2)]));
+select theta_sketch_get_estimate(theta_sketch_union(array_agg(sketch), 5)) from (select theta_sketch_build(item) as sketch from generate_series(1, 10) as value, generate_series(value * 100, value * 100 + 99) as item group by value) as t;
+select theta_sketch_get_estimate(theta_sketch_intersection(array_agg(sketch))) from (select theta_sketch_build(item) as sketch from generate_series(1, 3) as value, generate_series(value, value + 9) as item group by value) as t;
+
+-- set expression over an array of sketches: (1..10 | 6..15) & 3..12 - 11..20 is 3..10
+select theta_sketch_eval_estimate('(A | B) & C - D', array[theta_sketch_build(a), theta_sketch_build(b), theta_sketch_build(c), theta_sketch_build(d)])
+from (select generate_series(1, 10) as a, generate_series(6, 15) as b, generate_series(3, 12) as c, generate_series(11, 20) as d) as t;
+select theta_sketch_get_estimate(theta_sketch_eval('$2 & $1', array[theta_sketch_build(1), theta_sketch_build(1)]));
+-- deep nesting is an error rather than a stack overflow
+select theta_sketch_eval_estimate(repeat('(', 1000000) || 'A' || repeat(')', 1000000), array[theta_sketch_build(1)]);
+
+-- estimates of set operations without building the results: 1..10 and 6..15
+select theta_sketch_union_estimate(theta_sketch_build(a), theta_sketch_build(b)), theta_sketch_intersection_estimate(theta_sketch_build(a), theta_sketch_build(b)),
+  theta_sketch_a_not_b_estimate(theta_sketch_build(a), theta_sketch_build(b)), theta_sketch_jaccard(theta_sketch_build(a), theta_sketch_build(b))
+from (select generate_series(1, 10) as a, generate_series(6, 15) as b) as t;
+select theta_sketch_union_estimate(theta_sketch_build(a), theta_sketch_build(b), 5) from (select generate_series(1, 100) as a, generate_series(51, 150) as b) as t;
+
+-- pairwise intersection estimates: 1..10, 6..15 and 11..20
+select theta_sketch_overlap_matrix(array[theta_sketch_build(a), theta_sketch_build(b), theta_sketch_build(c)])
+from (select generate_series(1, 10) as a, generate_series(6, 15) as b, generate_series(11, 20) as c) as t;
+select theta_sketch_overlap_matrix(array[theta_sketch_build(1), null], 2);
+
+-- build from hashes computed once per item
+select datasketches_hash(repeat('a', 100000)) = datasketches_hash(repeat('a', 99999) || 'a');
+select theta_sketch_get_estimate(theta_sketch_build_from_hash(datasketches_hash(value))) from generate_series(1, 100) as value;
+
+-- batches of little-endian hashes 1, 2 and 3, the same as those of the build-from-hash aggregate
+select theta_sketch_get_estimate(theta_sketch_update_packed(null, '\x010000000000000002000000000000000300000000000000'::bytea));
+select theta_sketch_get_estimate(theta_sketch_union(theta_sketch_update_packed(theta_sketch_build_from_hash(value), '\x0300000000000000'::bytea), theta_sketch_build_from_hash(value))) from generate_series(1, 3) as value;
+
 drop table theta_sketch_test;
 drop extension datasketches;